@@ -0,0 +1,212 @@
+#ifndef ANGULAR_INDEX_H
+#define ANGULAR_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "fourmom.h"
+
+// Azimuthal difference folded into [-pi, pi], so particles either side of phi = +-pi count as neighbours
+inline double delta_phi(double phi1, double phi2)
+{
+  return std::remainder(phi1 - phi2, 2 * M_PI);
+}
+
+inline double delta_r(double eta1, double phi1, double eta2, double phi2)
+{
+  return std::hypot(eta1 - eta2, delta_phi(phi1, phi2));
+}
+
+// Fixed grid over pseudorapidity and azimuth for cone and nearest-neighbour queries. Cells are about one cone radius
+// on a side, so a cone query reads the 3x3 cells around it instead of every particle; phi cells wrap around and
+// particles beyond |eta| = eta_max share the edge cells. Built once from a set of points and immutable afterwards.
+template<typename Id>
+class AngularIndex
+{
+public:
+  struct Point
+  {
+    double eta;
+    double phi;
+    double pt;
+    Id id;
+  };
+
+  struct Neighbour
+  {
+    Id id;
+    double delta_r;
+  };
+
+  static Point point(const FourMomentum& momentum, Id id)
+  {
+    return Point{momentum.pseudorapidity(), momentum.azimuth(), momentum.transverse_momentum(), id};
+  }
+
+private:
+  double eta_max;
+  double eta_cell;
+  double phi_cell;
+  int eta_cells;
+  int phi_cells;
+  std::vector<Point> points; // Grouped by cell
+  std::vector<std::uint32_t> cell_start; // points[cell_start[c], cell_start[c + 1]) lie in cell c
+
+  int eta_bin(double eta) const { return std::clamp(static_cast<int>(std::floor((eta + eta_max) / eta_cell)), 0, eta_cells - 1); }
+  int phi_bin(double phi) const
+  {
+    int bin = static_cast<int>(std::floor((phi + M_PI) / phi_cell)) % phi_cells;
+    return bin < 0 ? bin + phi_cells : bin;
+  }
+  int cell(int eta_bin, int phi_bin) const { return eta_bin * phi_cells + phi_bin; }
+
+  // Calls f(point, delta_r) for every point in cell (e, p) within 'radius', p taken modulo phi_cells
+  template<typename F>
+  void scan_cell(int e, int p, double eta, double phi, double radius, F& f) const
+  {
+    int c = cell(e, ((p % phi_cells) + phi_cells) % phi_cells);
+    for(std::uint32_t i = cell_start[c]; i < cell_start[c + 1]; ++i)
+    {
+      double dr = delta_r(eta, phi, points[i].eta, points[i].phi);
+      if(dr < radius)
+      {
+        f(points[i], dr);
+      }
+    }
+  }
+
+public:
+  explicit AngularIndex(std::vector<Point> input, double cell_size = 0.4, double eta_max = 5.0)
+    : eta_max(eta_max)
+  {
+    eta_cells = std::max(1, static_cast<int>(std::ceil(2 * eta_max / cell_size)));
+    eta_cell = 2 * eta_max / eta_cells;
+    phi_cells = std::max(1, static_cast<int>(std::floor(2 * M_PI / cell_size)));
+    phi_cell = 2 * M_PI / phi_cells;
+
+    // Counting sort into cells
+    std::vector<int> cells(input.size());
+    cell_start.assign(static_cast<std::size_t>(eta_cells) * phi_cells + 1, 0);
+    for(std::size_t i = 0; i < input.size(); ++i)
+    {
+      cells[i] = cell(eta_bin(input[i].eta), phi_bin(input[i].phi));
+      cell_start[cells[i] + 1]++;
+    }
+    for(std::size_t c = 1; c < cell_start.size(); ++c)
+    {
+      cell_start[c] += cell_start[c - 1];
+    }
+    std::vector<std::uint32_t> next(cell_start.begin(), cell_start.end() - 1);
+    points.resize(input.size());
+    for(std::size_t i = 0; i < input.size(); ++i)
+    {
+      points[next[cells[i]]++] = std::move(input[i]);
+    }
+  }
+
+  std::size_t size() const { return points.size(); }
+
+  // Calls f(point, delta_r) for every point with delta_r < radius of (eta, phi), in no particular order
+  template<typename F>
+  void for_each_in_cone(double eta, double phi, double radius, F f) const
+  {
+    int e_low = eta_bin(eta - radius), e_high = eta_bin(eta + radius);
+    int p = phi_bin(phi);
+    int span = static_cast<int>(std::ceil(radius / phi_cell));
+    int p_low = p - span, p_high = p + span;
+    if(p_high - p_low + 1 >= phi_cells)
+    { // The cone spans every phi cell; visit each once
+      p_low = 0;
+      p_high = phi_cells - 1;
+    }
+    for(int e = e_low; e <= e_high; ++e)
+    {
+      for(int q = p_low; q <= p_high; ++q)
+      {
+        scan_cell(e, q, eta, phi, radius, f);
+      }
+    }
+  }
+
+  std::vector<Neighbour> cone(double eta, double phi, double radius) const
+  {
+    std::vector<Neighbour> found;
+    for_each_in_cone(eta, phi, radius, [&found](const Point& point, double dr) { found.push_back(Neighbour{point.id, dr}); });
+    return found;
+  }
+
+  std::vector<Neighbour> cone(const FourMomentum& axis, double radius) const
+  {
+    return cone(axis.pseudorapidity(), axis.azimuth(), radius);
+  }
+
+  // The k points nearest (eta, phi), closest first. Searches rings of cells outwards from the query's cell and stops
+  // once the next ring cannot hold anything closer than the k-th point found so far.
+  std::vector<Neighbour> nearest(double eta, double phi, std::size_t k) const
+  {
+    auto farther = [](const Neighbour& a, const Neighbour& b) { return a.delta_r < b.delta_r; };
+    std::priority_queue<Neighbour, std::vector<Neighbour>, decltype(farther)> best(farther); // Max-heap of the k closest
+    if(k == 0)
+    {
+      return {};
+    }
+
+    int e0 = eta_bin(eta), p0 = phi_bin(phi);
+    int p_min = -((phi_cells - 1) / 2), p_max = phi_cells / 2; // Each phi cell has exactly one offset in this range
+    double min_cell = std::min(eta_cell, phi_cell);
+    auto keep = [&](const Point& point, double dr)
+    {
+      if(best.size() < k)
+      {
+        best.push(Neighbour{point.id, dr});
+      }
+      else if(dr < best.top().delta_r)
+      {
+        best.pop();
+        best.push(Neighbour{point.id, dr});
+      }
+    };
+
+    int last_ring = std::max(eta_cells, phi_cells);
+    for(int r = 0; r <= last_ring; ++r)
+    {
+      if(best.size() == k && (r - 1) * min_cell > best.top().delta_r)
+      {
+        break; // Every cell in ring r is at least r - 1 whole cells away
+      }
+      for(int de = -r; de <= r; ++de)
+      {
+        int e = e0 + de;
+        if(e < 0 || e >= eta_cells)
+        {
+          continue;
+        }
+        for(int dp = std::max(-r, p_min); dp <= std::min(r, p_max); ++dp)
+        {
+          if(std::max(std::abs(de), std::abs(dp)) == r)
+          {
+            scan_cell(e, p0 + dp, eta, phi, HUGE_VAL, keep);
+          }
+        }
+      }
+    }
+
+    std::vector<Neighbour> found(best.size());
+    for(std::size_t i = found.size(); i-- > 0; best.pop())
+    {
+      found[i] = best.top();
+    }
+    return found;
+  }
+
+  std::vector<Neighbour> nearest(const FourMomentum& axis, std::size_t k) const
+  {
+    return nearest(axis.pseudorapidity(), axis.azimuth(), k);
+  }
+};
+
+#endif // ANGULAR_INDEX_H
@@ -0,0 +1,342 @@
+// Throughput benchmarks for the particle catalogue.
+// Decay output is redirected away from the terminal so only the generation cost is timed.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lepton.h"
+#include "bosons.h"
+#include "particle.h"
+#include "fourmom_block.h"
+#include "decay_engine.h"
+#include "particle_catalogue.h"
+#include "concurrent_particle_catalogue.h"
+#include "catalogue_export.h"
+#include "particle_factory.h"
+#include "thread_pool.h"
+
+// Times 'count' decays of freshly created particles made by 'make' and prints the throughput. With an 'arena', each
+// decay is an event whose products come from the arena, released once the event's particles are gone.
+template<typename MakeParticle>
+void benchmark_decays(const std::string& name, int count, MakeParticle make, EventArena* arena = nullptr)
+{
+  std::ostringstream sink;
+  auto old_cout = std::cout.rdbuf(sink.rdbuf());
+  auto old_cerr = std::cerr.rdbuf(sink.rdbuf());
+
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < count; ++i)
+  {
+    {
+      auto particle = make();
+      particle->decay();
+    }
+    if(arena)
+    {
+      arena->release();
+    }
+    sink.str("");
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout.rdbuf(old_cout);
+  std::cerr.rdbuf(old_cerr);
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout<<std::left<<std::setw(12)<<name<<std::right<<std::setw(10)<<count<<" decays  "
+           <<std::fixed<<std::setprecision(3)<<std::setw(10)<<seconds * 1e6 / count<<" us/decay  "
+           <<std::setprecision(0)<<std::setw(12)<<count / seconds<<" decays/s\n";
+}
+
+void benchmark_decay_throughput(int count)
+{
+  std::cout<<"Decay throughput:\n";
+  benchmark_decays("W+", count, []{ return std::make_shared<WBoson>(1, 10, 76, 82); });
+  benchmark_decays("ZBoson", count, []{ return std::make_shared<ZBoson>(190, 423, 780); });
+  benchmark_decays("HiggsBoson", count, []{ return std::make_shared<HiggsBoson>(200, 300, 900); });
+  benchmark_decays("Tau", count, []{ return std::make_shared<Tau>(24, 256, 34, false); });
+}
+
+void benchmark_arena_decay_throughput(int count)
+{
+  std::cout<<"Decay throughput, products in an EventArena:\n";
+  EventArena arena;
+  benchmark_decays("W+", count, []{ return std::make_shared<WBoson>(1, 10, 76, 82); }, &arena);
+  benchmark_decays("ZBoson", count, []{ return std::make_shared<ZBoson>(190, 423, 780); }, &arena);
+  benchmark_decays("HiggsBoson", count, []{ return std::make_shared<HiggsBoson>(200, 300, 900); }, &arena);
+  benchmark_decays("Tau", count, []{ return std::make_shared<Tau>(24, 256, 34, false); }, &arena);
+}
+
+// Same as benchmark_decays, but all 'count' particles are decayed by one DecayEngine::decay_batch call
+template<typename MakeParticle>
+void benchmark_batch_decays(const std::string& name, int count, MakeParticle make)
+{
+  std::vector<decltype(make())> particles;
+  particles.reserve(count);
+  for(int i = 0; i < count; ++i)
+  {
+    particles.push_back(make());
+  }
+
+  std::ostringstream sink;
+  auto old_cout = std::cout.rdbuf(sink.rdbuf());
+  auto old_cerr = std::cerr.rdbuf(sink.rdbuf());
+
+  auto start = std::chrono::steady_clock::now();
+  DecayEngine engine;
+  engine.decay_batch(particles);
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout.rdbuf(old_cout);
+  std::cerr.rdbuf(old_cerr);
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout<<std::left<<std::setw(12)<<name<<std::right<<std::setw(10)<<count<<" decays  "
+           <<std::fixed<<std::setprecision(3)<<std::setw(10)<<seconds * 1e6 / count<<" us/decay  "
+           <<std::setprecision(0)<<std::setw(12)<<count / seconds<<" decays/s\n";
+}
+
+void benchmark_batch_decay_throughput(int count)
+{
+  std::cout<<"Batch decay throughput:\n";
+  benchmark_batch_decays("W+", count, []{ return std::make_shared<WBoson>(1, 10, 76, 82); });
+  benchmark_batch_decays("ZBoson", count, []{ return std::make_shared<ZBoson>(190, 423, 780); });
+  benchmark_batch_decays("HiggsBoson", count, []{ return std::make_shared<HiggsBoson>(200, 300, 900); });
+  benchmark_batch_decays("Tau", count, []{ return std::make_shared<Tau>(24, 256, 34, false); });
+}
+
+// Discards everything written to it; it holds no state, so worker threads can share it safely
+class NullBuffer : public std::streambuf
+{
+protected:
+  int overflow(int c) override { return c; }
+};
+
+// Times ParticleCatalogue::decay_all on catalogues of 'count' W, Z, Higgs and tau each, for several pool sizes
+void benchmark_parallel_decays(int count)
+{
+  std::cout<<"Catalogue decay_all ("<<4 * count<<" parents):\n";
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for(std::size_t threads = 1; ; threads = std::min(threads * 2, max_threads))
+  {
+    ParticleCatalogue<Particle> catalogue;
+    for(int i = 0; i < count; ++i)
+    {
+      catalogue.add_particle(std::make_shared<WBoson>(1, 10, 76, 82));
+      catalogue.add_particle(std::make_shared<ZBoson>(190, 423, 780));
+      catalogue.add_particle(std::make_shared<HiggsBoson>(200, 300, 900));
+      catalogue.add_particle(std::make_shared<Tau>(24, 256, 34, false));
+    }
+    ThreadPool pool(threads);
+
+    NullBuffer sink;
+    auto old_cout = std::cout.rdbuf(&sink);
+    auto old_cerr = std::cerr.rdbuf(&sink);
+    auto start = std::chrono::steady_clock::now();
+    catalogue.decay_all(pool);
+    auto end = std::chrono::steady_clock::now();
+    std::cout.rdbuf(old_cout);
+    std::cerr.rdbuf(old_cerr);
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout<<std::setw(4)<<threads<<" threads  "<<std::fixed<<std::setprecision(3)<<std::setw(10)<<seconds * 1e3<<" ms  "
+             <<std::setprecision(0)<<std::setw(12)<<4 * count / seconds<<" decays/s\n";
+    if(threads == max_threads)
+    {
+      break;
+    }
+  }
+}
+
+// Times 'threads' generator threads filling one ConcurrentParticleCatalogue with 'count' particles between them,
+// cycling through the species so every shard sees traffic from every thread
+void benchmark_concurrent_inserts(int count)
+{
+  std::cout<<"Concurrent catalogue inserts ("<<count<<" particles):\n";
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for(std::size_t threads = 1; threads <= std::max<std::size_t>(max_threads, 4); threads *= 2)
+  {
+    ConcurrentParticleCatalogue<Particle> catalogue;
+    std::vector<std::thread> generators;
+    NullBuffer sink; // Electrons warn about their calorimeter deposits
+    auto old_cout = std::cout.rdbuf(&sink);
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t t = 0; t < threads; ++t)
+    {
+      generators.emplace_back([&catalogue, t, threads, count]
+      {
+        for(std::size_t i = t; i < static_cast<std::size_t>(count); i += threads)
+        {
+          switch(i % 4)
+          {
+            case 0: create_add_particle<Electron>(catalogue, 1.0, 2.0, 3.0, std::vector<double>{0.1, 0.2, 0.15, 0.05}, false); break;
+            case 1: create_add_particle<Muon>(catalogue, 454, 2546, 46, false, true); break;
+            case 2: create_add_particle<Photon>(catalogue, 105, 407, 7); break;
+            default: create_add_particle<ZBoson>(catalogue, 190, 423, 780); break;
+          }
+        }
+      });
+    }
+    for(auto& generator : generators)
+    {
+      generator.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout.rdbuf(old_cout);
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout<<std::setw(4)<<threads<<" threads  "<<std::fixed<<std::setprecision(3)<<std::setw(10)<<seconds * 1e3<<" ms  "
+             <<std::setprecision(0)<<std::setw(12)<<catalogue.size() / seconds<<" inserts/s\n";
+  }
+}
+
+// Times 'repeats' calls of 'kernel' over 'count' momenta and prints the rate in momenta per second
+template<typename Kernel>
+void benchmark_kernel(const std::string& name, std::size_t count, int repeats, Kernel kernel)
+{
+  auto start = std::chrono::steady_clock::now();
+  double checksum = 0;
+  for(int i = 0; i < repeats; ++i)
+  {
+    checksum += kernel();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout<<std::left<<std::setw(28)<<name<<std::right<<std::fixed<<std::setprecision(1)<<std::setw(10)
+           <<count * repeats / seconds / 1e6<<" M momenta/s  (checksum "<<std::setprecision(0)<<checksum<<")\n";
+}
+
+void benchmark_kinematics(std::size_t count)
+{
+  std::vector<FourMomentum> momenta;
+  FourMomentumBlock block(count);
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    double px = 0.1 * (i % 1000), py = 0.2 * (i % 333), pz = 0.3 * (i % 77);
+    double E = std::sqrt(px * px + py * py + pz * pz + 1e4);
+    momenta.emplace_back(E, px, py, pz);
+    block.push_back(E, px, py, pz);
+  }
+  std::vector<double> out(count);
+
+  std::cout<<"Kinematic kernels over "<<count<<" momenta:\n";
+  benchmark_kernel("sum (FourMomentum loop)", count, 20, [&]{
+    FourMomentum total(0, 0, 0, 0);
+    for(const auto& momentum : momenta)
+    {
+      total = total + momentum;
+    }
+    return total.get_e();
+  });
+  benchmark_kernel("sum (FourMomentumBlock)", count, 20, [&]{ return block.sum().get_e(); });
+  benchmark_kernel("invariant mass (scalar)", count, 20, [&]{
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      out[i] = momenta[i].invariant_mass();
+    }
+    return out[count / 2];
+  });
+  benchmark_kernel("invariant mass (block)", count, 20, [&]{ invariant_mass(block, out.data()); return out[count / 2]; });
+  benchmark_kernel("pT (block)", count, 20, [&]{ transverse_momentum(block, out.data()); return out[count / 2]; });
+  benchmark_kernel("eta (block)", count, 20, [&]{ pseudorapidity(block, out.data()); return out[count / 2]; });
+  benchmark_kernel("phi (block)", count, 20, [&]{ azimuth(block, out.data()); return out[count / 2]; });
+}
+
+// Times print_all and sum_all on a decayed catalogue of 'count' W, Z, Higgs and tau each, written to memory
+void benchmark_print_all(int count)
+{
+  ParticleCatalogue<Particle> catalogue;
+  for(int i = 0; i < count; ++i)
+  {
+    catalogue.add_particle(std::make_shared<WBoson>(1, 10, 76, 82));
+    catalogue.add_particle(std::make_shared<ZBoson>(190, 423, 780));
+    catalogue.add_particle(std::make_shared<HiggsBoson>(200, 300, 900));
+    catalogue.add_particle(std::make_shared<Tau>(24, 256, 34, false));
+  }
+  ThreadPool pool;
+  NullBuffer sink;
+  auto old_cout = std::cout.rdbuf(&sink);
+  auto old_cerr = std::cerr.rdbuf(&sink);
+  catalogue.decay_all(pool);
+  std::cout.rdbuf(old_cout);
+  std::cerr.rdbuf(old_cerr);
+
+  std::ostringstream text;
+  auto start = std::chrono::steady_clock::now();
+  catalogue.print_all(text);
+  catalogue.sum_all(text);
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout<<"Catalogue print_all ("<<4 * count<<" parents): "<<std::fixed<<std::setprecision(3)<<seconds * 1e3<<" ms  "
+           <<std::setprecision(1)<<text.str().size() / seconds / 1e6<<" MB/s\n";
+}
+
+// Times generating and decaying 'count' W, Z, Higgs and tau each, alone and while streaming every tree to an export
+// file, so the difference is what the writer thread costs the generator
+void benchmark_streaming_export(int count)
+{
+  std::cout<<"Generation with streaming export ("<<4 * count<<" parents):\n";
+  const char* path = "benchmark_export.tmp";
+  const char* names[] = {"none", "columnar", "JSON Lines", "CSV"};
+  for(int format = -1; format < 3; ++format)
+  {
+    CatalogueExporter exporter;
+    if(format >= 0 && !exporter.open(path, static_cast<ExportFormat>(format)))
+    {
+      std::cerr<<"Error opening "<<path<<" for writing."<<std::endl;
+      return;
+    }
+    NullBuffer sink;
+    auto old_cout = std::cout.rdbuf(&sink);
+    auto old_cerr = std::cerr.rdbuf(&sink);
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < count; ++i)
+    {
+      std::shared_ptr<Particle> parents[] = {std::make_shared<WBoson>(1, 10, 76, 82), std::make_shared<ZBoson>(190, 423, 780),
+                                             std::make_shared<HiggsBoson>(200, 300, 900), std::make_shared<Tau>(24, 256, 34, false)};
+      for(const auto& parent : parents)
+      {
+        parent->decay();
+        if(format >= 0)
+        {
+          exporter.write(*parent);
+        }
+      }
+    }
+    auto generated = std::chrono::steady_clock::now();
+    exporter.close();
+    auto end = std::chrono::steady_clock::now();
+    std::cout.rdbuf(old_cout);
+    std::cerr.rdbuf(old_cerr);
+
+    double seconds = std::chrono::duration<double>(generated - start).count();
+    std::cout<<std::left<<std::setw(12)<<names[format + 1]<<std::right<<std::fixed<<std::setprecision(3)<<std::setw(10)
+             <<seconds * 1e3<<" ms generating  "<<std::setw(10)<<std::chrono::duration<double>(end - generated).count() * 1e3
+             <<" ms draining\n";
+  }
+  std::remove(path);
+}
+
+int main(int argc, char* argv[])
+{
+  int count = argc > 1 ? std::stoi(argv[1]) : 20000;
+  benchmark_decay_throughput(count);
+  benchmark_arena_decay_throughput(count);
+  benchmark_batch_decay_throughput(count);
+  benchmark_parallel_decays(count);
+  benchmark_concurrent_inserts(10 * count);
+  benchmark_kinematics(1000000);
+  benchmark_print_all(count);
+  benchmark_streaming_export(count);
+  return 0;
+}
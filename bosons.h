@@ -9,7 +9,7 @@
 class Boson : public Particle
 {
 public:
-  Boson(double mass, double charge, double spin, double px, double py, double pz, const std::string& type);
+  Boson(double px, double py, double pz, Species species);
   Boson(const Boson& other, bool copy_decay_products = true); // Copy constructor
   Boson(Boson&& other) noexcept; // Move constructor
   Boson& operator=(const Boson& other); // Copy assignment operator
@@ -17,7 +17,7 @@ public:
   virtual ~Boson() = default;
 
   virtual void decay() override = 0;
-  virtual void print() const override;
+  virtual void format_properties(TextFormatter& out) const override;
 
 };
 
@@ -32,7 +32,7 @@ public:
   virtual ~Photon() = default;
 
   void decay() override;
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
 
   std::shared_ptr<Particle> clone() const override;
 };
@@ -40,7 +40,7 @@ public:
 class WBoson : public Boson
 {
 private:
-  static constexpr double W_mass = 80377;
+  static constexpr double W_mass = species_descriptor(Species::WPlus).mass;
   double borrowed_energy;
   std::string decay_type;
 
@@ -53,7 +53,8 @@ public:
   virtual ~WBoson() = default;
 
   void decay() override;
-  void print() const override;
+  void set_decay_channel(const DecayChannel& channel) override;
+  void format_properties(TextFormatter& out) const override;
   static constexpr double get_W_mass();
 
   std::shared_ptr<Particle> clone() const override;
@@ -62,7 +63,7 @@ public:
 class ZBoson : public Boson
 {
 private:
-  static constexpr double Z_mass = 91187.6;
+  static constexpr double Z_mass = species_descriptor(Species::ZBoson).mass;
   double borrowed_energy;
   std::string decay_type;
 
@@ -75,7 +76,8 @@ public:
   virtual ~ZBoson() = default;
 
   void decay() override;
-  void print() const override;
+  void set_decay_channel(const DecayChannel& channel) override;
+  void format_properties(TextFormatter& out) const override;
   static constexpr double get_Z_mass();
 
   std::shared_ptr<Particle> clone() const override;
@@ -84,7 +86,6 @@ public:
 class HiggsBoson : public Boson
 {
 private:
-  static constexpr double higgs_mass = 125110;
   std::string decay_type;
 
 public:
@@ -96,7 +97,8 @@ public:
   virtual ~HiggsBoson() = default;
 
   void decay() override;
-  void print() const override;
+  void set_decay_channel(const DecayChannel& channel) override;
+  void format_properties(TextFormatter& out) const override;
 
   std::shared_ptr<Particle> clone() const override;
 };
@@ -116,7 +118,7 @@ public:
   virtual ~Gluon() override = default;  // Destructor
 
   void decay() override;
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
 
   std::shared_ptr<Particle> clone() const override;
 
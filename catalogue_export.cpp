@@ -0,0 +1,316 @@
+#include "catalogue_export.h"
+#include "species.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+  void append_number(std::string& out, double value)
+  {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value); // Shortest round-trip form
+    out.append(digits, result.ptr);
+  }
+
+  void append_number(std::string& out, long long value)
+  {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+  }
+
+  template<typename Value>
+  void append_raw(std::string& out, const Value& value)
+  {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void pad8(std::string& out)
+  {
+    out.append((8 - out.size() % 8) % 8, '\0');
+  }
+
+  class ColumnarEncoder : public ExportEncoder
+  {
+  public:
+    static constexpr char magic[8] = {'P', 'C', 'A', 'T', 'C', 'O', 'L', 'S'};
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+    void begin(std::string& out) override
+    {
+      out.append(magic, sizeof(magic));
+      append_raw(out, version);
+      append_raw(out, byte_order_mark);
+    }
+
+    void encode(const ExportBlock& block, std::string& out) override
+    {
+      // Every piece is a multiple of 8 bytes, so padding to the block start keeps each column aligned in the file
+      out.reserve(out.size() + 16 + block.size() * (4 * sizeof(double) + 2 * sizeof(std::uint32_t) + 2) + 32);
+      append_raw(out, static_cast<std::uint64_t>(block.roots.size()));
+      append_raw(out, static_cast<std::uint64_t>(block.size()));
+      for(const ParticleRecord& record : block.records) { append_raw(out, record.momentum.get_e()); }
+      for(const ParticleRecord& record : block.records) { append_raw(out, record.momentum.get_px()); }
+      for(const ParticleRecord& record : block.records) { append_raw(out, record.momentum.get_py()); }
+      for(const ParticleRecord& record : block.records) { append_raw(out, record.momentum.get_pz()); }
+      for(std::uint32_t root : block.roots)
+      {
+        std::uint32_t end = root + 1 + block.records[root].descendant_count;
+        for(std::uint32_t i = root; i < end; ++i)
+        {
+          std::uint32_t parent = block.records[i].parent;
+          append_raw(out, parent == ParticleRecord::no_index ? parent : root + parent);
+        }
+      }
+      pad8(out);
+      for(const ParticleRecord& record : block.records) { append_raw(out, record.descendant_count); }
+      pad8(out);
+      for(const ParticleRecord& record : block.records) { out.push_back(static_cast<char>(record.species)); }
+      pad8(out);
+      for(const ParticleRecord& record : block.records) { out.push_back(static_cast<char>(record.flags)); }
+      pad8(out);
+    }
+  };
+
+  class JsonLinesEncoder : public ExportEncoder
+  {
+  private:
+    std::vector<std::uint32_t> open_ends; // End of each decay_products array still open
+
+  public:
+    void encode(const ExportBlock& block, std::string& out) override
+    {
+      for(std::uint32_t root : block.roots)
+      {
+        std::uint32_t end = root + 1 + block.records[root].descendant_count;
+        bool first_in_array = true;
+        for(std::uint32_t i = root; i < end; ++i)
+        {
+          const ParticleRecord& record = block.records[i];
+          if(i != root && !first_in_array)
+          {
+            out.push_back(',');
+          }
+          out.append("{\"species\":\"");
+          out.append(species_name(record.species));
+          out.append("\",\"pdg\":");
+          append_number(out, static_cast<long long>(pdg_code(record.species)));
+          out.append(",\"e\":");
+          append_number(out, record.momentum.get_e());
+          out.append(",\"px\":");
+          append_number(out, record.momentum.get_px());
+          out.append(",\"py\":");
+          append_number(out, record.momentum.get_py());
+          out.append(",\"pz\":");
+          append_number(out, record.momentum.get_pz());
+          if(record.descendant_count > 0)
+          {
+            out.append(",\"decay_products\":[");
+            open_ends.push_back(i + 1 + record.descendant_count);
+            first_in_array = true;
+            continue;
+          }
+          out.push_back('}');
+          first_in_array = false;
+          while(!open_ends.empty() && open_ends.back() == i + 1)
+          {
+            out.append("]}");
+            open_ends.pop_back();
+          }
+        }
+        out.push_back('\n');
+      }
+    }
+  };
+
+  class CsvEncoder : public ExportEncoder
+  {
+  private:
+    long long event = 0; // Base particles written so far, across blocks
+
+  public:
+    void begin(std::string& out) override
+    {
+      out.append("event,node,parent,species,pdg,e,px,py,pz\n");
+    }
+
+    void encode(const ExportBlock& block, std::string& out) override
+    {
+      for(std::uint32_t root : block.roots)
+      {
+        std::uint32_t end = root + 1 + block.records[root].descendant_count;
+        for(std::uint32_t i = root; i < end; ++i)
+        {
+          const ParticleRecord& record = block.records[i];
+          append_number(out, event);
+          out.push_back(',');
+          append_number(out, static_cast<long long>(i - root));
+          out.push_back(',');
+          append_number(out, record.parent == ParticleRecord::no_index ? -1LL : static_cast<long long>(record.parent));
+          out.push_back(',');
+          out.append(species_name(record.species));
+          out.push_back(',');
+          append_number(out, static_cast<long long>(pdg_code(record.species)));
+          out.push_back(',');
+          append_number(out, record.momentum.get_e());
+          out.push_back(',');
+          append_number(out, record.momentum.get_px());
+          out.push_back(',');
+          append_number(out, record.momentum.get_py());
+          out.push_back(',');
+          append_number(out, record.momentum.get_pz());
+          out.push_back('\n');
+        }
+        event++;
+      }
+    }
+  };
+}
+
+void ExportEncoder::begin(std::string&)
+{
+}
+
+std::unique_ptr<ExportEncoder> make_export_encoder(ExportFormat format)
+{
+  switch(format)
+  {
+    case ExportFormat::Columnar: return std::make_unique<ColumnarEncoder>();
+    case ExportFormat::JsonLines: return std::make_unique<JsonLinesEncoder>();
+    default: return std::make_unique<CsvEncoder>();
+  }
+}
+
+CatalogueExporter::~CatalogueExporter()
+{
+  close();
+}
+
+bool CatalogueExporter::open(const std::string& path, ExportFormat format, std::size_t block_nodes)
+{
+  return open(path, make_export_encoder(format), block_nodes);
+}
+
+bool CatalogueExporter::open(const std::string& path, std::unique_ptr<ExportEncoder> new_encoder, std::size_t nodes)
+{
+  close();
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if(!file)
+  {
+    return false;
+  }
+  encoder = std::move(new_encoder);
+  block_nodes = std::max<std::size_t>(nodes, 1);
+  filling.records.reserve(block_nodes);
+  busy = false;
+  stopping = false;
+  failed = false;
+  writer = std::thread(&CatalogueExporter::writer_loop, this);
+  return true;
+}
+
+void CatalogueExporter::write(const DecayTreeArena& tree)
+{
+  if(tree.empty())
+  {
+    return;
+  }
+  filling.roots.push_back(static_cast<std::uint32_t>(filling.size()));
+  filling.records.insert(filling.records.end(), tree.records().begin(), tree.records().end());
+  if(filling.size() >= block_nodes)
+  {
+    hand_off();
+  }
+}
+
+void CatalogueExporter::write(const Particle& particle)
+{
+  filling.roots.push_back(static_cast<std::uint32_t>(filling.size()));
+  DecayTreeArena::append_records(particle, filling.records);
+  if(filling.size() >= block_nodes)
+  {
+    hand_off();
+  }
+}
+
+void CatalogueExporter::hand_off()
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return !busy; });
+    std::swap(filling, writing);
+    busy = true;
+  }
+  changed.notify_all();
+  filling.clear(); // The block the writer finished with, capacity kept
+}
+
+void CatalogueExporter::writer_loop()
+{
+  try
+  {
+    encoder->begin(encoded);
+  }
+  catch(const std::exception&)
+  {
+    failed = true;
+  }
+  while(true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [this] { return busy || stopping; });
+      if(!busy)
+      {
+        break;
+      }
+    }
+    try
+    {
+      encoder->encode(writing, encoded);
+    }
+    catch(const std::exception&)
+    {
+      failed = true;
+    }
+    file.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    encoded.clear();
+    writing.clear();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      busy = false;
+    }
+    changed.notify_all();
+  }
+  file.write(encoded.data(), static_cast<std::streamsize>(encoded.size())); // The header of an empty export
+  encoded.clear();
+}
+
+bool CatalogueExporter::close()
+{
+  if(!is_open())
+  {
+    return false;
+  }
+  if(!filling.records.empty())
+  {
+    hand_off();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  changed.notify_all();
+  writer.join();
+  file.close();
+  bool written = !failed && !file.fail();
+  filling = ExportBlock();
+  writing = ExportBlock();
+  encoder.reset();
+  return written;
+}
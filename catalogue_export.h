@@ -0,0 +1,123 @@
+#ifndef CATALOGUE_EXPORT_H
+#define CATALOGUE_EXPORT_H
+
+#include "decay_tree_arena.h"
+#include "particle.h"
+#include "particle_catalogue.h"
+#include "particle_record.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Machine-readable catalogue export for downstream tools.
+//
+// Columnar binary: an 8-byte "PCATCOLS" tag, uint32 version and uint32 byte-order mark, then blocks. Each block is
+// a uint64 particle count and uint64 node count followed by the columns e, px, py, pz (double), parent,
+// descendant_count (uint32), species and flags (uint8), each padded to 8 bytes. Nodes are base particles and their
+// decay products in pre-order as in CatalogueSnapshot; parents are node indices within the block, or
+// ParticleRecord::no_index for base particles. A decay tree never spans two blocks.
+//
+// JSON Lines: one object per base particle, {"species":..,"pdg":..,"e":..,"px":..,"py":..,"pz":..}, with a
+// "decay_products" array of the same objects for particles that decayed.
+//
+// CSV: a header line, then one row per node, "event,node,parent,species,pdg,e,px,py,pz". Events number the base
+// particles from 0, nodes number each decay tree in pre-order and the parent is -1 for the base particle.
+//
+// Numbers are written in the shortest form that reads back to the same double.
+
+enum class ExportFormat { Columnar, JsonLines, Csv };
+
+// Decay trees captured for export: the records of whole trees back to back, and where each tree starts
+struct ExportBlock
+{
+  std::vector<ParticleRecord> records; // Parents are indices within each tree, as in DecayTreeArena
+  std::vector<std::uint32_t> roots;
+
+  std::size_t size() const { return records.size(); }
+  void clear()
+  {
+    records.clear();
+    roots.clear();
+  }
+};
+
+// Turns blocks into bytes; one implementation per format, run only on the writer thread
+class ExportEncoder
+{
+public:
+  virtual ~ExportEncoder() = default;
+  virtual void begin(std::string& out); // Anything the file starts with
+  virtual void encode(const ExportBlock& block, std::string& out) = 0; // Appends to 'out'
+};
+
+std::unique_ptr<ExportEncoder> make_export_encoder(ExportFormat format);
+
+// Streams decay trees to a file. write() only copies a tree's records into the block being filled; a background
+// thread encodes and writes the other block. The calling thread waits only when it fills a block before the writer
+// has finished the previous one, so a generator that writes each particle as it is made keeps running while the
+// file is written.
+class CatalogueExporter
+{
+private:
+  std::size_t block_nodes = 0; // A block is handed to the writer once it holds this many nodes
+  std::unique_ptr<ExportEncoder> encoder;
+  std::ofstream file;
+  ExportBlock filling; // Owned by the calling thread
+  ExportBlock writing; // Owned by the writer thread while 'busy'
+  std::string encoded;
+  std::thread writer;
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool busy = false;
+  bool stopping = false;
+  bool failed = false;
+
+  void hand_off(); // Swaps 'filling' with 'writing' once the writer is free
+  void writer_loop();
+
+public:
+  CatalogueExporter() = default;
+  CatalogueExporter(const CatalogueExporter&) = delete;
+  CatalogueExporter& operator=(const CatalogueExporter&) = delete;
+  ~CatalogueExporter(); // Closes
+
+  // Returns false if the file cannot be opened
+  bool open(const std::string& path, ExportFormat format, std::size_t block_nodes = 1 << 16);
+  bool open(const std::string& path, std::unique_ptr<ExportEncoder> encoder, std::size_t block_nodes = 1 << 16);
+  bool is_open() const { return writer.joinable(); }
+
+  void write(const DecayTreeArena& tree);
+  void write(const Particle& particle); // Flattens its decay tree straight into the block
+
+  template<typename T>
+  void write(const ParticleCatalogue<T>& catalogue)
+  {
+    for(const T& particle : catalogue.all_particles())
+    {
+      write(particle);
+    }
+  }
+
+  // Writes what is left and waits for the writer; false if anything failed to be written
+  bool close();
+};
+
+template<typename T>
+bool export_catalogue(const ParticleCatalogue<T>& catalogue, const std::string& path, ExportFormat format)
+{
+  CatalogueExporter exporter;
+  if(!exporter.open(path, format))
+  {
+    return false;
+  }
+  exporter.write(catalogue);
+  return exporter.close();
+}
+
+#endif // CATALOGUE_EXPORT_H
@@ -0,0 +1,172 @@
+#ifndef CATALOGUE_INDEX_H
+#define CATALOGUE_INDEX_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+#include "fourmom.h"
+
+// Secondary indexes a ParticleCatalogue can be asked to maintain alongside its per-type buckets
+enum class ParticleIndex
+{
+  Energy,
+  TransverseMomentum,
+  InvariantMass,
+  Charge
+};
+
+constexpr std::size_t sorted_index_count = 3; // Energy, TransverseMomentum and InvariantMass are kept sorted
+
+inline double index_key(ParticleIndex index, const FourMomentum& momentum)
+{
+  switch(index)
+  {
+    case ParticleIndex::Energy: return momentum.get_e();
+    case ParticleIndex::TransverseMomentum: return momentum.transverse_momentum();
+    default: return momentum.invariant_mass();
+  }
+}
+
+// Slots ordered by one kinematic quantity. A balanced tree, so inserts, erases and re-keys are O(log n) and a range
+// query is O(log n + k). The current key of every slot is cached so an entry can be found again after the
+// particle's momentum has moved on.
+class SortedIndex
+{
+private:
+  std::set<std::pair<double, std::uint32_t>> entries;
+  std::vector<double> keys; // By slot; NaN when the slot is not indexed
+
+public:
+  void insert(std::uint32_t slot, double key)
+  {
+    if(slot >= keys.size())
+    {
+      keys.resize(slot + 1, std::numeric_limits<double>::quiet_NaN());
+    }
+    keys[slot] = key;
+    entries.emplace(key, slot);
+  }
+
+  void erase(std::uint32_t slot)
+  {
+    if(slot < keys.size() && !std::isnan(keys[slot]))
+    {
+      entries.erase({keys[slot], slot});
+      keys[slot] = std::numeric_limits<double>::quiet_NaN();
+    }
+  }
+
+  void update(std::uint32_t slot, double key)
+  {
+    erase(slot);
+    insert(slot, key);
+  }
+
+  void clear()
+  {
+    entries.clear();
+    keys.clear();
+  }
+
+  std::size_t size() const { return entries.size(); }
+
+  // Calls f(slot) for every slot with low <= key <= high, in increasing key order
+  template<typename F>
+  void for_each_in_range(double low, double high, F f) const
+  {
+    for(auto it = entries.lower_bound({low, 0}); it != entries.end() && it->first <= high; ++it)
+    {
+      f(it->second);
+    }
+  }
+};
+
+// One bitmap over slots per electric charge, in thirds of e from -1 to +1
+class ChargeBitmaps
+{
+private:
+  static constexpr std::size_t charge_count = 7;
+  std::array<std::vector<std::uint64_t>, charge_count> bitmaps;
+
+  static bool charge_bucket(double charge, std::size_t& bucket)
+  {
+    long thirds = std::lround(charge * 3);
+    if(thirds < -3 || thirds > 3)
+    {
+      return false;
+    }
+    bucket = static_cast<std::size_t>(thirds + 3);
+    return true;
+  }
+
+public:
+  void set(std::uint32_t slot, double charge)
+  {
+    std::size_t bucket;
+    if(charge_bucket(charge, bucket))
+    {
+      std::vector<std::uint64_t>& words = bitmaps[bucket];
+      if(slot / 64 >= words.size())
+      {
+        words.resize(slot / 64 + 1, 0);
+      }
+      words[slot / 64] |= std::uint64_t{1} << (slot % 64);
+    }
+  }
+
+  void reset(std::uint32_t slot)
+  {
+    for(std::vector<std::uint64_t>& words : bitmaps)
+    {
+      if(slot / 64 < words.size())
+      {
+        words[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+      }
+    }
+  }
+
+  bool test(std::uint32_t slot, double charge) const
+  {
+    std::size_t bucket;
+    if(!charge_bucket(charge, bucket))
+    {
+      return false;
+    }
+    const std::vector<std::uint64_t>& words = bitmaps[bucket];
+    return slot / 64 < words.size() && (words[slot / 64] >> (slot % 64) & 1);
+  }
+
+  void clear()
+  {
+    for(std::vector<std::uint64_t>& words : bitmaps)
+    {
+      words.clear();
+    }
+  }
+
+  // Calls f(slot) for every slot with the given charge, a 64-slot word at a time
+  template<typename F>
+  void for_each(double charge, F f) const
+  {
+    std::size_t bucket;
+    if(!charge_bucket(charge, bucket))
+    {
+      return;
+    }
+    const std::vector<std::uint64_t>& words = bitmaps[bucket];
+    for(std::size_t w = 0; w < words.size(); ++w)
+    {
+      for(std::uint64_t bits = words[w]; bits; bits &= bits - 1)
+      {
+        f(static_cast<std::uint32_t>(w * 64 + __builtin_ctzll(bits)));
+      }
+    }
+  }
+};
+
+#endif // CATALOGUE_INDEX_H
@@ -0,0 +1,245 @@
+#include "catalogue_snapshot.h"
+#include "particle.h"
+#include "particle_factory.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  std::uint64_t align8(std::uint64_t offset)
+  {
+    return (offset + 7) & ~std::uint64_t{7};
+  }
+}
+
+SnapshotLayout::SnapshotLayout(std::uint64_t particle_count, std::uint64_t node_count)
+{
+  std::uint64_t offset = align8(sizeof(SnapshotHeader));
+  auto place = [&offset](std::uint64_t bytes) { std::uint64_t start = offset; offset = align8(offset + bytes); return start; };
+  e = place(node_count * sizeof(double));
+  px = place(node_count * sizeof(double));
+  py = place(node_count * sizeof(double));
+  pz = place(node_count * sizeof(double));
+  parent = place(node_count * sizeof(std::uint32_t));
+  descendant_count = place(node_count * sizeof(std::uint32_t));
+  roots = place(particle_count * sizeof(std::uint32_t));
+  species = place(node_count);
+  flags = place(node_count);
+  file_size = offset;
+}
+
+void SnapshotWriter::append(const DecayTreeArena& tree)
+{
+  if(e.size() + tree.size() >= ParticleRecord::no_index)
+  {
+    throw std::invalid_argument("Snapshot node indices are 32-bit; too many particles for one snapshot.");
+  }
+  auto base = static_cast<std::uint32_t>(e.size());
+  roots.push_back(base);
+  for(const ParticleRecord& record : tree.records())
+  {
+    e.push_back(record.momentum.get_e());
+    px.push_back(record.momentum.get_px());
+    py.push_back(record.momentum.get_py());
+    pz.push_back(record.momentum.get_pz());
+    parent.push_back(record.parent == ParticleRecord::no_index ? ParticleRecord::no_index : base + record.parent);
+    descendant_count.push_back(record.descendant_count);
+    species.push_back(static_cast<std::uint8_t>(record.species));
+    flags.push_back(record.flags);
+  }
+}
+
+bool SnapshotWriter::write(const std::string& path) const
+{
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if(!file)
+  {
+    return false;
+  }
+
+  SnapshotLayout layout(roots.size(), e.size());
+  SnapshotHeader header{};
+  std::memcpy(header.magic, SnapshotHeader::expected_magic, sizeof(header.magic));
+  header.version = SnapshotHeader::current_version;
+  header.byte_order = SnapshotHeader::byte_order_mark;
+  header.particle_count = roots.size();
+  header.node_count = e.size();
+  header.file_size = layout.file_size;
+
+  // Columns are written in file order, each padded up to the next one's offset
+  std::uint64_t position = 0;
+  auto put = [&](std::uint64_t offset, const void* bytes, std::size_t size)
+  {
+    static const char padding[8] = {};
+    file.write(padding, static_cast<std::streamsize>(offset - position));
+    file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+    position = offset + size;
+  };
+  put(0, &header, sizeof(header));
+  put(layout.e, e.data(), e.size() * sizeof(double));
+  put(layout.px, px.data(), px.size() * sizeof(double));
+  put(layout.py, py.data(), py.size() * sizeof(double));
+  put(layout.pz, pz.data(), pz.size() * sizeof(double));
+  put(layout.parent, parent.data(), parent.size() * sizeof(std::uint32_t));
+  put(layout.descendant_count, descendant_count.data(), descendant_count.size() * sizeof(std::uint32_t));
+  put(layout.roots, roots.data(), roots.size() * sizeof(std::uint32_t));
+  put(layout.species, species.data(), species.size());
+  put(layout.flags, flags.data(), flags.size());
+  put(layout.file_size, nullptr, 0);
+  return static_cast<bool>(file.flush());
+}
+
+CatalogueSnapshot::~CatalogueSnapshot()
+{
+  unmap();
+}
+
+void CatalogueSnapshot::unmap()
+{
+#ifdef _WIN32
+  if(data)
+  {
+    UnmapViewOfFile(data);
+  }
+  if(mapping)
+  {
+    CloseHandle(static_cast<HANDLE>(mapping));
+  }
+#else
+  if(data)
+  {
+    munmap(const_cast<unsigned char*>(data), mapped_size);
+  }
+#endif
+  data = nullptr;
+  mapped_size = 0;
+  mapping = nullptr;
+  header = nullptr;
+  layout = SnapshotLayout(0, 0);
+}
+
+bool CatalogueSnapshot::open(const std::string& path)
+{
+  unmap();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if(!GetFileSizeEx(file, &file_size))
+  {
+    CloseHandle(file);
+    return false;
+  }
+  mapped_size = static_cast<std::size_t>(file_size.QuadPart);
+  if(mapped_size > 0)
+  {
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    data = mapping ? static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+  }
+  CloseHandle(file);
+#else
+  int file = ::open(path.c_str(), O_RDONLY);
+  if(file < 0)
+  {
+    return false;
+  }
+  struct stat status;
+  if(fstat(file, &status) != 0)
+  {
+    ::close(file);
+    return false;
+  }
+  mapped_size = static_cast<std::size_t>(status.st_size);
+  if(mapped_size > 0)
+  {
+    void* address = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, file, 0);
+    data = address == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(address);
+  }
+  ::close(file); // The mapping keeps the file open
+#endif
+
+  if(mapped_size < sizeof(SnapshotHeader))
+  {
+    unmap();
+    throw std::invalid_argument("Snapshot " + path + " is truncated.");
+  }
+  if(!data)
+  {
+    unmap();
+    throw std::invalid_argument("Could not map snapshot " + path + ".");
+  }
+  const auto* candidate = reinterpret_cast<const SnapshotHeader*>(data);
+  if(std::memcmp(candidate->magic, SnapshotHeader::expected_magic, sizeof(candidate->magic)) != 0)
+  {
+    unmap();
+    throw std::invalid_argument(path + " is not a particle catalogue snapshot.");
+  }
+  if(candidate->version != SnapshotHeader::current_version || candidate->byte_order != SnapshotHeader::byte_order_mark)
+  {
+    unmap();
+    throw std::invalid_argument("Snapshot " + path + " has an unsupported version or byte order.");
+  }
+  // Bounding the counts first keeps the layout arithmetic from overflowing on a corrupt header
+  if(candidate->node_count >= ParticleRecord::no_index || candidate->particle_count > candidate->node_count)
+  {
+    unmap();
+    throw std::invalid_argument("Snapshot " + path + " has an invalid particle or node count.");
+  }
+  SnapshotLayout candidate_layout(candidate->particle_count, candidate->node_count);
+  if(candidate->file_size != candidate_layout.file_size || mapped_size != candidate_layout.file_size)
+  {
+    unmap();
+    throw std::invalid_argument("Snapshot " + path + " is truncated or its size does not match its header.");
+  }
+  header = candidate;
+  layout = candidate_layout;
+  return true;
+}
+
+std::shared_ptr<Particle> CatalogueSnapshot::particle(std::size_t index) const
+{
+  if(index >= size())
+  {
+    throw std::out_of_range("Snapshot particle index is out of range.");
+  }
+  std::uint32_t root = roots()[index];
+  if(root >= node_count() || std::uint64_t{root} + 1 + descendant_count()[root] > node_count())
+  {
+    throw std::invalid_argument("Snapshot contains a decay tree that runs past its last node.");
+  }
+  auto end = static_cast<std::uint32_t>(root + 1 + descendant_count()[root]);
+  std::vector<std::shared_ptr<Particle>> tree;
+  tree.reserve(end - root);
+  for(std::uint32_t node = root; node < end; ++node)
+  {
+    if(static_cast<std::size_t>(species()[node]) >= species_count)
+    {
+      throw std::invalid_argument("Snapshot contains an unknown species ID.");
+    }
+    auto particle = make_particle(species()[node], px()[node], py()[node], pz()[node]);
+    particle->set_momentum(e()[node], px()[node], py()[node], pz()[node]); // Keeps off-shell energies as written
+    if(node != root && (parent()[node] < root || parent()[node] >= node))
+    {
+      throw std::invalid_argument("Snapshot contains a decay product whose parent is outside its tree.");
+    }
+    if(node != root)
+    {
+      tree[parent()[node] - root]->add_decay_product(particle);
+    }
+    tree.push_back(std::move(particle));
+  }
+  return tree.front();
+}
@@ -0,0 +1,144 @@
+#ifndef CATALOGUE_SNAPSHOT_H
+#define CATALOGUE_SNAPSHOT_H
+
+#include "decay_tree_arena.h"
+#include "fourmom.h"
+#include "particle_catalogue.h"
+#include "species.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Binary snapshot of a catalogue, read back through a memory mapping without parsing or copying.
+//
+// Layout (native byte order, every column 8-byte aligned):
+//   SnapshotHeader
+//   e, px, py, pz            double   per node
+//   parent, descendant_count uint32   per node
+//   roots                    uint32   per base particle, the node each base particle's tree starts at
+//   species, flags           uint8    per node
+// Nodes are every base particle followed by its decay products in pre-order, tree after tree, so a node's subtree is
+// [i, i + 1 + descendant_count) as in DecayTreeArena. Parents are node indices, or ParticleRecord::no_index for roots.
+// Colour charges, calorimeter deposits and isolation flags are not stored, nor are the decay_type label and
+// borrowed_energy of W, Z, Higgs and tau: reloaded particles keep their decay products and (off-shell) momenta,
+// but print an empty decay type and no borrowed energy.
+struct SnapshotHeader
+{
+  static constexpr char expected_magic[8] = {'P', 'C', 'A', 'T', 'S', 'N', 'A', 'P'};
+  static constexpr std::uint32_t current_version = 1;
+  static constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint64_t particle_count;
+  std::uint64_t node_count;
+  std::uint64_t file_size;
+};
+
+// Byte offsets of each column for a given number of particles and nodes; shared by the writer and the reader
+struct SnapshotLayout
+{
+  std::uint64_t e, px, py, pz, parent, descendant_count, roots, species, flags, file_size;
+
+  SnapshotLayout(std::uint64_t particle_count, std::uint64_t node_count);
+};
+
+// The columns of a snapshot being assembled in memory
+class SnapshotWriter
+{
+private:
+  std::vector<double> e, px, py, pz;
+  std::vector<std::uint32_t> parent, descendant_count, roots;
+  std::vector<std::uint8_t> species, flags;
+
+public:
+  void append(const DecayTreeArena& tree); // One base particle and its decay products
+  bool write(const std::string& path) const; // One sequential pass over the file; false if it cannot be written
+};
+
+template<typename T>
+bool write_snapshot(const ParticleCatalogue<T>& catalogue, const std::string& path)
+{
+  SnapshotWriter writer;
+  DecayTreeArena tree; // Reused, so flattening each tree allocates nothing once the buffers have grown
+  for(const T& particle : catalogue.all_particles())
+  {
+    tree.assign(particle);
+    writer.append(tree);
+  }
+  return writer.write(path);
+}
+
+// Read-only view of a snapshot file. Opening maps the file and checks its header, so it takes the same few
+// milliseconds at any size; the columns are then used in place and pages are read in as they are touched.
+class CatalogueSnapshot
+{
+private:
+  const unsigned char* data = nullptr;
+  std::size_t mapped_size = 0;
+  void* mapping = nullptr; // Windows file mapping handle
+  const SnapshotHeader* header = nullptr;
+  SnapshotLayout layout{0, 0};
+
+  template<typename Column>
+  const Column* column(std::uint64_t offset) const { return reinterpret_cast<const Column*>(data + offset); }
+  void unmap();
+
+public:
+  CatalogueSnapshot() = default;
+  CatalogueSnapshot(const CatalogueSnapshot&) = delete;
+  CatalogueSnapshot& operator=(const CatalogueSnapshot&) = delete;
+  ~CatalogueSnapshot();
+
+  // Returns false if the file cannot be opened; throws std::invalid_argument if it is not a readable snapshot
+  bool open(const std::string& path);
+
+  std::size_t size() const { return header ? header->particle_count : 0; } // Base particles
+  std::size_t node_count() const { return header ? header->node_count : 0; } // Base particles and all decay products
+
+  const double* e() const { return column<double>(layout.e); }
+  const double* px() const { return column<double>(layout.px); }
+  const double* py() const { return column<double>(layout.py); }
+  const double* pz() const { return column<double>(layout.pz); }
+  const std::uint32_t* parent() const { return column<std::uint32_t>(layout.parent); }
+  const std::uint32_t* descendant_count() const { return column<std::uint32_t>(layout.descendant_count); }
+  const std::uint32_t* roots() const { return column<std::uint32_t>(layout.roots); }
+  const Species* species() const { return column<Species>(layout.species); }
+  const std::uint8_t* flags() const { return column<std::uint8_t>(layout.flags); }
+
+  FourMomentum momentum(std::size_t node) const { return FourMomentum(e()[node], px()[node], py()[node], pz()[node]); }
+
+  // Rebuilds base particle 'index' and its decay tree as ordinary particles. Throws std::out_of_range for an index
+  // past size() and std::invalid_argument if the tree's links point outside it.
+  std::shared_ptr<Particle> particle(std::size_t index) const;
+};
+
+// Adds every particle in 'snapshot' to 'catalogue', rebuilding their decay trees. Throws std::invalid_argument,
+// adding nothing, if a base particle is not a T (eg a W boson loaded into a ParticleCatalogue<Lepton>).
+template<typename T>
+void load_snapshot(const CatalogueSnapshot& snapshot, ParticleCatalogue<T>& catalogue)
+{
+  std::vector<std::shared_ptr<T>> particles;
+  particles.reserve(snapshot.size());
+  for(std::size_t i = 0; i < snapshot.size(); ++i)
+  {
+    std::shared_ptr<Particle> particle = snapshot.particle(i);
+    std::shared_ptr<T> typed = std::dynamic_pointer_cast<T>(particle);
+    if(!typed)
+    {
+      throw std::invalid_argument("Snapshot particle " + std::to_string(i) + " is a " + particle->get_type() +
+                                  ", which this catalogue cannot hold");
+    }
+    particles.push_back(std::move(typed));
+  }
+  for(auto& particle : particles)
+  {
+    catalogue.add_particle(std::move(particle));
+  }
+}
+
+#endif // CATALOGUE_SNAPSHOT_H
@@ -0,0 +1,158 @@
+#ifndef CONCURRENT_PARTICLE_CATALOGUE_H
+#define CONCURRENT_PARTICLE_CATALOGUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include "particle.h"
+#include "particle_catalogue.h"
+#include "species.h"
+
+// Append-only catalogue that many threads may fill at once, eg generator threads calling create_add_particle.
+// Each species is its own shard with its own lock, held only to place one shared_ptr, so threads producing
+// different species never contend. Stored particles never move: a shard is a list of segments that double in
+// size, allocated once and never reallocated. Readers take no lock. They see every particle whose insertion
+// finished before they started, and a consistent prefix of each shard while writers keep appending.
+// There is no removal and no running momentum totals; take a snapshot() into a ParticleCatalogue for those.
+template<typename T>
+class ConcurrentParticleCatalogue
+{
+private:
+  static constexpr std::size_t first_segment_bits = 6; // Segment k holds 64 << k particles
+  static constexpr std::size_t segment_count = 40;
+
+  class Shard
+  {
+  private:
+    std::mutex mutex; // Serialises writers only
+    std::array<std::atomic<std::shared_ptr<T>*>, segment_count> segments{};
+    std::atomic<std::size_t> published{0}; // Particles [0, published) are complete and visible to readers
+
+    // Segment and offset of element 'index': segment k starts at (64 << k) - 64
+    static std::size_t segment_of(std::size_t index, std::size_t& offset)
+    {
+      std::size_t biased = index + (std::size_t{1} << first_segment_bits);
+      std::size_t bit = 63 - __builtin_clzll(biased);
+      offset = biased - (std::size_t{1} << bit);
+      return bit - first_segment_bits;
+    }
+
+  public:
+    Shard() = default;
+    Shard(const Shard&) = delete;
+    Shard& operator=(const Shard&) = delete;
+    ~Shard()
+    {
+      for(auto& segment : segments)
+      {
+        delete[] segment.load(std::memory_order_relaxed);
+      }
+    }
+
+    void push_back(std::shared_ptr<T> particle)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::size_t index = published.load(std::memory_order_relaxed);
+      std::size_t offset;
+      std::size_t segment = segment_of(index, offset);
+      std::shared_ptr<T>* storage = segments[segment].load(std::memory_order_relaxed);
+      if(!storage)
+      {
+        storage = new std::shared_ptr<T>[std::size_t{1} << (segment + first_segment_bits)];
+        segments[segment].store(storage, std::memory_order_release);
+      }
+      storage[offset] = std::move(particle);
+      published.store(index + 1, std::memory_order_release);
+    }
+
+    std::size_t size() const { return published.load(std::memory_order_acquire); }
+
+    // Valid for index < a size() already read
+    const std::shared_ptr<T>& operator[](std::size_t index) const
+    {
+      std::size_t offset;
+      std::size_t segment = segment_of(index, offset);
+      return segments[segment].load(std::memory_order_acquire)[offset];
+    }
+  };
+
+  std::array<Shard, species_count> shards;
+
+  const Shard* find_shard(std::string_view type) const // nullptr for an unknown type name
+  {
+    Species species;
+    return species_from_name(type, species) ? &shards[species_index(species)] : nullptr;
+  }
+
+public:
+  ConcurrentParticleCatalogue() = default;
+  ConcurrentParticleCatalogue(const ConcurrentParticleCatalogue&) = delete;
+  ConcurrentParticleCatalogue& operator=(const ConcurrentParticleCatalogue&) = delete;
+
+  // Safe to call from any number of threads at once
+  void add_particle(std::shared_ptr<T> particle)
+  {
+    Species species = particle->get_species();
+    shards[species_index(species)].push_back(std::move(particle));
+  }
+
+  std::size_t size() const
+  {
+    std::size_t total = 0;
+    for(const Shard& shard : shards)
+    {
+      total += shard.size();
+    }
+    return total;
+  }
+
+  std::size_t count_of_type(Species species) const { return shards[species_index(species)].size(); }
+  std::size_t count_of_type(const std::string& type) const
+  {
+    const Shard* shard = find_shard(type);
+    return shard ? shard->size() : 0;
+  }
+
+  // Calls f(T&) for the particles of one species present when the call starts, in insertion order
+  template<typename F>
+  void for_each_of_type(Species species, F f) const
+  {
+    const Shard& shard = shards[species_index(species)];
+    std::size_t count = shard.size();
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      f(*shard[i]);
+    }
+  }
+
+  // Calls f(T&) for every particle, type by type
+  template<typename F>
+  void for_each(F f) const
+  {
+    for(std::size_t s = 0; s < species_count; ++s)
+    {
+      for_each_of_type(static_cast<Species>(s), f);
+    }
+  }
+
+  // Copies the current contents into an ordinary catalogue, sharing the particles. The new catalogue registers as
+  // an observer of each particle, so take snapshots from one thread at a time.
+  ParticleCatalogue<T> snapshot() const
+  {
+    ParticleCatalogue<T> catalogue;
+    for(const Shard& shard : shards)
+    {
+      std::size_t count = shard.size();
+      for(std::size_t i = 0; i < count; ++i)
+      {
+        catalogue.add_particle(shard[i]);
+      }
+    }
+    return catalogue;
+  }
+};
+
+#endif // CONCURRENT_PARTICLE_CATALOGUE_H
@@ -0,0 +1,211 @@
+#include "decay_engine.h"
+#include "fourmom_block.h"
+#include "lepton.h"
+#include "particle.h"
+#include "particle_factory.h"
+#include "phase_space.h"
+#include "random_engine.h"
+#include <array>
+#include <cmath>
+#include <utility>
+#include <iostream>
+
+DecayEngine::DecayEngine(const DecayTable& table) : table(table) {}
+
+void DecayEngine::decay_batch(const std::vector<Particle*>& parents)
+{
+  std::vector<Particle*> generation = parents;
+  std::vector<Particle*> next_generation;
+  while(!generation.empty())
+  {
+    next_generation.clear();
+    decay_generation(generation, next_generation);
+    generation.swap(next_generation);
+  }
+}
+
+void DecayEngine::decay_generation(const std::vector<Particle*>& parents, std::vector<Particle*>& unstable_products)
+{
+  std::array<std::vector<Particle*>, species_count> by_species;
+  for(Particle* parent : parents)
+  {
+    if(table.has_channels(parent->get_species()))
+    {
+      by_species[species_index(parent->get_species())].push_back(parent);
+    }
+  }
+
+  RandomEngine& rng = thread_random_engine();
+  std::vector<std::vector<Particle*>> by_channel;
+  for(std::size_t s = 0; s < species_count; ++s)
+  {
+    if(by_species[s].empty())
+    {
+      continue;
+    }
+    Species species = static_cast<Species>(s);
+    const auto& channels = table.channels(species);
+    by_channel.assign(channels.size(), {});
+    for(Particle* parent : by_species[s])
+    { // Off-shell parents only take channels open at their invariant mass
+      double parent_mass = parent->get_four_momentum().invariant_mass();
+      std::size_t channel = table.sample_open_index(species, parent_mass, rng);
+      if(channel == DecayTable::no_channel)
+      {
+        std::cerr<<"No decay channel of "<<species_name(species)<<" is open at invariant mass "<<parent_mass
+                 <<" MeV, it is left undecayed."<<std::endl;
+        continue;
+      }
+      by_channel[channel].push_back(parent);
+    }
+    for(std::size_t c = 0; c < channels.size(); ++c)
+    {
+      if(!by_channel[c].empty())
+      {
+        decay_channel_group(channels[c], by_channel[c], unstable_products);
+      }
+    }
+  }
+}
+
+void DecayEngine::decay_channel_group(const DecayChannel& channel, const std::vector<Particle*>& parents, std::vector<Particle*>& unstable_products)
+{
+  std::size_t count = parents.size();
+  std::size_t product_count = channel.products.size();
+
+  // products[k][i] is the k-th product of the i-th parent
+  std::vector<std::vector<std::shared_ptr<Particle>>> products;
+  std::vector<double> masses;
+  for(const DecayProduct& product : channel.products)
+  {
+    products.push_back(make_particle_block(product.species, count, product.colour, channel.borrowed_energy));
+    masses.push_back(products.back().front()->get_mass() - channel.borrowed_energy);
+  }
+
+  FourMomentumBlock parent_momenta(count);
+  for(Particle* parent : parents)
+  {
+    parent_momenta.push_back(parent->get_four_momentum()); // Channels were sampled open, so the masses fit
+  }
+
+  // product_momenta[k] holds the k-th product of every parent
+  RandomEngine& rng = thread_random_engine();
+  std::vector<FourMomentumBlock> product_momenta(product_count);
+  if(product_count == 2)
+  {
+    two_body_decay(parent_momenta, masses[0], masses[1], rng, product_momenta[0], product_momenta[1]);
+  }
+  else
+  {
+    for(FourMomentumBlock& block : product_momenta)
+    {
+      block.reserve(count);
+    }
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      std::vector<FourMomentum> momenta = n_body_decay(parent_momenta[i], masses, rng);
+      for(std::size_t k = 0; k < product_count; ++k)
+      {
+        product_momenta[k].push_back(momenta[k]);
+      }
+    }
+  }
+  for(std::size_t k = 0; k < product_count; ++k)
+  {
+    const FourMomentumBlock& block = product_momenta[k];
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      products[k][i]->set_momentum(block.e()[i], block.px()[i], block.py()[i], block.pz()[i]);
+    }
+  }
+
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    parents[i]->set_decay_channel(channel);
+    for(std::size_t k = 0; k < product_count; ++k)
+    {
+      parents[i]->add_decay_product(products[k][i]);
+    }
+  }
+
+  for(std::size_t k = 0; k < product_count; ++k)
+  {
+    Species species = channel.products[k].species;
+    for(const auto& product : products[k])
+    {
+      if(species == Species::Electron || species == Species::AntiElectron)
+      {
+        std::static_pointer_cast<Electron>(product)->adjust_calorimeter_deposits();
+      }
+      else if(table.has_channels(species))
+      {
+        unstable_products.push_back(product.get());
+      }
+    }
+  }
+
+  validate_group(channel, *parents.front(), products, parent_momenta, product_momenta, masses);
+}
+
+void DecayEngine::validate_group(const DecayChannel& channel, Particle& parent, const std::vector<std::vector<std::shared_ptr<Particle>>>& products,
+                                 const FourMomentumBlock& parent_momenta, const std::vector<FourMomentumBlock>& product_momenta,
+                                 const std::vector<double>& masses)
+{ // Quantum numbers depend only on the channel, so the first decay stands for the whole group
+  DecayProducts channel_products;
+  for(const auto& kind : products)
+  {
+    channel_products.push_back(kind.front());
+  }
+
+  QuantumNumbers violations = parent.quantum_number_violations(channel_products); // Charge, baryon and lepton numbers in one pass
+  if(violations & lepton_number_lanes)
+  {
+    std::cerr<<"Invalid particle decay: lepton number conservation violated."<<std::endl;
+  }
+  if(violations & quantum_lane_mask(QuantumLane::BaryonThirds))
+  {
+    std::cerr<<"Invalid particle decay: baryon number conservation violated."<<std::endl;
+  }
+  if(violations & quantum_lane_mask(QuantumLane::ChargeThirds))
+  {
+    std::cerr<<"Invalid particle decay: charge conservation violated."<<std::endl;
+  }
+
+  // Kinematics are checked for every decay, over the columns: each product on its (borrowed-energy) mass shell and
+  // the products' total equal to the parent's four-momentum
+  std::size_t count = parent_momenta.size();
+  FourMomentumBlock total = product_momenta[0];
+  FourMomentumBlock next;
+  std::vector<double> product_masses(count);
+  std::size_t off_shell = 0;
+  for(std::size_t k = 0; k < product_momenta.size(); ++k)
+  {
+    if(k > 0)
+    {
+      add(total, product_momenta[k], next); // Kernels take distinct input and output blocks
+      std::swap(total, next);
+    }
+    invariant_mass(product_momenta[k], product_masses.data());
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      off_shell += std::abs(product_masses[i] - masses[k]) > 1e-2; // Same tolerance as Particle::check_invariant_mass
+    }
+  }
+  std::size_t not_conserved = 0;
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    double tolerance = 1e-6 * parent_momenta.e()[i];
+    not_conserved += std::abs(total.e()[i] - parent_momenta.e()[i]) > tolerance || std::abs(total.px()[i] - parent_momenta.px()[i]) > tolerance ||
+                     std::abs(total.py()[i] - parent_momenta.py()[i]) > tolerance || std::abs(total.pz()[i] - parent_momenta.pz()[i]) > tolerance;
+  }
+  if(off_shell > 0)
+  {
+    std::cerr<<"Invalid particle decay: invariant mass violated in "<<off_shell<<" "<<channel.label<<" "
+             <<species_name(parent.get_species())<<" decay products."<<std::endl;
+  }
+  if(not_conserved > 0)
+  {
+    std::cerr<<"Invalid particle decay: four-momentum not conserved in "<<not_conserved<<" of "<<count<<" "
+             <<species_name(parent.get_species())<<" decays."<<std::endl;
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef DECAY_ENGINE_H
+#define DECAY_ENGINE_H
+
+#include "decay_table.h"
+#include <memory>
+#include <vector>
+
+class FourMomentumBlock;
+class Particle;
+
+// Decays many parents in one call. Parents are grouped by species and then by channel, which is sampled for
+// the whole group in one pass. Two-body kinematics run through the columnar kernels, each kind of product is
+// allocated as one block for the group, and a channel's quantum numbers are checked once per group while the
+// kinematics of every decay are checked over the columns. Unstable products then decay the same way, a generation
+// at a time. Draws come from thread_random_engine().
+class DecayEngine
+{
+private:
+  const DecayTable& table;
+
+  // Decays every parent in 'parents' and collects the products that are themselves unstable
+  void decay_generation(const std::vector<Particle*>& parents, std::vector<Particle*>& unstable_products);
+  void decay_channel_group(const DecayChannel& channel, const std::vector<Particle*>& parents, std::vector<Particle*>& unstable_products);
+  void validate_group(const DecayChannel& channel, Particle& parent, const std::vector<std::vector<std::shared_ptr<Particle>>>& products,
+                      const FourMomentumBlock& parent_momenta, const std::vector<FourMomentumBlock>& product_momenta,
+                      const std::vector<double>& masses);
+
+public:
+  explicit DecayEngine(const DecayTable& table = decay_table());
+
+  void decay_batch(const std::vector<Particle*>& parents); // Stable species are skipped
+
+  template<typename ParticleType>
+  void decay_batch(const std::vector<ParticleType*>& parents)
+  {
+    decay_batch(std::vector<Particle*>(parents.begin(), parents.end()));
+  }
+
+  template<typename ParticleType>
+  void decay_batch(const std::vector<std::shared_ptr<ParticleType>>& parents)
+  {
+    std::vector<Particle*> raw;
+    raw.reserve(parents.size());
+    for(const auto& parent : parents)
+    {
+      raw.push_back(parent.get());
+    }
+    decay_batch(raw);
+  }
+};
+
+#endif // DECAY_ENGINE_H
@@ -0,0 +1,337 @@
+#include "decay_table.h"
+#include "lepton.h"
+#include "particle.h"
+#include "particle_factory.h"
+#include "random_engine.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+const char* const DecayTable::default_channels = R"TABLE(# Decay channels of the unstable particles, one per line:
+#   <parent> "<decay type>" <branching ratio> <product>[:<colour>] ...
+# Branching ratios are normalised per parent. Antiparticles that are not listed decay into the
+# charge conjugates of their particle's channels (eg W- from W+, AntiTau from Tau).
+
+W+ "Leptonic" 0.11 AntiElectron ElectronNeutrino
+W+ "Leptonic" 0.11 AntiMuon MuonNeutrino
+W+ "Leptonic" 0.11 TauNeutrino AntiTau
+W+ "Hadronic" 0.111667 UpQuark:Green AntiDownQuark:AntiGreen
+W+ "Hadronic" 0.111667 UpQuark:Green AntiStrangeQuark:AntiGreen
+W+ "Hadronic" 0.111667 UpQuark:Green AntiBottomQuark:AntiGreen
+W+ "Hadronic" 0.111667 CharmQuark:Blue AntiDownQuark:AntiBlue
+W+ "Hadronic" 0.111667 CharmQuark:Blue AntiStrangeQuark:AntiBlue
+W+ "Hadronic" 0.111667 CharmQuark:Blue AntiBottomQuark:AntiBlue
+
+ZBoson "Leptonic" 0.055556 Electron AntiElectron
+ZBoson "Leptonic" 0.055556 Muon AntiMuon
+ZBoson "Leptonic" 0.055556 Tau AntiTau
+ZBoson "Leptonic" 0.055556 ElectronNeutrino AntiElectronNeutrino
+ZBoson "Leptonic" 0.055556 MuonNeutrino AntiMuonNeutrino
+ZBoson "Leptonic" 0.055556 TauNeutrino AntiTauNeutrino
+ZBoson "Hadronic" 0.133333 UpQuark:Green AntiUpQuark:AntiGreen
+ZBoson "Hadronic" 0.133333 DownQuark:Red AntiDownQuark:AntiRed
+ZBoson "Hadronic" 0.133333 CharmQuark:Blue AntiCharmQuark:AntiBlue
+ZBoson "Hadronic" 0.133333 StrangeQuark:Green AntiStrangeQuark:AntiGreen
+ZBoson "Hadronic" 0.133333 BottomQuark:Red AntiBottomQuark:AntiRed
+
+HiggsBoson "Virtual ZZ" 0.25 ZBoson ZBoson
+HiggsBoson "Virtual W-W+" 0.25 W- W+
+HiggsBoson "Photon-Photon" 0.25 Photon Photon
+HiggsBoson "Hadronic" 0.25 BottomQuark:Red AntiBottomQuark:AntiRed
+
+Tau "Leptonic" 0.165 Muon AntiMuonNeutrino TauNeutrino
+Tau "Leptonic" 0.165 Electron AntiElectronNeutrino TauNeutrino
+Tau "Hadronic" 0.335 AntiUpQuark:AntiRed DownQuark:Red TauNeutrino
+Tau "Hadronic" 0.335 AntiUpQuark:AntiBlue StrangeQuark:Blue TauNeutrino
+)TABLE";
+
+namespace
+{
+  DecayTable& mutable_decay_table()
+  {
+    static DecayTable table = []()
+    {
+      std::istringstream input(DecayTable::default_channels);
+      return DecayTable(input);
+    }();
+    return table;
+  }
+
+  double species_mass(Species species)
+  {
+    return species_descriptor(species).mass;
+  }
+}
+
+DecayTable::DecayTable(std::istream& input)
+{
+  load(input);
+}
+
+void DecayTable::load(std::istream& input)
+{
+  std::array<Entry, species_count> loaded;
+  std::string line;
+  for(int line_number = 1; std::getline(input, line); ++line_number)
+  {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string parent_name;
+    if(!(fields>>parent_name))
+    {
+      continue; // Blank or comment line
+    }
+
+    std::string where = "Decay table line " + std::to_string(line_number) + ": ";
+    Species parent;
+    if(!species_from_name(parent_name, parent))
+    {
+      throw std::invalid_argument(where + "unknown parent '" + parent_name + "'.");
+    }
+    DecayChannel channel;
+    if(!(fields>>std::quoted(channel.label)>>channel.branching_ratio) || !(channel.branching_ratio > 0) || !std::isfinite(channel.branching_ratio))
+    {
+      throw std::invalid_argument(where + "expected a decay type and a positive branching ratio.");
+    }
+
+    std::string token;
+    while(fields>>token)
+    {
+      DecayProduct product;
+      std::size_t colon = token.find(':');
+      if(!species_from_name(token.substr(0, colon), product.species))
+      {
+        throw std::invalid_argument(where + "unknown product '" + token + "'.");
+      }
+      if(colon != std::string::npos && !colour_charge_from_string(token.substr(colon + 1), product.colour))
+      {
+        throw std::invalid_argument(where + "unknown colour in '" + token + "'.");
+      }
+      channel.products.push_back(product);
+    }
+    if(channel.products.empty())
+    {
+      throw std::invalid_argument(where + "channel has no products.");
+    }
+    loaded[species_index(parent)].channels.push_back(std::move(channel));
+  }
+
+  entries = std::move(loaded);
+  finalise();
+}
+
+void DecayTable::finalise()
+{
+  for(std::size_t i = 0; i < species_count; ++i)
+  {
+    Species species = static_cast<Species>(i);
+    const Entry& conjugate = entries[species_index(antiparticle_of(species))];
+    if(entries[i].channels.empty() && &conjugate != &entries[i])
+    {
+      for(DecayChannel channel : conjugate.channels)
+      {
+        for(DecayProduct& product : channel.products)
+        {
+          product = {antiparticle_of(product.species), anticolour(product.colour)};
+        }
+        entries[i].channels.push_back(std::move(channel));
+      }
+    }
+  }
+
+  for(std::size_t i = 0; i < species_count; ++i)
+  {
+    Entry& entry = entries[i];
+    std::size_t n = entry.channels.size();
+    if(n == 0)
+    {
+      continue;
+    }
+
+    double parent_mass = species_mass(static_cast<Species>(i));
+    double total_ratio = 0;
+    for(DecayChannel& channel : entry.channels)
+    {
+      double mass_sum = 0;
+      for(const DecayProduct& product : channel.products)
+      {
+        mass_sum += species_mass(product.species);
+      }
+      channel.borrowed_energy = mass_sum > parent_mass ? (mass_sum - parent_mass)/channel.products.size() : 0;
+      channel.threshold_mass = mass_sum - channel.borrowed_energy*channel.products.size();
+      total_ratio += channel.branching_ratio;
+    }
+
+    // Vose's construction: pair each under-full column with an over-full one until every column holds 1/n
+    std::vector<double> scaled(n);
+    std::vector<std::uint32_t> small, large;
+    for(std::size_t c = 0; c < n; ++c)
+    {
+      scaled[c] = entry.channels[c].branching_ratio*n/total_ratio;
+      (scaled[c] < 1 ? small : large).push_back(static_cast<std::uint32_t>(c));
+    }
+    entry.acceptance.assign(n, 1.0);
+    entry.alias.resize(n);
+    for(std::size_t c = 0; c < n; ++c)
+    {
+      entry.alias[c] = static_cast<std::uint32_t>(c);
+    }
+    while(!small.empty() && !large.empty())
+    {
+      std::uint32_t under = small.back();
+      small.pop_back();
+      std::uint32_t over = large.back();
+      entry.acceptance[under] = scaled[under];
+      entry.alias[under] = over;
+      scaled[over] -= 1 - scaled[under];
+      if(scaled[over] < 1)
+      {
+        large.pop_back();
+        small.push_back(over);
+      }
+    }
+  }
+}
+
+std::size_t DecayTable::sample_index(Species species, double uniform) const
+{
+  const Entry& entry = entries[species_index(species)];
+  // The integer part of u*n picks a column and the fractional part decides between it and its alias
+  double scaled = uniform*entry.channels.size();
+  std::size_t column = std::min(static_cast<std::size_t>(scaled), entry.channels.size() - 1);
+  return scaled - column < entry.acceptance[column] ? column : entry.alias[column];
+}
+
+std::size_t DecayTable::sample_open_index(Species species, double parent_mass, RandomEngine& rng) const
+{
+  const Entry& entry = entries[species_index(species)];
+  if(entry.channels.empty())
+  {
+    return no_channel;
+  }
+  std::size_t index = sample_index(species, rng.uniform());
+  if(entry.channels[index].is_open(parent_mass))
+  {
+    return index;
+  }
+
+  // Rare (off-shell parents only), so a linear scan over the open channels
+  double open_ratio = 0;
+  for(const DecayChannel& channel : entry.channels)
+  {
+    open_ratio += channel.is_open(parent_mass) ? channel.branching_ratio : 0;
+  }
+  if(open_ratio == 0)
+  {
+    return no_channel;
+  }
+  double target = rng.uniform()*open_ratio;
+  std::size_t last_open = no_channel;
+  for(std::size_t c = 0; c < entry.channels.size(); ++c)
+  {
+    if(entry.channels[c].is_open(parent_mass))
+    {
+      last_open = c;
+      target -= entry.channels[c].branching_ratio;
+      if(target < 0)
+      {
+        break;
+      }
+    }
+  }
+  return last_open; // Also covers rounding leaving 'target' just above zero
+}
+
+const DecayChannel* DecayTable::sample(Species species, double uniform) const
+{
+  const Entry& entry = entries[species_index(species)];
+  return entry.channels.empty() ? nullptr : &entry.channels[sample_index(species, uniform)];
+}
+
+const DecayTable& decay_table()
+{
+  return mutable_decay_table();
+}
+
+bool load_decay_table(const std::string& path)
+{
+  std::ifstream file(path);
+  if(!file)
+  {
+    return false;
+  }
+  try
+  {
+    mutable_decay_table().load(file);
+  }
+  catch(const std::invalid_argument& error)
+  { // The table is only replaced once the whole file has parsed, so the current one is still complete
+    std::cerr<<path<<": "<<error.what()<<" Keeping the current decay table."<<std::endl;
+    return false;
+  }
+  return true;
+}
+
+const DecayChannel* decay_from_table(Particle& parent)
+{
+  const DecayTable& table = decay_table();
+  double parent_mass = parent.get_four_momentum().invariant_mass();
+  std::size_t index = table.sample_open_index(parent.get_species(), parent_mass, thread_random_engine());
+  if(index == DecayTable::no_channel)
+  {
+    if(table.has_channels(parent.get_species()))
+    {
+      std::cerr<<"No decay channel of "<<species_name(parent.get_species())<<" is open at invariant mass "<<parent_mass
+               <<" MeV, it is left undecayed."<<std::endl;
+    }
+    return nullptr;
+  }
+  const DecayChannel* channel = &table.channels(parent.get_species())[index];
+
+  parent.set_decay_channel(*channel);
+
+  DecayProducts products; // Inline for up to four products, no allocation
+  products.reserve(channel->products.size());
+  for(const DecayProduct& product : channel->products)
+  {
+    products.push_back(make_particle(product.species, 0, 0, 0, product.colour, channel->borrowed_energy)); // Initial momenta set to 0
+    parent.add_decay_product(products.back());
+  }
+  parent.distribute_energy_momentum(products, parent.get_e(), parent.get_px(), parent.get_py(), parent.get_pz(), channel->borrowed_energy); // Open, so always succeeds
+
+  for(const auto& product : products)
+  {
+    Species species = product->get_species();
+    if(species == Species::Electron || species == Species::AntiElectron)
+    {
+      std::static_pointer_cast<Electron>(product)->adjust_calorimeter_deposits();
+    }
+    else if(decay_table().has_channels(species))
+    {
+      product->decay(); // Unstable products decay after their parent
+    }
+  }
+
+  QuantumNumbers violations = parent.quantum_number_violations(products); // Charge, baryon and lepton numbers in one pass
+  if(violations & lepton_number_lanes)
+  {
+    std::cerr<<"Invalid particle decay: lepton number conservation violated."<<std::endl;
+  }
+  if(violations & quantum_lane_mask(QuantumLane::BaryonThirds))
+  {
+    std::cerr<<"Invalid particle decay: baryon number conservation violated."<<std::endl;
+  }
+  if(violations & quantum_lane_mask(QuantumLane::ChargeThirds))
+  {
+    std::cerr<<"Invalid particle decay: charge conservation violated."<<std::endl;
+  }
+  if(!(parent.check_invariant_mass(products, channel->borrowed_energy)))
+  {
+    std::cerr<<"Invalid particle decay: invariant mass violated."<<std::endl;
+  }
+  return channel;
+}
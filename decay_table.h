@@ -0,0 +1,81 @@
+#ifndef DECAY_TABLE_H
+#define DECAY_TABLE_H
+
+#include "quark.h"
+#include "random_engine.h"
+#include "species.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+class Particle;
+
+struct DecayProduct
+{
+  Species species;
+  ColourCharge colour = ColourCharge::Neutral; // Only used by quarks and gluons
+};
+
+struct DecayChannel
+{
+  std::string label; // Reported as the parent's decay type, eg "Leptonic"
+  double branching_ratio = 0;
+  std::vector<DecayProduct> products;
+  double borrowed_energy = 0; // Per product, when the products outweigh the parent (eg Higgs to virtual ZZ)
+  double threshold_mass = 0; // Sum of the product masses less borrowed energy: lighter parents cannot decay this way
+
+  bool is_open(double parent_mass) const { return threshold_mass <= parent_mass * (1 + 1e-9); }
+};
+
+// Decay channels of every unstable species, read from text in the format of decay_table.txt:
+//   <parent> "<decay type>" <branching ratio> <product>[:<colour>] ...
+// An antiparticle without channels of its own decays into the charge conjugates of its particle's channels.
+// Channels are picked with Walker's alias method, so sampling costs one uniform number and constant time
+// however many channels a species has.
+class DecayTable
+{
+private:
+  struct Entry
+  {
+    std::vector<DecayChannel> channels;
+    std::vector<double> acceptance; // Column i keeps channel i with this probability...
+    std::vector<std::uint32_t> alias; // ...and otherwise gives alias[i]
+  };
+  std::array<Entry, species_count> entries;
+
+  void finalise(); // Derives antiparticle channels, borrowed energies and the alias tables
+
+public:
+  static const char* const default_channels; // Same contents as the shipped decay_table.txt
+
+  DecayTable() = default;
+  explicit DecayTable(std::istream& input);
+
+  void load(std::istream& input); // Replaces every channel, throws std::invalid_argument on a malformed line
+
+  bool has_channels(Species species) const { return !entries[species_index(species)].channels.empty(); }
+  const std::vector<DecayChannel>& channels(Species species) const { return entries[species_index(species)].channels; }
+  const DecayChannel* sample(Species species, double uniform) const; // 'uniform' in [0, 1), nullptr for stable species
+  std::size_t sample_index(Species species, double uniform) const; // Index into channels(species), which must not be empty
+
+  // Channel for a parent of invariant mass 'parent_mass', which may be off its mass shell. Closed channels are
+  // excluded and the branching ratios of the open ones renormalised; no_channel if none is open. Draws one uniform
+  // number when the first pick is open, as it always is for a parent at its rest mass.
+  static constexpr std::size_t no_channel = static_cast<std::size_t>(-1);
+  std::size_t sample_open_index(Species species, double parent_mass, RandomEngine& rng) const;
+};
+
+const DecayTable& decay_table(); // Table used by every decay(), the built-in channels unless replaced
+// Returns false, keeping the current table, if the file can't be opened or has a malformed line (reported on std::cerr).
+// Not safe during decays.
+bool load_decay_table(const std::string& path);
+
+// Decays 'parent' through a channel sampled from decay_table(): builds its products, shares out the four-momentum,
+// decays any unstable products in turn and checks the conservation laws. Returns nullptr, leaving the parent
+// undecayed, if the species is stable or no channel is open at the parent's invariant mass.
+const DecayChannel* decay_from_table(Particle& parent);
+
+#endif // DECAY_TABLE_H
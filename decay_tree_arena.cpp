@@ -0,0 +1,114 @@
+#include "decay_tree_arena.h"
+#include "particle.h"
+#include <utility>
+
+DecayTreeArena::DecayTreeArena(const Particle& root)
+{
+  assign(root);
+}
+
+namespace
+{
+  // Appends the pre-order records of the tree under 'root' to 'nodes', with links counted from where the tree
+  // starts, and the particle behind each record to 'facades' if given
+  void flatten(const Particle& root, std::vector<ParticleRecord>& nodes, std::vector<const Particle*>* facades)
+  {
+    // Explicit stack instead of recursion; children are pushed in reverse so they come off in order.
+    // Scratch space is kept per thread so flattening a tree allocates nothing once warmed up.
+    thread_local std::vector<std::pair<const Particle*, std::uint32_t>> stack;
+    thread_local std::vector<std::uint32_t> last_child;
+    stack.assign(1, {&root, ParticleRecord::no_index});
+    last_child.clear();
+    ParticleRecord* tree = nullptr;
+    std::size_t base = nodes.size();
+    while(!stack.empty())
+    {
+      auto [particle, parent] = stack.back();
+      stack.pop_back();
+
+      auto index = static_cast<std::uint32_t>(nodes.size() - base);
+      const auto& products = particle->get_decay_products();
+      ParticleRecord record = particle->record();
+      record.parent = parent;
+      record.child_count = static_cast<std::uint32_t>(products.size());
+      nodes.push_back(record);
+      tree = &nodes[base];
+      if(facades)
+      {
+        facades->push_back(particle);
+      }
+      last_child.push_back(ParticleRecord::no_index);
+
+      if(parent != ParticleRecord::no_index)
+      {
+        if(last_child[parent] == ParticleRecord::no_index)
+        {
+          tree[parent].first_child = index;
+        }
+        else
+        {
+          tree[last_child[parent]].next_sibling = index;
+        }
+        last_child[parent] = index;
+      }
+
+      for(auto it = products.rbegin(); it != products.rend(); ++it)
+      {
+        stack.emplace_back(&*it, index);
+      }
+    }
+
+    // A subtree ends where its last child's subtree ends; children always come after their parent
+    for(std::size_t i = last_child.size(); i-- > 0;)
+    {
+      std::uint32_t last = last_child[i];
+      tree[i].descendant_count = last == ParticleRecord::no_index ? 0 : static_cast<std::uint32_t>(last - i) + tree[last].descendant_count;
+    }
+  }
+}
+
+void DecayTreeArena::assign(const Particle& root)
+{
+  clear();
+  flatten(root, nodes, &facades);
+}
+
+void DecayTreeArena::append_records(const Particle& root, std::vector<ParticleRecord>& out)
+{
+  flatten(root, out, nullptr);
+}
+
+void DecayTreeArena::clear()
+{
+  nodes.clear();
+  facades.clear();
+}
+
+int DecayTreeArena::total_decay_products() const
+{
+  return nodes.empty() ? 0 : static_cast<int>(nodes.size() - 1);
+}
+
+FourMomentum DecayTreeArena::sum_decay_products() const
+{
+  FourMomentum total;
+  for(std::size_t i = 1; i < nodes.size(); ++i)
+  {
+    total += nodes[i].momentum;
+  }
+  return total;
+}
+
+void DecayTreeArena::print() const
+{
+  TextFormatter out(std::cout);
+  print(out);
+}
+
+void DecayTreeArena::print(TextFormatter& out) const
+{
+  for(const Particle* particle : facades)
+  {
+    particle->format_properties(out);
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef DECAY_TREE_ARENA_H
+#define DECAY_TREE_ARENA_H
+
+#include "fourmom.h"
+#include "particle_record.h"
+#include "text_formatter.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Particle;
+
+// A whole decay tree (the root plus every subsequent decay product) flattened into one contiguous
+// pre-order buffer. Each node's subtree is the range [i, i + 1 + descendant_count), so counting,
+// summing and printing a tree are linear scans, and copying or freeing it is a couple of vector operations.
+// It is a copy, not the storage: particles keep their linked tree, and each arena is a snapshot of it (see
+// Particle::decay_tree) for code that reads a whole tree at once, eg printing, snapshots and exports.
+class DecayTreeArena
+{
+private:
+  std::vector<ParticleRecord> nodes;
+  std::vector<const Particle*> facades; // Polymorphic objects behind each record, valid while the tree they came from is alive
+
+public:
+  DecayTreeArena() = default;
+  explicit DecayTreeArena(const Particle& root);
+
+  void assign(const Particle& root); // Rebuilds from 'root' in a single pre-order pass, reusing the buffers
+  void clear();
+
+  // Appends the records 'assign' would build to 'out', without the facades; links count from the tree's first record
+  static void append_records(const Particle& root, std::vector<ParticleRecord>& out);
+
+  std::size_t size() const { return nodes.size(); }
+  bool empty() const { return nodes.empty(); }
+  const ParticleRecord& operator[](std::size_t i) const { return nodes[i]; }
+  const Particle& facade(std::size_t i) const { return *facades[i]; }
+  const std::vector<ParticleRecord>& records() const { return nodes; }
+
+  int total_decay_products() const; // Every node except the root
+  FourMomentum sum_decay_products() const;
+  void print() const; // Prints every node in pre-order, which matches the nested print layout
+  void print(TextFormatter& out) const;
+};
+
+#endif // DECAY_TREE_ARENA_H
@@ -1,36 +1,81 @@
 #ifndef FOURMOM_H
 #define FOURMOM_H
 
-#include <array>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
 
+// Plain value type: trivially copyable, no validation and no exception path, so arithmetic on it
+// compiles down to register operations. Range checking lives in the separate checked() factory.
 class FourMomentum
 {
 private:
-    double E, px, py, pz;
+  double E, px, py, pz;
 
 public:
+  static constexpr double max_momentum = 1e10; // Largest accepted |px|, |py|, |pz| in MeV/c
+
   // Constructors
-  FourMomentum(double E, double px, double py, double pz);
-  FourMomentum(const FourMomentum& other);
-  FourMomentum(FourMomentum&& other) noexcept;
-  FourMomentum& operator=(FourMomentum&& other) noexcept;
-  ~FourMomentum();
-
-  void set_e(double E);
-  void set_px(double px);
-  void set_py(double py);
-  void set_pz(double pz);
-
-  double get_e() const;
-  double get_px() const;
-  double get_py() const;
-  double get_pz() const;
+  constexpr FourMomentum() : E(0), px(0), py(0), pz(0) {}
+  constexpr FourMomentum(double E, double px, double py, double pz) : E(E), px(px), py(py), pz(pz) {}
+
+  // Validating factory, throws std::invalid_argument if a momentum component is out of range
+  static FourMomentum checked(double E, double px, double py, double pz);
+  static constexpr bool in_range(double px, double py, double pz)
+  {
+    return px <= max_momentum && px >= -max_momentum && py <= max_momentum && py >= -max_momentum &&
+           pz <= max_momentum && pz >= -max_momentum;
+  }
+
+  constexpr void set_e(double E) { this->E = E > 0 ? E : 0; }
+  constexpr void set_px(double px) { this->px = px; }
+  constexpr void set_py(double py) { this->py = py; }
+  constexpr void set_pz(double pz) { this->pz = pz; }
+
+  constexpr double get_e() const { return E; }
+  constexpr double get_px() const { return px; }
+  constexpr double get_py() const { return py; }
+  constexpr double get_pz() const { return pz; }
 
   double invariant_mass() const;
+  double transverse_momentum() const { return std::hypot(px, py); }
+  double pseudorapidity() const { return std::asinh(pz / std::max(transverse_momentum(), 1e-300)); } // -ln(tan(theta/2)), finite along the beam axis
+  double azimuth() const { return std::atan2(py, px); }
+
+  constexpr FourMomentum& operator+=(const FourMomentum& rhs)
+  {
+    E += rhs.E;
+    px += rhs.px;
+    py += rhs.py;
+    pz += rhs.pz;
+    return *this;
+  }
 
-  friend FourMomentum operator+(const FourMomentum& lhs, const FourMomentum& rhs);
-  friend FourMomentum operator-(const FourMomentum& lhs, const FourMomentum& rhs);
-  friend double dot_product(const FourMomentum& lhs, const FourMomentum& rhs);
+  constexpr FourMomentum& operator-=(const FourMomentum& rhs)
+  {
+    E -= rhs.E;
+    px -= rhs.px;
+    py -= rhs.py;
+    pz -= rhs.pz;
+    return *this;
+  }
+
+  friend constexpr FourMomentum operator+(FourMomentum lhs, const FourMomentum& rhs) { return lhs += rhs; }
+  friend constexpr FourMomentum operator-(FourMomentum lhs, const FourMomentum& rhs) { return lhs -= rhs; }
+
+  friend constexpr double dot_product(const FourMomentum& lhs, const FourMomentum& rhs)
+  {
+    // Metric signature (+, -, -, -)
+    return lhs.E * rhs.E - (lhs.px * rhs.px + lhs.py * rhs.py + lhs.pz * rhs.pz);
+  }
 };
 
+inline double FourMomentum::invariant_mass() const
+{
+  double mass_squared = dot_product(*this, *this);
+  return mass_squared >= 0 ? std::sqrt(mass_squared) : 0;
+}
+
+static_assert(std::is_trivially_copyable_v<FourMomentum>, "FourMomentum must stay a plain value type");
+
 #endif // FOURMOM_H
@@ -0,0 +1,294 @@
+#include "fourmom_block.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace
+{
+  constexpr std::size_t doubles_per_line = FourMomentumBlock::alignment / sizeof(double);
+
+  // Column length rounded up to whole cache lines so every column starts aligned
+  std::size_t padded_capacity(std::size_t n)
+  {
+    return (n + doubles_per_line - 1) / doubles_per_line * doubles_per_line;
+  }
+
+  double* allocate_columns(std::size_t capacity)
+  {
+    if(capacity == 0)
+    {
+      return nullptr;
+    }
+    return static_cast<double*>(::operator new(4 * capacity * sizeof(double), std::align_val_t(FourMomentumBlock::alignment)));
+  }
+
+  void free_columns(double* storage)
+  {
+    if(storage)
+    {
+      ::operator delete(storage, std::align_val_t(FourMomentumBlock::alignment));
+    }
+  }
+
+  void check_sizes(std::size_t lhs, std::size_t rhs)
+  {
+    if(lhs != rhs)
+    {
+      throw std::invalid_argument("FourMomentumBlock sizes do not match.");
+    }
+  }
+}
+
+FourMomentumBlock::FourMomentumBlock(std::size_t initial_capacity)
+  : count(0), capacity(padded_capacity(initial_capacity)), storage(allocate_columns(capacity)) {}
+
+// Copy constructor
+FourMomentumBlock::FourMomentumBlock(const FourMomentumBlock& other)
+  : count(0), capacity(0), storage(nullptr)
+{
+  *this = other;
+}
+
+// Move constructor
+FourMomentumBlock::FourMomentumBlock(FourMomentumBlock&& other) noexcept
+  : count(other.count), capacity(other.capacity), storage(other.storage)
+{
+  other.count = 0;
+  other.capacity = 0;
+  other.storage = nullptr;
+}
+
+// Copy assignment operator
+FourMomentumBlock& FourMomentumBlock::operator=(const FourMomentumBlock& other)
+{
+  if(this != &other)
+  {
+    count = 0;
+    reserve(other.count);
+    count = other.count;
+    if(count > 0)
+    {
+      std::memcpy(e(), other.e(), count * sizeof(double));
+      std::memcpy(px(), other.px(), count * sizeof(double));
+      std::memcpy(py(), other.py(), count * sizeof(double));
+      std::memcpy(pz(), other.pz(), count * sizeof(double));
+    }
+  }
+  return *this;
+}
+
+// Move assignment operator
+FourMomentumBlock& FourMomentumBlock::operator=(FourMomentumBlock&& other) noexcept
+{
+  if(this != &other)
+  {
+    free_columns(storage);
+    count = other.count;
+    capacity = other.capacity;
+    storage = other.storage;
+    other.count = 0;
+    other.capacity = 0;
+    other.storage = nullptr;
+  }
+  return *this;
+}
+
+FourMomentumBlock::~FourMomentumBlock()
+{
+  free_columns(storage);
+}
+
+void FourMomentumBlock::reallocate(std::size_t new_capacity)
+{
+  new_capacity = padded_capacity(new_capacity);
+  double* new_storage = allocate_columns(new_capacity);
+  for(std::size_t column = 0; count > 0 && column < 4; ++column)
+  {
+    std::memcpy(new_storage + column * new_capacity, storage + column * capacity, count * sizeof(double));
+  }
+  free_columns(storage);
+  storage = new_storage;
+  capacity = new_capacity;
+}
+
+void FourMomentumBlock::reserve(std::size_t new_capacity)
+{
+  if(new_capacity > capacity)
+  {
+    reallocate(new_capacity);
+  }
+}
+
+void FourMomentumBlock::resize(std::size_t new_size)
+{
+  reserve(new_size);
+  for(std::size_t i = count; i < new_size; ++i)
+  {
+    e()[i] = px()[i] = py()[i] = pz()[i] = 0;
+  }
+  count = new_size;
+}
+
+void FourMomentumBlock::push_back(double E, double px_value, double py_value, double pz_value)
+{
+  if(count == capacity)
+  {
+    reallocate(std::max<std::size_t>(2 * capacity, doubles_per_line));
+  }
+  e()[count] = E;
+  px()[count] = px_value;
+  py()[count] = py_value;
+  pz()[count] = pz_value;
+  ++count;
+}
+
+void FourMomentumBlock::push_back(const FourMomentum& momentum)
+{
+  push_back(momentum.get_e(), momentum.get_px(), momentum.get_py(), momentum.get_pz());
+}
+
+FourMomentum FourMomentumBlock::operator[](std::size_t i) const
+{
+  return FourMomentum(e()[i], px()[i], py()[i], pz()[i]);
+}
+
+FourMomentumBlock::Reference& FourMomentumBlock::Reference::operator=(const FourMomentum& momentum)
+{
+  block.e()[index] = momentum.get_e();
+  block.px()[index] = momentum.get_px();
+  block.py()[index] = momentum.get_py();
+  block.pz()[index] = momentum.get_pz();
+  return *this;
+}
+
+FourMomentumBlock::Reference::operator FourMomentum() const
+{
+  return static_cast<const FourMomentumBlock&>(block)[index];
+}
+
+FourMomentum FourMomentumBlock::sum() const
+{
+  // Independent accumulators per lane keep the reduction free of a serial dependency chain
+  constexpr std::size_t lanes = 4;
+  double total[4][lanes] = {};
+  const double* columns[4] = {e(), px(), py(), pz()};
+  std::size_t blocked = count / lanes * lanes;
+
+  for(std::size_t column = 0; column < 4; ++column)
+  {
+    const double* __restrict values = columns[column];
+    for(std::size_t i = 0; i < blocked; i += lanes)
+    {
+      for(std::size_t lane = 0; lane < lanes; ++lane)
+      {
+        total[column][lane] += values[i + lane];
+      }
+    }
+    for(std::size_t i = blocked; i < count; ++i)
+    {
+      total[column][0] += values[i];
+    }
+  }
+
+  double sums[4];
+  for(std::size_t column = 0; column < 4; ++column)
+  {
+    sums[column] = (total[column][0] + total[column][1]) + (total[column][2] + total[column][3]);
+  }
+  return FourMomentum(sums[0], sums[1], sums[2], sums[3]);
+}
+
+void add(const FourMomentumBlock& lhs, const FourMomentumBlock& rhs, FourMomentumBlock& out)
+{
+  check_sizes(lhs.size(), rhs.size());
+  if(&out == &lhs || &out == &rhs)
+  { // Resizing 'out' could move the input's columns, and the loop below assumes they do not overlap
+    throw std::invalid_argument("add() needs an output block separate from its inputs.");
+  }
+  std::size_t n = lhs.size();
+  out.resize(n);
+  const double* __restrict lhs_columns[4] = {lhs.e(), lhs.px(), lhs.py(), lhs.pz()};
+  const double* __restrict rhs_columns[4] = {rhs.e(), rhs.px(), rhs.py(), rhs.pz()};
+  double* out_columns[4] = {out.e(), out.px(), out.py(), out.pz()};
+
+  for(std::size_t column = 0; column < 4; ++column)
+  {
+    const double* __restrict a = lhs_columns[column];
+    const double* __restrict b = rhs_columns[column];
+    double* __restrict result = out_columns[column];
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      result[i] = a[i] + b[i];
+    }
+  }
+}
+
+void dot_product(const FourMomentumBlock& lhs, const FourMomentumBlock& rhs, double* out)
+{
+  check_sizes(lhs.size(), rhs.size());
+  std::size_t n = lhs.size();
+  const double* __restrict e1 = lhs.e();
+  const double* __restrict px1 = lhs.px();
+  const double* __restrict py1 = lhs.py();
+  const double* __restrict pz1 = lhs.pz();
+  const double* __restrict e2 = rhs.e();
+  const double* __restrict px2 = rhs.px();
+  const double* __restrict py2 = rhs.py();
+  const double* __restrict pz2 = rhs.pz();
+  double* __restrict result = out;
+
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    // Metric signature (+, -, -, -)
+    result[i] = e1[i] * e2[i] - (px1[i] * px2[i] + py1[i] * py2[i] + pz1[i] * pz2[i]);
+  }
+}
+
+void invariant_mass(const FourMomentumBlock& block, double* out)
+{
+  const double* __restrict e = block.e();
+  const double* __restrict px = block.px();
+  const double* __restrict py = block.py();
+  const double* __restrict pz = block.pz();
+  double* __restrict result = out;
+  for(std::size_t i = 0; i < block.size(); ++i)
+  {
+    double mass_squared = e[i] * e[i] - (px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);
+    result[i] = std::sqrt(std::max(mass_squared, 0.0));
+  }
+}
+
+void transverse_momentum(const FourMomentumBlock& block, double* out)
+{
+  const double* __restrict px = block.px();
+  const double* __restrict py = block.py();
+  double* __restrict result = out;
+  for(std::size_t i = 0; i < block.size(); ++i)
+  {
+    result[i] = std::sqrt(px[i] * px[i] + py[i] * py[i]);
+  }
+}
+
+void pseudorapidity(const FourMomentumBlock& block, double* out)
+{
+  transverse_momentum(block, out);
+  const double* __restrict pz = block.pz();
+  double* __restrict result = out;
+  for(std::size_t i = 0; i < block.size(); ++i)
+  {
+    result[i] = std::asinh(pz[i] / std::max(result[i], 1e-300));
+  }
+}
+
+void azimuth(const FourMomentumBlock& block, double* out)
+{
+  const double* __restrict px = block.px();
+  const double* __restrict py = block.py();
+  double* __restrict result = out;
+  for(std::size_t i = 0; i < block.size(); ++i)
+  {
+    result[i] = std::atan2(py[i], px[i]);
+  }
+}
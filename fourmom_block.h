@@ -0,0 +1,83 @@
+#ifndef FOURMOM_BLOCK_H
+#define FOURMOM_BLOCK_H
+
+#include "fourmom.h"
+#include <cstddef>
+
+// Structure-of-arrays storage for many four-momenta: E, px, py and pz each live in their own
+// cache-line-aligned column so the batch kernels below stream through memory and auto-vectorize.
+class FourMomentumBlock
+{
+private:
+  std::size_t count;
+  std::size_t capacity;
+  double* storage; // One aligned allocation holding the four columns back to back
+
+  void reallocate(std::size_t new_capacity);
+
+public:
+  static constexpr std::size_t alignment = 64; // Bytes, one cache line (and a full AVX-512 register)
+
+  // Scalar-compatible view of one row, usable wherever a FourMomentum is read or written
+  class Reference
+  {
+  private:
+    FourMomentumBlock& block;
+    std::size_t index;
+
+  public:
+    Reference(FourMomentumBlock& block, std::size_t index) : block(block), index(index) {}
+    Reference& operator=(const FourMomentum& momentum);
+    operator FourMomentum() const;
+
+    double get_e() const { return block.e()[index]; }
+    double get_px() const { return block.px()[index]; }
+    double get_py() const { return block.py()[index]; }
+    double get_pz() const { return block.pz()[index]; }
+    double invariant_mass() const { return static_cast<FourMomentum>(*this).invariant_mass(); }
+  };
+
+  explicit FourMomentumBlock(std::size_t initial_capacity = 0);
+  FourMomentumBlock(const FourMomentumBlock& other);
+  FourMomentumBlock(FourMomentumBlock&& other) noexcept;
+  FourMomentumBlock& operator=(const FourMomentumBlock& other);
+  FourMomentumBlock& operator=(FourMomentumBlock&& other) noexcept;
+  ~FourMomentumBlock();
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  void reserve(std::size_t new_capacity);
+  void resize(std::size_t new_size); // New rows are zero
+  void clear() { count = 0; }
+
+  void push_back(double E, double px, double py, double pz);
+  void push_back(const FourMomentum& momentum);
+
+  FourMomentum operator[](std::size_t i) const;
+  Reference operator[](std::size_t i) { return Reference(*this, i); }
+
+  // Columns, each aligned to 'alignment' bytes
+  double* e() { return storage; }
+  double* px() { return storage + capacity; }
+  double* py() { return storage + 2 * capacity; }
+  double* pz() { return storage + 3 * capacity; }
+  const double* e() const { return storage; }
+  const double* px() const { return storage + capacity; }
+  const double* py() const { return storage + 2 * capacity; }
+  const double* pz() const { return storage + 3 * capacity; }
+
+  FourMomentum sum() const; // Total four-momentum of all rows
+};
+
+// Batch kernels. Inputs must have equal sizes; 'out' arrays must hold block.size() values. The kernels read their
+// inputs through __restrict pointers, so an output must never overlap an input: pass a separate block or array.
+// add() resizes 'out' and throws std::invalid_argument if it is 'lhs' or 'rhs'; for the others, writing into a
+// block's own column is undefined behaviour.
+void add(const FourMomentumBlock& lhs, const FourMomentumBlock& rhs, FourMomentumBlock& out);
+void dot_product(const FourMomentumBlock& lhs, const FourMomentumBlock& rhs, double* out);
+void invariant_mass(const FourMomentumBlock& block, double* out);
+void transverse_momentum(const FourMomentumBlock& block, double* out);
+void pseudorapidity(const FourMomentumBlock& block, double* out);
+void azimuth(const FourMomentumBlock& block, double* out);
+
+#endif // FOURMOM_BLOCK_H
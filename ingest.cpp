@@ -0,0 +1,313 @@
+#include "ingest.h"
+#include "fourmom.h"
+#include "particle_factory.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+  // Result of parsing one slice of a chunk on one worker
+  struct Piece
+  {
+    std::size_t begin = 0; // Byte offset (CSV) or row index (binary) in the chunk
+    std::size_t end = 0;
+    std::vector<std::shared_ptr<Particle>> particles;
+    std::size_t rows = 0;
+    std::size_t rejected = 0;
+    std::size_t lines = 0; // Lines or rows in the slice, to number errors once every earlier slice is known
+    std::size_t error_at = 0; // Line or row within the slice of the first rejection
+    std::string error;
+  };
+
+  void reject(Piece& piece, std::size_t at, const std::string& message)
+  {
+    if(piece.rejected++ == 0)
+    {
+      piece.error_at = at;
+      piece.error = message;
+    }
+  }
+
+  // Validates one row and builds its particle; rows that fail never allocate
+  void accept(Piece& piece, std::size_t at, Species species, double px, double py, double pz, ColourCharge colour)
+  {
+    if(!std::isfinite(px) || !std::isfinite(py) || !std::isfinite(pz) || !FourMomentum::in_range(px, py, pz))
+    {
+      reject(piece, at, "Momentum component is out of the allowed range.");
+      return;
+    }
+    try
+    {
+      piece.particles.push_back(make_particle(species, px, py, pz, colour));
+    }
+    catch(const std::exception& e)
+    {
+      reject(piece, at, e.what());
+    }
+  }
+
+  std::string_view trim(std::string_view text)
+  {
+    while(!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+    {
+      text.remove_prefix(1);
+    }
+    while(!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+    {
+      text.remove_suffix(1);
+    }
+    return text;
+  }
+
+  bool parse_number(std::string_view text, double& value)
+  {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+  }
+
+  void parse_csv_line(Piece& piece, std::size_t at, std::string_view line)
+  {
+    line = trim(line);
+    if(line.empty() || line.front() == '#')
+    {
+      return;
+    }
+    piece.rows++;
+
+    std::string_view fields[5];
+    std::size_t field_count = 0;
+    while(field_count < 5)
+    {
+      std::size_t comma = line.find(',');
+      fields[field_count++] = trim(line.substr(0, comma));
+      if(comma == std::string_view::npos)
+      {
+        line = {};
+        break;
+      }
+      line.remove_prefix(comma + 1);
+    }
+    if(field_count < 4 || !line.empty())
+    {
+      reject(piece, at, "Expected species,px,py,pz[,colour].");
+      return;
+    }
+
+    Species species;
+    int pdg;
+    auto [pdg_end, pdg_error] = std::from_chars(fields[0].data(), fields[0].data() + fields[0].size(), pdg);
+    bool known = pdg_error == std::errc() && pdg_end == fields[0].data() + fields[0].size() ? species_from_pdg(pdg, species)
+                                                                                            : species_from_name(fields[0], species);
+    if(!known)
+    {
+      reject(piece, at, "Unknown species '" + std::string(fields[0]) + "'.");
+      return;
+    }
+
+    double px, py, pz;
+    if(!parse_number(fields[1], px) || !parse_number(fields[2], py) || !parse_number(fields[3], pz))
+    {
+      reject(piece, at, "Momentum components must be numbers.");
+      return;
+    }
+
+    ColourCharge colour = ColourCharge::Neutral;
+    if(field_count == 5 && !fields[4].empty() && fields[4] != "Neutral" && !colour_charge_from_string(std::string(fields[4]), colour))
+    {
+      reject(piece, at, "Unknown colour '" + std::string(fields[4]) + "'.");
+      return;
+    }
+    accept(piece, at, species, px, py, pz, colour);
+  }
+
+  void parse_csv_piece(const std::string& chunk, Piece& piece)
+  {
+    std::size_t position = piece.begin;
+    while(position < piece.end)
+    {
+      std::size_t newline = chunk.find('\n', position);
+      std::size_t line_end = newline == std::string::npos || newline > piece.end ? piece.end : newline;
+      parse_csv_line(piece, piece.lines, std::string_view(chunk).substr(position, line_end - position));
+      piece.lines++;
+      position = line_end + 1;
+    }
+  }
+
+  void parse_binary_piece(const std::vector<BinaryParticleRow>& chunk, Piece& piece)
+  {
+    for(std::size_t i = piece.begin; i < piece.end; ++i)
+    {
+      const BinaryParticleRow& row = chunk[i];
+      piece.rows++;
+      if(row.species >= species_count || row.colour > static_cast<std::uint8_t>(ColourCharge::Neutral))
+      {
+        reject(piece, i - piece.begin, "Unknown species or colour ID.");
+        continue;
+      }
+      accept(piece, i - piece.begin, static_cast<Species>(row.species), row.px, row.py, row.pz, static_cast<ColourCharge>(row.colour));
+    }
+    piece.lines = piece.end - piece.begin;
+  }
+
+  // Folds a parsed chunk into the totals, numbering its first error from the lines or rows before it
+  void collect(std::vector<Piece>& pieces, std::size_t& line, const char* unit, IngestStats& stats, const IngestSink& sink)
+  {
+    std::vector<std::shared_ptr<Particle>> batch;
+    for(Piece& piece : pieces)
+    {
+      stats.rows += piece.rows;
+      stats.accepted += piece.particles.size();
+      stats.rejected += piece.rejected;
+      if(piece.rejected > 0 && stats.first_error.empty())
+      {
+        stats.first_error = std::string(unit) + " " + std::to_string(line + piece.error_at + 1) + ": " + piece.error;
+      }
+      line += piece.lines;
+      std::move(piece.particles.begin(), piece.particles.end(), std::back_inserter(batch));
+    }
+    if(!batch.empty())
+    {
+      sink(batch);
+    }
+  }
+
+  // Reads up to 'chunk_bytes' more CSV into 'chunk' after whatever 'carry' held, ending on a whole line
+  void read_csv_chunk(std::istream& in, std::size_t chunk_bytes, std::string& carry, std::string& chunk)
+  {
+    chunk.swap(carry);
+    carry.clear();
+    while(in)
+    {
+      std::size_t old_size = chunk.size();
+      chunk.resize(old_size + chunk_bytes);
+      in.read(&chunk[old_size], static_cast<std::streamsize>(chunk_bytes));
+      chunk.resize(old_size + static_cast<std::size_t>(in.gcount()));
+      std::size_t last_newline = chunk.rfind('\n');
+      if(last_newline != std::string::npos && last_newline >= old_size)
+      {
+        carry.assign(chunk, last_newline + 1, std::string::npos);
+        chunk.resize(last_newline + 1);
+        return;
+      }
+      // No newline in what was just read: a line longer than a chunk, so keep reading
+    }
+  }
+
+  // Splits [0, size) into about 4 slices per worker; 'cut' moves a proposed boundary to a valid one
+  template<typename Cut>
+  std::vector<Piece> split(std::size_t size, std::size_t workers, Cut cut)
+  {
+    std::vector<Piece> pieces;
+    std::size_t target = std::max<std::size_t>(size / (workers * 4), 1);
+    for(std::size_t begin = 0; begin < size;)
+    {
+      std::size_t end = std::min(size, cut(begin + target));
+      pieces.emplace_back();
+      pieces.back().begin = begin;
+      pieces.back().end = end;
+      begin = end;
+    }
+    return pieces;
+  }
+}
+
+IngestStats stream_csv(std::istream& in, ThreadPool& pool, const IngestSink& sink, std::size_t chunk_bytes)
+{
+  IngestStats stats;
+  std::size_t line = 0;
+  std::string carry, current, next;
+  read_csv_chunk(in, chunk_bytes, carry, current);
+
+  // A header line, if any, is the first line of the file
+  std::size_t first_line_end = current.find('\n');
+  if(trim(std::string_view(current).substr(0, first_line_end)).substr(0, 7) == "species")
+  {
+    current.erase(0, first_line_end == std::string::npos ? current.size() : first_line_end + 1);
+    line++;
+    if(current.empty())
+    {
+      read_csv_chunk(in, chunk_bytes, carry, current); // The first chunk held only the header
+    }
+  }
+
+  while(!current.empty())
+  {
+    std::vector<Piece> pieces = split(current.size(), pool.size(), [&current](std::size_t at)
+    {
+      std::size_t newline = current.find('\n', at);
+      return newline == std::string::npos ? current.size() : newline + 1;
+    });
+    for(Piece& piece : pieces)
+    {
+      pool.submit([&current, &piece] { parse_csv_piece(current, piece); });
+    }
+    read_csv_chunk(in, chunk_bytes, carry, next); // Overlaps the parse
+    pool.wait();
+    collect(pieces, line, "Line", stats, sink);
+    current.swap(next);
+    next.clear();
+  }
+  return stats;
+}
+
+IngestStats stream_binary(std::istream& in, ThreadPool& pool, const IngestSink& sink, std::size_t chunk_bytes)
+{
+  char magic[8];
+  std::uint32_t version = 0, row_size = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&row_size), sizeof(row_size));
+  if(!in || std::memcmp(magic, BinaryParticleRow::magic, sizeof(magic)) != 0)
+  {
+    throw std::invalid_argument("Not a binary particle file.");
+  }
+  if(version != BinaryParticleRow::version || row_size != sizeof(BinaryParticleRow))
+  {
+    throw std::invalid_argument("Unsupported binary particle file version.");
+  }
+
+  std::size_t rows_per_chunk = std::max<std::size_t>(chunk_bytes / sizeof(BinaryParticleRow), 1);
+  auto read_rows = [&in, rows_per_chunk](std::vector<BinaryParticleRow>& rows)
+  {
+    rows.resize(rows_per_chunk);
+    in.read(reinterpret_cast<char*>(rows.data()), static_cast<std::streamsize>(rows_per_chunk * sizeof(BinaryParticleRow)));
+    std::size_t bytes = static_cast<std::size_t>(in.gcount());
+    if(bytes % sizeof(BinaryParticleRow) != 0)
+    {
+      throw std::invalid_argument("Binary particle file ends part way through a row.");
+    }
+    rows.resize(bytes / sizeof(BinaryParticleRow));
+  };
+
+  IngestStats stats;
+  std::size_t row = 0;
+  std::vector<BinaryParticleRow> current, next;
+  read_rows(current);
+  while(!current.empty())
+  {
+    std::vector<Piece> pieces = split(current.size(), pool.size(), [](std::size_t at) { return at; });
+    for(Piece& piece : pieces)
+    {
+      pool.submit([&current, &piece] { parse_binary_piece(current, piece); });
+    }
+    try
+    {
+      read_rows(next); // Overlaps the parse
+    }
+    catch(...)
+    {
+      pool.wait();
+      throw;
+    }
+    pool.wait();
+    collect(pieces, row, "Row", stats, sink);
+    current.swap(next);
+  }
+  return stats;
+}
@@ -0,0 +1,78 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include "particle.h"
+#include "quark.h"
+#include "species.h"
+#include "thread_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Streaming bulk ingest of particles from CSV or binary files.
+//
+// CSV: one particle per line, "species,px,py,pz[,colour]". Species is a type name as printed (eg AntiMuon, W+) or
+// a PDG code; colour is optional and only used by quarks and gluons. Blank lines, '#' comments and a first line
+// starting with "species" are skipped.
+//
+// Binary: an 8-byte "PCATROWS" tag, a uint32 version and a uint32 row size, then fixed-size BinaryParticleRow
+// records in native byte order.
+//
+// The input is read in chunks of a fixed size while the previous chunk is parsed across a ThreadPool, so memory
+// stays bounded by two chunks. Rows are validated first and particles built only for rows that pass.
+
+struct BinaryParticleRow
+{
+  static constexpr char magic[8] = {'P', 'C', 'A', 'T', 'R', 'O', 'W', 'S'};
+  static constexpr std::uint32_t version = 1;
+
+  double px, py, pz;
+  std::uint8_t species; // Species ID
+  std::uint8_t colour; // ColourCharge, Neutral for the default
+  std::uint8_t padding[6];
+};
+
+struct IngestStats
+{
+  std::size_t rows = 0; // Data rows seen, not counting blank, comment or header lines
+  std::size_t accepted = 0;
+  std::size_t rejected = 0;
+  std::string first_error; // With its line (CSV) or row (binary) number, empty if nothing was rejected
+};
+
+using IngestSink = std::function<void(std::vector<std::shared_ptr<Particle>>&)>;
+
+// Parse 'in' and hand each chunk's particles, in file order, to 'sink' on the calling thread
+IngestStats stream_csv(std::istream& in, ThreadPool& pool, const IngestSink& sink, std::size_t chunk_bytes = 4 << 20);
+IngestStats stream_binary(std::istream& in, ThreadPool& pool, const IngestSink& sink, std::size_t chunk_bytes = 4 << 20);
+
+// Same, adding the particles to any catalogue with add_particle(std::shared_ptr<Particle>)
+template<typename Catalogue>
+IngestStats ingest_csv(std::istream& in, ThreadPool& pool, Catalogue& catalogue, std::size_t chunk_bytes = 4 << 20)
+{
+  return stream_csv(in, pool, [&catalogue](std::vector<std::shared_ptr<Particle>>& batch)
+  {
+    for(auto& particle : batch)
+    {
+      catalogue.add_particle(std::move(particle));
+    }
+  }, chunk_bytes);
+}
+
+template<typename Catalogue>
+IngestStats ingest_binary(std::istream& in, ThreadPool& pool, Catalogue& catalogue, std::size_t chunk_bytes = 4 << 20)
+{
+  return stream_binary(in, pool, [&catalogue](std::vector<std::shared_ptr<Particle>>& batch)
+  {
+    for(auto& particle : batch)
+    {
+      catalogue.add_particle(std::move(particle));
+    }
+  }, chunk_bytes);
+}
+
+#endif // INGEST_H
@@ -9,34 +9,23 @@
 
 class Lepton : public Particle
 {
-protected:
-  int electron_lepton_number;
-  int muon_lepton_number;
-  int tau_lepton_number;
-
 public:
-  Lepton(double mass, double charge, double px, double py, double pz, const std::string& type, bool is_anti,
-         int electron_number = 0, int muon_number = 0, int tau_number = 0);
+  Lepton(double px, double py, double pz, Species species, bool is_anti);
   Lepton(const Lepton& other, bool copy_decay_products = true); // Copy constructor
   Lepton(Lepton&& other) noexcept; // Move constructor
   Lepton& operator=(const Lepton& other); // Copy assignment operator
   Lepton& operator=(Lepton&& other) noexcept; // Move assignment operator
   virtual ~Lepton() = default; // Destructor
 
-  virtual void print() const override;
+  virtual void format_properties(TextFormatter& out) const override;
   virtual void decay() override;
-
-  // Override getters to return the actual numbers
-  virtual int get_electron_lepton_number() const override;
-  virtual int get_muon_lepton_number() const override;
-  virtual int get_tau_lepton_number() const override;
 };
 
 class Electron : public Lepton
 {
 private:
   std::vector<double> calorimeter_deposits;
-  static constexpr double electron_mass = 0.511;
+  static constexpr double electron_mass = species_descriptor(Species::Electron).mass;
 
 public:
   Electron(double px = 0, double py = 0, double pz = 0, std::vector<double> deposits = {}, bool is_anti = false);
@@ -46,9 +35,8 @@ public:
   Electron& operator=(Electron&& other) noexcept; // Move assignment operator
   virtual ~Electron() = default;
 
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
   void decay() override;
-  int get_electron_lepton_number() const override;
   void adjust_calorimeter_deposits();
 
   std::shared_ptr<Particle> clone() const override;
@@ -58,7 +46,7 @@ class Muon : public Lepton
 {
 private:
   bool is_isolated;
-  static constexpr double muon_mass = 105.66;
+  static constexpr double muon_mass = species_descriptor(Species::Muon).mass;
 
 public:
   Muon(double px=0, double py=0, double pz=0, bool isolated = false, bool isAnti = false);
@@ -68,9 +56,11 @@ public:
   Muon& operator=(Muon&& other) noexcept; // Move assignment operator
   virtual ~Muon() = default;
 
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
   void decay() override;
-  int get_muon_lepton_number() const override;
+
+  bool get_isolated() const;
+  void set_isolated(bool isolated); // See ParticleCatalogue::update_muon_isolation
 
   std::shared_ptr<Particle> clone() const override;
 };
@@ -79,7 +69,7 @@ class Tau : public Lepton
 {
 private:
   std::string decay_type;
-  static constexpr double tau_mass = 1776.86;
+  static constexpr double tau_mass = species_descriptor(Species::Tau).mass;
 
 public:
   Tau(double px=0, double py=0, double pz=0, bool isAnti = false);
@@ -90,9 +80,9 @@ public:
   virtual ~Tau() = default;
 
 
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
   void decay() override;
-  int get_tau_lepton_number() const override;
+  void set_decay_channel(const DecayChannel& channel) override;
 
   std::shared_ptr<Particle> clone() const override;
 };
@@ -108,15 +98,13 @@ public:
   ElectronNeutrino& operator=(ElectronNeutrino&& other) noexcept; // Move assignment operator
   virtual ~ElectronNeutrino() = default;
 
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
   void decay() override;
-  int get_electron_lepton_number() const override;
 
   std::shared_ptr<Particle> clone() const override;
 
 private:
   bool has_interacted;
-  static constexpr double electron_neutrino_mass = 0; // Assuming mass is very small for electron neutrinos
 };
 
 class MuonNeutrino : public Lepton
@@ -129,14 +117,12 @@ public:
   MuonNeutrino& operator=(MuonNeutrino&& other) noexcept; // Move assignment operator
   virtual ~MuonNeutrino() = default;
 
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
   void decay() override;
-  int get_muon_lepton_number() const override;
   std::shared_ptr<Particle> clone() const override;
   
 private:
   bool has_interacted;
-  static constexpr double muon_neutrino_mass = 0; // Assuming mass is very small for muon neutrinos
 };
 
 class TauNeutrino : public Lepton
@@ -150,15 +136,13 @@ public:
   virtual ~TauNeutrino() = default;
 
 
-  void print() const override;
+  void format_properties(TextFormatter& out) const override;
   void decay() override;
-  int get_tau_lepton_number() const override;
 
   std::shared_ptr<Particle> clone() const override;
   
 private:
   bool has_interacted;
-  static constexpr double tau_neutrino_mass = 0; // Assumning mass is very small for tau neutrinos
 };
 
 #endif // LEPTON_H
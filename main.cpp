@@ -9,8 +9,8 @@
   of unstable particles (multi-generational-decay is also included), with strict aherence to conservation 
   laws. 
   The user is prompted through inputs about what they want printed. This includes printing all, by particle type,
-  and deep copy demonstration. The number of each particle is printed, including the number of decays.
-  Demonstration of deep-copying particles with and without their original decay products are also printed.
+  and copy demonstration. The number of each particle is printed, including the number of decays.
+  Demonstration of copying particles with and without their original decay products are also printed.
 
   An option to save the outputs to a .txt file is given by the boolean flag 'save_outputs'.
 */
@@ -30,12 +30,15 @@
 #include "bosons.h"
 #include "particle_catalogue.h" 
 #include "particle_factory.h"
+#include "decay_table.h"
+#include "catalogue_snapshot.h"
 
 void interactive_catalogue_print(ParticleCatalogue<Particle>& catalogue, std::shared_ptr<Electron> electron, std::shared_ptr<ZBoson> Z, std::shared_ptr<WBoson> W_minus1);
 void saving_outputs(ParticleCatalogue<Particle>& catalogue);
 
 int main()
 {
+  load_decay_table("decay_table.txt"); // Edited branching ratios take effect without recompiling; built-in channels otherwise
   ParticleCatalogue<Particle> catalogue; // Create a ParticleCatalogue instance
 
   // Electron + Antielectron
@@ -191,16 +194,17 @@ void interactive_catalogue_print(ParticleCatalogue<Particle>& catalogue, std::sh
     }
   } while(true);
 
-  // Deep copy demonstration prompt
+  // Copy demonstration prompt
   while(true)
   {
-    std::cout<<"\nWould you like to see a deep copy demonstration? [y/n]: ";
+    std::cout<<"\nWould you like to see a copy demonstration? [y/n]: ";
     std::getline(std::cin, input);
     std::transform(input.begin(), input.end(), input.begin(), [](unsigned char c) { return std::tolower(c); });
 
     if(input == "y" || input == "yes") 
     {
-      std::cout<<"\nDemonstrating a deep copy of an Electron, Z-Boson (with original decay products copied), and a W boson (without original decay products copied):\n";
+      std::cout<<"\nDemonstrating copies of an Electron, a Z-Boson (sharing the original's decay products, which are only copied "
+               <<"when one side modifies them), and a W boson (without the original's decay products, decayed afresh):\n";
       auto electron_copy = std::make_shared<Electron>(*electron);
       auto z_boson_copy_with_decay_products = std::make_shared<ZBoson>(*Z, true);
       auto W_minus_copy = std::make_shared<WBoson>(*W_minus1, false);
@@ -208,13 +212,21 @@ void interactive_catalogue_print(ParticleCatalogue<Particle>& catalogue, std::sh
       electron_copy->print();
       std::cout<<"\n";
       z_boson_copy_with_decay_products->print();
+      if(!z_boson_copy_with_decay_products->get_decay_products().empty())
+      { // Modifying a product through the copy gives the copy its own, leaving the original's untouched
+        std::cout<<"First decay product shared with the original Z-Boson: "
+                 <<(z_boson_copy_with_decay_products->decay_product_shared(0) ? "yes" : "no");
+        z_boson_copy_with_decay_products->mutable_decay_product(0);
+        std::cout<<", and after modifying it through the copy: "
+                 <<(z_boson_copy_with_decay_products->decay_product_shared(0) ? "yes" : "no")<<"\n";
+      }
       std::cout<<"\n";
       W_minus_copy->print();
       break;
     } 
     else if(input == "n" || input == "no") 
     {
-      std::cout<<"Skipping deep copy demonstration.\n";
+      std::cout<<"Skipping copy demonstration.\n";
       break;
     } 
     else 
@@ -268,20 +280,25 @@ void saving_outputs(ParticleCatalogue<Particle>& catalogue)
     return; // Exit
   }
 
-  // Redirect cout's buffer to the file
-  auto old_buf = std::cout.rdbuf();
-  std::cout.rdbuf(out_file.rdbuf());
-
-  // Perform operations which print to cout
-  catalogue.print_all();
-  catalogue.sum_all();
-
-  // Flush the stream to ensure all content is written to the file
-  std::cout.flush();
-
-  // Restore cout's original buffer and close file
-  std::cout.rdbuf(old_buf);
+  // Write straight to the file, starting from and handing back cout's number format as the console output does
+  out_file.flags(std::cout.flags());
+  out_file.precision(std::cout.precision());
+  catalogue.print_all(out_file);
+  catalogue.sum_all(out_file);
+  std::cout.flags(out_file.flags());
+  std::cout.precision(out_file.precision());
   out_file.close();
 
   std::cout<<"File saved to: "<<filename<<std::endl;
+
+  // Binary snapshot alongside, which CatalogueSnapshot can map back in without regenerating anything
+  std::string snapshot_name = "particle_catalogue_" + oss.str() + ".pcat";
+  if(write_snapshot(catalogue, snapshot_name))
+  {
+    std::cout<<"Snapshot saved to: "<<snapshot_name<<std::endl;
+  }
+  else
+  {
+    std::cerr<<"Error writing snapshot."<<std::endl;
+  }
 }
@@ -2,65 +2,125 @@
 #include "quark.h"
 #include "lepton.h"
 #include "fourmom.h"
+#include "fourmom_block.h"
+#include "phase_space.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
-#include <random>
 
-Particle::Particle(double mass, double charge, double spin, double E, double px, double py, double pz, const std::string& type, bool is_anti)
-  : particle_type(type),
-    four_momentum(std::make_unique<FourMomentum>(E, px, py, pz)),
-    mass(mass), 
-    charge(charge), 
-    spin(spin),
-    is_antiparticle(is_anti) {}
+// Only particles that have decayed or are observed (eg catalogued) need these, so leaves, which are most particles,
+// never allocate them. A decayed product that nothing observes carries its products and a null pointer.
+struct Particle::Observation
+{
+  std::vector<ParticleObserver*> observers;
+  bool suspended = false;
+  FourMomentum suspended_momentum; // Momentum and decay momentum total when suspended
+  FourMomentum suspended_decay_momentum;
+};
+
+struct Particle::Extras
+{
+  DecayProducts decay_products;
+  std::unique_ptr<Observation> observation;
+};
+
+namespace
+{
+  double on_shell_energy(Species species, double px, double py, double pz)
+  {
+    double mass = species_descriptor(species).mass;
+    return std::sqrt(px*px + py*py + pz*pz + mass*mass);
+  }
+}
+
+Particle::Particle(double px, double py, double pz, Species species, bool is_anti)
+  : species(species),
+    is_antiparticle(is_anti),
+    four_momentum(on_shell_energy(species, px, py, pz), px, py, pz) {}
 
 // Copy constructor
 Particle::Particle(const Particle& other, bool copy_decay_products)
-  : particle_type(other.particle_type),
-    four_momentum(other.four_momentum ? std::make_unique<FourMomentum>(*other.four_momentum) : nullptr),
-    mass(other.mass),
-    charge(other.charge),
-    spin(other.spin),
-    is_antiparticle(other.is_antiparticle)
+  : species(other.species),
+    is_antiparticle(other.is_antiparticle),
+    four_momentum(other.four_momentum)
 {
   if(copy_decay_products)
   {
-    copying_decay_products(other);  // Recursive copy
+    copying_decay_products(other);  // Shares the subtree, see mutable_decay_product
   }
 }
 
 void Particle::copying_decay_products(const Particle& source)
+{ // The products themselves are shared, not copied; whichever tree later modifies one gets its own copy first
+  if(&source == this)
+  {
+    return;
+  }
+  clear_decay_products();  // Clear existing decay products if any
+  if(source.products().empty())
+  {
+    return;
+  }
+  products() = source.products();
+  for(const auto& product : products())
+  {
+    if(product->owners.fetch_add(1, std::memory_order_acq_rel) == 1)
+    {
+      product->parent_particle = nullptr; // Shared with 'source' now, so it has no single parent
+    }
+  }
+  decay_momentum_changed(observed() ? source.get_decay_momentum_total() : FourMomentum()); // Copies are O(1) unless observed
+}
+
+Particle& Particle::mutable_decay_product(std::size_t index)
 {
-  decay_products.clear();  // Clear existing decay products if any
-  for(const auto& dp : source.decay_products)
+  std::shared_ptr<Particle>& product = products()[index];
+  if(product->owners.load(std::memory_order_acquire) > 1)
   {
-    decay_products.push_back(dp->clone());
-    dp->copying_decay_products(*dp);  // Recursive copy
+    std::shared_ptr<Particle> copy = product->clone(); // Shallow: its own products stay shared until they are modified in turn
+    product->owners.fetch_sub(1, std::memory_order_acq_rel);
+    product = std::move(copy);
+    product->owners.fetch_add(1, std::memory_order_acq_rel);
   }
+  product->parent_particle = this; // Ours alone now, so linked to us whichever tree it was first added to
+  return *product;
+}
+
+bool Particle::decay_product_shared(std::size_t index) const
+{
+  return products()[index]->owners.load(std::memory_order_acquire) > 1;
 }
 
 // Move constructor
 Particle::Particle(Particle&& other) noexcept
-  : particle_type(std::move(other.particle_type)),
-    four_momentum(std::move(other.four_momentum)),
-    mass(other.mass),
-    charge(other.charge),
-    spin(other.spin),
+  : species(other.species),
     is_antiparticle(other.is_antiparticle),
-    decay_products(std::move(other.decay_products)) {}
+    four_momentum(other.four_momentum)
+{
+  if(!other.products().empty())
+  {
+    products() = other.take_decay_products();
+    adopt_decay_products();
+  }
+}
 
 // Move assignment operator
 Particle& Particle::operator=(Particle&& other) noexcept
 {
   if(this != &other)
   {
-    particle_type = std::move(other.particle_type);
-    four_momentum = std::move(other.four_momentum);
-    mass = other.mass;
-    charge = other.charge;
-    spin = other.spin;
+    species = other.species;
+    momentum_changed(other.four_momentum - four_momentum);
+    four_momentum = other.four_momentum;
     is_antiparticle = other.is_antiparticle;
-    decay_products = std::move(other.decay_products);
+    clear_decay_products();
+    if(!other.products().empty())
+    {
+      products() = other.take_decay_products();
+      adopt_decay_products();
+    }
+    decay_momentum_changed(observed() ? get_decay_momentum_total() : FourMomentum());
   }
     return *this;
 }
@@ -70,171 +130,368 @@ Particle& Particle::operator=(const Particle& other)
 {
   if(this != &other)
   {
-    particle_type = other.particle_type;
-    mass = other.mass;
-    charge = other.charge;
-    spin = other.spin;
+    species = other.species;
     is_antiparticle = other.is_antiparticle;
-    four_momentum = other.four_momentum ? std::make_unique<FourMomentum>(*other.four_momentum) : nullptr;
-    decay_products.clear();
-    decay_products.reserve(other.decay_products.size());
-    for(const auto& dp : other.decay_products)
-    {
-      decay_products.push_back(dp->clone());;
-    }
+    momentum_changed(other.four_momentum - four_momentum);
+    four_momentum = other.four_momentum;
+    copying_decay_products(other);
   }
   return *this;
 }
 
 // Virtual destructor
-Particle::~Particle() {}
+Particle::~Particle()
+{
+  release_decay_products(); // Decay products can outlive their parent through other shared_ptrs
+}
+
+void Particle::adopt_decay_products()
+{
+  for(const auto& product : products())
+  {
+    if(product->owners.load(std::memory_order_acquire) == 1)
+    {
+      product->parent_particle = this;
+    }
+  }
+}
+
+void Particle::release_decay_products()
+{
+  for(const auto& product : products())
+  {
+    // Only a sole owner can be linked, and reading the link of a shared product would race with copies of other trees
+    if(product->owners.fetch_sub(1, std::memory_order_acq_rel) == 1 && product->parent_particle == this)
+    {
+      product->parent_particle = nullptr;
+    }
+  }
+}
+
+DecayProducts Particle::take_decay_products()
+{
+  FourMomentum removed = observed() ? get_decay_momentum_total() : FourMomentum();
+  DecayProducts taken = std::move(products());
+  products().clear();
+  for(const auto& product : taken)
+  {
+    if(product->parent_particle == this)
+    {
+      product->parent_particle = nullptr;
+    }
+  }
+  decay_momentum_changed(FourMomentum() - removed); // Catalogues observing this particle no longer count them
+  return taken;
+}
+
+const DecayProducts& Particle::products() const
+{
+  static const DecayProducts none;
+  return extras ? extras->decay_products : none;
+}
+
+DecayProducts& Particle::products()
+{
+  if(!extras)
+  {
+    extras = std::make_unique<Extras>();
+  }
+  return extras->decay_products;
+}
+
+Particle::Observation* Particle::observation() const
+{
+  return extras ? extras->observation.get() : nullptr;
+}
+
+void Particle::momentum_changed(const FourMomentum& delta)
+{
+  Observation* observing = observation();
+  if(observing && !observing->suspended)
+  {
+    for(ParticleObserver* observer : observing->observers)
+    {
+      observer->momentum_changed(*this, delta);
+    }
+  }
+  if(parent_particle)
+  {
+    parent_particle->decay_momentum_changed(delta);
+  }
+}
+
+void Particle::decay_momentum_changed(const FourMomentum& delta)
+{
+  for(Particle* particle = this; particle; particle = particle->parent_particle)
+  {
+    Observation* observing = particle->observation();
+    if(observing && !observing->suspended)
+    {
+      for(ParticleObserver* observer : observing->observers)
+      {
+        observer->decay_momentum_changed(*particle, delta);
+      }
+    }
+  }
+}
+
+bool Particle::observed() const
+{
+  for(const Particle* particle = this; particle; particle = particle->parent_particle)
+  {
+    if(particle->observation() && !particle->observation()->observers.empty())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Particle::add_observer(ParticleObserver* observer)
+{
+  if(!extras)
+  {
+    extras = std::make_unique<Extras>();
+  }
+  if(!extras->observation)
+  {
+    extras->observation = std::make_unique<Observation>();
+  }
+  extras->observation->observers.push_back(observer);
+}
+
+void Particle::remove_observer(ParticleObserver* observer)
+{
+  Observation* observing = observation();
+  if(!observing)
+  {
+    return;
+  }
+  auto it = std::find(observing->observers.begin(), observing->observers.end(), observer);
+  if(it != observing->observers.end())
+  {
+    observing->observers.erase(it);
+  }
+}
+
+void Particle::suspend_observers()
+{
+  Observation* observing = observation();
+  if(!observing || observing->observers.empty() || observing->suspended)
+  {
+    return;
+  }
+  observing->suspended = true;
+  observing->suspended_momentum = four_momentum;
+  observing->suspended_decay_momentum = get_decay_momentum_total();
+}
+
+void Particle::resume_observers()
+{
+  Observation* observing = observation();
+  if(!observing || !observing->suspended)
+  {
+    return;
+  }
+  observing->suspended = false;
+  const FourMomentum& before = observing->suspended_momentum;
+  bool moved = four_momentum.get_e() != before.get_e() || four_momentum.get_px() != before.get_px() ||
+               four_momentum.get_py() != before.get_py() || four_momentum.get_pz() != before.get_pz();
+  FourMomentum momentum_delta = four_momentum - before;
+  FourMomentum decay_delta = get_decay_momentum_total() - observing->suspended_decay_momentum;
+  for(ParticleObserver* observer : observing->observers)
+  {
+    if(moved) // Decays leave the particle's own momentum alone, so this is rare
+    {
+      observer->momentum_changed(*this, momentum_delta);
+    }
+    observer->decay_momentum_changed(*this, decay_delta);
+  }
+}
+
+const Particle* Particle::get_parent_particle() const { return parent_particle; }
+
+DecayTreeArena Particle::decay_tree() const
+{
+  return DecayTreeArena(*this);
+}
 
 void Particle::print() const
 {
-  std::cout<<std::fixed<<std::setprecision(2);
-  std::cout<<"Type: "<<particle_type<<"\n"
-           <<"  Mass: "<<mass<<" MeV/c^2\n"
-           <<"  Invariant mass: "<<four_momentum->invariant_mass()<<" MeV/c^2\n"
-           <<"  Charge: "<<charge<<"\n"
-           <<"  Spin: "<<spin<<"\n"
-           <<"  Four-Momentum: ("<<four_momentum->get_e()<<", "<<four_momentum->get_px()
-           <<", "<<four_momentum->get_py()<<", "<<four_momentum->get_pz()<<") MeV/c\n";
+  TextFormatter out(std::cout);
+  print(out);
 }
 
-double Particle::get_mass() const { return mass; }
-double Particle::get_charge() const { return charge; }
-double Particle::get_spin() const { return spin; }
-std::string Particle::get_type() const { return particle_type; }
-bool Particle::get_is_antiparticle() const { return is_antiparticle; }
+void Particle::print(TextFormatter& out) const
+{
+  DecayTreeArena(*this).print(out); // One flattening pass, then a linear scan
+}
 
-double Particle::get_e() const { return four_momentum->get_e(); }
-double Particle::get_px() const { return four_momentum->get_px(); }
-double Particle::get_py() const { return four_momentum->get_py(); }
-double Particle::get_pz() const { return four_momentum->get_pz(); }
+void Particle::print_properties() const
+{
+  TextFormatter out(std::cout);
+  format_properties(out);
+}
 
-int Particle::get_electron_lepton_number() const { return 0; }
-int Particle::get_muon_lepton_number() const { return 0; }
-int Particle::get_tau_lepton_number() const { return 0;}
+void Particle::format_properties(TextFormatter& out) const
+{
+  const SpeciesDescriptor& descriptor = species_descriptor(species);
+  out.fixed(2);
+  out<<"Type: "<<descriptor.name<<"\n"
+     <<"  Mass: "<<descriptor.mass<<" MeV/c^2\n"
+     <<"  Invariant mass: "<<four_momentum.invariant_mass()<<" MeV/c^2\n"
+     <<"  Charge: "<<descriptor.charge<<"\n"
+     <<"  Spin: "<<descriptor.spin<<"\n"
+     <<"  Four-Momentum: ("<<four_momentum.get_e()<<", "<<four_momentum.get_px()
+     <<", "<<four_momentum.get_py()<<", "<<four_momentum.get_pz()<<") MeV/c\n";
+}
 
-double Particle::get_baryon_number() const { return 0; }
-void Particle::add_decay_product(std::shared_ptr<Particle> product) { decay_products.push_back(product); }
-const std::vector<std::shared_ptr<Particle>>& Particle::get_decay_products() const { return decay_products; }
-void Particle::clear_decay_products() { decay_products.clear(); }
+void Particle::decay_with(RandomEngine& rng)
+{
+  ScopedRandomEngine scope(rng);
+  decay();
+}
 
-void Particle::set_momentum(double E, double px, double py, double pz)
+void Particle::set_decay_channel(const DecayChannel&) {} // Nothing to record by default
+
+const SpeciesDescriptor& Particle::get_descriptor() const { return species_descriptor(species); }
+double Particle::get_mass() const { return species_descriptor(species).mass; }
+double Particle::get_charge() const { return species_descriptor(species).charge; }
+double Particle::get_spin() const { return species_descriptor(species).spin; }
+std::string Particle::get_type() const { return std::string(species_name(species)); }
+Species Particle::get_species() const { return species; }
+bool Particle::get_is_antiparticle() const { return is_antiparticle; }
+
+double Particle::get_e() const { return four_momentum.get_e(); }
+double Particle::get_px() const { return four_momentum.get_px(); }
+double Particle::get_py() const { return four_momentum.get_py(); }
+double Particle::get_pz() const { return four_momentum.get_pz(); }
+
+int Particle::get_electron_lepton_number() const { return species_descriptor(species).electron_lepton_number; }
+int Particle::get_muon_lepton_number() const { return species_descriptor(species).muon_lepton_number; }
+int Particle::get_tau_lepton_number() const { return species_descriptor(species).tau_lepton_number; }
+
+double Particle::get_baryon_number() const { return species_descriptor(species).baryon_number; }
+QuantumNumbers Particle::get_quantum_numbers() const { return species_descriptor(species).quantum_numbers; }
+void Particle::add_decay_product(std::shared_ptr<Particle> product)
 {
-  if(!four_momentum)
+  std::uint32_t previous_owners = product->owners.fetch_add(1, std::memory_order_acq_rel);
+  if(previous_owners == 0)
   {
-    four_momentum = std::make_unique<FourMomentum>(E, px, py, pz);
+    product->parent_particle = this;
   }
-  else
+  else if(previous_owners == 1)
   {
-    four_momentum->set_e(E);
-    four_momentum->set_px(px);
-    four_momentum->set_py(py);
-    four_momentum->set_pz(pz);
+    product->parent_particle = nullptr; // Already in another tree, so it is shared now
   }
+  FourMomentum delta = observed() ? product->four_momentum + product->get_decay_momentum_total() : FourMomentum();
+  products().push_back(std::move(product));
+  decay_momentum_changed(delta);
+}
+
+DecayProductsView Particle::get_decay_products() const { return DecayProductsView(products()); }
+void Particle::clear_decay_products()
+{
+  if(products().empty())
+  {
+    return;
+  }
+  FourMomentum removed = observed() ? get_decay_momentum_total() : FourMomentum();
+  release_decay_products();
+  products().clear();
+  decay_momentum_changed(FourMomentum() - removed);
+}
+
+void Particle::set_momentum(double E, double px, double py, double pz)
+{
+  FourMomentum previous = four_momentum;
+  four_momentum.set_e(E);
+  four_momentum.set_px(px);
+  four_momentum.set_py(py);
+  four_momentum.set_pz(pz);
+  momentum_changed(four_momentum - previous);
 }
 
 std::tuple<double, double, double, double> Particle::get_momentum() const
 {
-  return std::make_tuple(four_momentum->get_e(), four_momentum->get_px(), 
-                         four_momentum->get_py(), four_momentum->get_pz());
+  return std::make_tuple(four_momentum.get_e(), four_momentum.get_px(), 
+                         four_momentum.get_py(), four_momentum.get_pz());
+}
+
+const FourMomentum& Particle::get_four_momentum() const { return four_momentum; }
+
+ParticleRecord Particle::record() const
+{
+  ParticleRecord record;
+  record.momentum = four_momentum;
+  record.species = species;
+  record.flags = is_antiparticle ? ParticleRecord::antiparticle_flag : 0;
+  return record;
 }
 
 int Particle::total_decay_products() const
 {
-  int total = decay_products.size(); // Start with direct decay products
-  for(const auto& product : decay_products)
+  int total = 0;
+  for(const auto& product : products())
   {
-    total += product->total_decay_products(); // Recursively count decay products of each decay product
+    total += 1 + product->total_decay_products();
   }
   return total;
 }
 
 FourMomentum Particle::sum_decay_products_fourmomentum() const
 {
-  FourMomentum totalMomentum(0, 0, 0, 0); // Initialize with zero four-momentum for decay products
-  for(const auto& decayProduct : decay_products)
+  return get_decay_momentum_total();
+}
+
+FourMomentum Particle::get_decay_momentum_total() const
+{
+  FourMomentum total;
+  for(const auto& product : products())
   {
-    // Add the four-momentum of the decay product
-    auto [e, px, py, pz] = decayProduct->get_momentum();
-    totalMomentum = totalMomentum + FourMomentum(e, px, py, pz);
+    total += product->four_momentum;
+    total += product->get_decay_momentum_total();
+  }
+  return total;
+}
 
-    // Recursively add the four-momentum of this decay product's decay products
-    totalMomentum = totalMomentum + decayProduct->sum_decay_products_fourmomentum();
+void Particle::append_decay_momenta(FourMomentumBlock& block) const
+{
+  for(const auto& product : products()) // Pre-order, as in decay_tree()
+  {
+    block.push_back(product->four_momentum);
+    product->append_decay_momenta(block);
   }
-  return totalMomentum;
 }
 
-void Particle::distribute_energy_momentum(std::vector<std::shared_ptr<Particle>>& decay_products, double total_energy, double initial_px, double initial_py,
+bool Particle::distribute_energy_momentum(DecayProducts& decay_products, double total_energy, double initial_px, double initial_py,
                                           double initial_pz, double borrowed_energy)
 { // Borrowed energy for virtual particles (eg in Higgs decay to W-W+ or ZZ)
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_real_distribution<> dis(0.0, 1.0);
-
-  for(int iteration = 0; iteration < 5000000; ++iteration)
-  { // Limit iterations to prevent infinite loop
-    double redistributed_energy = total_energy;
-    double remaining_px = initial_px, remaining_py = initial_py, remaining_pz = initial_pz;
-
-    for(size_t i = 0; i < decay_products.size(); ++i)
-    {
-      double mass = decay_products[i]->get_mass() - borrowed_energy;
-      double energy_fraction, px, py, pz;
-            
-      if(iteration == 0 || dis(gen) < 0.5)
-      { // First iteration or 50% chance to explore
-        energy_fraction = redistributed_energy / decay_products.size();
-        double phi = 2.0 * M_PI * dis(gen);
-        double theta = M_PI * dis(gen);
-        double p = std::sqrt(std::max(energy_fraction * energy_fraction - mass * mass, 0.0));
-        px = p * std::sin(theta) * std::cos(phi);
-        py = p * std::sin(theta) * std::sin(phi);
-        pz = p * std::cos(theta);
-      }
-      else
-      { // 50% chance to refine based on the best difference
-        auto [energy, pX, pY, pZ] = decay_products[i]->get_momentum();
-        // Small adjustments towards conservation
-        px = pX * (1 + dis(gen) * 0.1 - 0.05);
-        py = pY * (1 + dis(gen) * 0.1 - 0.05);
-        pz = pZ * (1 + dis(gen) * 0.1 - 0.05);
-        energy_fraction = std::sqrt(px * px + py * py + pz * pz + mass * mass);
-      }
-
-      // Adjust the last particle's momentum to ensure momentum conservation
-      if(i == decay_products.size() - 1)
-      {
-        px = remaining_px;
-        py = remaining_py;
-        pz = remaining_pz;
-        energy_fraction = std::sqrt(px * px + py * py + pz * pz + mass * mass);
-      }
-      else
-      {
-        remaining_px -= px;
-        remaining_py -= py;
-        remaining_pz -= pz;
-      }
-
-      decay_products[i]->set_momentum(energy_fraction, px, py, pz);
-      redistributed_energy -= energy_fraction;
-    }
+  FourMomentum initial_momentum(total_energy, initial_px, initial_py, initial_pz);
+  std::vector<double> masses;
+  masses.reserve(decay_products.size());
+  double mass_sum = 0;
+  for(const auto& product : decay_products)
+  {
+    masses.push_back(product->get_mass() - borrowed_energy);
+    mass_sum += masses.back();
+  }
 
-    // Check if this iteration is better
-    if(check_conservation(decay_products, total_energy, initial_px, initial_py, initial_pz))
-    {
-      std::cout<<"Energy and momentum conservation for "<<particle_type<<" decay achieved in "<<iteration + 1<<" iterations."<<std::endl;
-      return;
-    }
+  if(mass_sum > initial_momentum.invariant_mass() * (1 + 1e-9))
+  {
+    return false; // Four-momentum could not be conserved
   }
 
-  std::cout<<"Failed to achieve conservation for "<<particle_type<<" decay within iteration limit."<<std::endl;
+  // Exact phase-space point: conserves four-momentum and puts every product on its mass shell in one pass
+  std::vector<FourMomentum> momenta = n_body_decay(initial_momentum, masses, thread_random_engine());
+  for(size_t i = 0; i < decay_products.size(); ++i)
+  {
+    decay_products[i]->set_momentum(momenta[i].get_e(), momenta[i].get_px(), momenta[i].get_py(), momenta[i].get_pz());
+  }
+  return true;
 }
 
-bool Particle::check_conservation(const std::vector<std::shared_ptr<Particle>>& decay_products, double initial_energy, double initial_px, double initial_py, double initial_pz)
+bool Particle::check_conservation(const DecayProducts& decay_products, double initial_energy, double initial_px, double initial_py, double initial_pz)
 {
   double total_energy = 0.0, total_px = 0.0, total_py = 0.0, total_pz = 0.0;
   for(const auto& particle : decay_products)
@@ -253,61 +510,44 @@ bool Particle::check_conservation(const std::vector<std::shared_ptr<Particle>>&
          std::abs(total_pz - initial_pz) < tolerance_e;
 }
 
-bool Particle::check_lepton_number_conservation(int initial_electron_number, int initial_muon_number, int initial_tau_number, 
-                                                 const std::vector<std::shared_ptr<Particle>>& decay_products)
-{ // Check there is lepton number conservation for the decay products
-  int final_electron_number = 0, final_muon_number = 0, final_tau_number = 0;
-
-  // Calculate final lepton numbers
-  for(const auto& product : decay_products)
+namespace
+{
+  QuantumNumbers sum_quantum_numbers(const DecayProducts& decay_products)
   {
-    final_electron_number += product->get_electron_lepton_number();
-    final_muon_number += product->get_muon_lepton_number();
-    final_tau_number += product->get_tau_lepton_number();
+    QuantumNumbers total = 0;
+    for(const auto& product : decay_products)
+    {
+      total = add_quantum_numbers(total, product->get_quantum_numbers());
+    }
+    return total;
   }
-
-  // Check conservation for each lepton family
-  return (initial_electron_number == final_electron_number) &&
-         (initial_muon_number == final_muon_number) &&
-         (initial_tau_number == final_tau_number);
 }
 
-bool Particle::check_baryon_number_conservation(const std::vector<std::shared_ptr<Particle>>& decay_products)
-{ // Check there is baryon number conservation for the decay products
-  double initial_baryon_number = this->get_baryon_number();
-  double final_baryon_number = 0.0;
-
-  // Calculate final baryon number
-  for(const auto& product : decay_products)
-  {
-    final_baryon_number += product->get_baryon_number();
-  }
-
-  // Check conservation of baryon number
-  return initial_baryon_number == final_baryon_number;
+bool Particle::check_lepton_number_conservation(int initial_electron_number, int initial_muon_number, int initial_tau_number, 
+                                                 const DecayProducts& decay_products)
+{ // Check there is lepton number conservation for the decay products
+  QuantumNumbers initial = pack_quantum_numbers(0, 0, initial_electron_number, initial_muon_number, initial_tau_number, 0);
+  return (::quantum_number_violations(initial, sum_quantum_numbers(decay_products)) & lepton_number_lanes) == 0;
 }
-
-bool Particle::check_charge_conservation(const std::vector<std::shared_ptr<Particle>>& decay_products) const
-{ // Check there is charge conservation for the decay products
-  double initial_charge = this->get_charge(); // Assume getCharge() returns the charge in integer format
-  double final_charge = 0;
-
-  // Sum the charge of all decay products
-  for(const auto& product : decay_products)
-  {
-    final_charge += product->get_charge();
-  }
-
-  // Check if the total charge is conserved
-  return initial_charge == final_charge;
+bool Particle::check_baryon_number_conservation(const DecayProducts& decay_products)
+{ // Check there is baryon number conservation for the decay products, exactly in thirds
+  return (quantum_number_violations(decay_products) & quantum_lane_mask(QuantumLane::BaryonThirds)) == 0;
+}
+bool Particle::check_charge_conservation(const DecayProducts& decay_products) const
+{ // Check there is charge conservation for the decay products, exactly in thirds
+  return (quantum_number_violations(decay_products) & quantum_lane_mask(QuantumLane::ChargeThirds)) == 0;
+}
+QuantumNumbers Particle::quantum_number_violations(const DecayProducts& decay_products) const
+{
+  return ::quantum_number_violations(get_quantum_numbers(), sum_quantum_numbers(decay_products));
 }
 
-bool Particle::check_invariant_mass(const std::vector<std::shared_ptr<Particle>>& decay_products, double borrowed_energy) const
+bool Particle::check_invariant_mass(const DecayProducts& decay_products, double borrowed_energy) const
 { // Check the invariant mass of decay products equal rest mass (for non-virtual particles)
   int n = 0;
   for(const auto& product : decay_products)
   {
-    double calc_invariant_mass = product->four_momentum->invariant_mass();
+    double calc_invariant_mass = product->four_momentum.invariant_mass();
     double actual_mass = product->get_mass();
     double tolerance = 1e-2; // Same tolerance as given for energy and momentum conservation
     if((std::abs(calc_invariant_mass - actual_mass) > tolerance) && (borrowed_energy == 0)) // Borrowed energy included to ignore virtual particles
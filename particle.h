@@ -2,39 +2,142 @@
 #define PARTICLE_H
 
 #include "fourmom.h"
+#include "decay_tree_arena.h"
+#include "particle_record.h"
+#include "species_descriptor.h"
+#include "species.h"
+#include "random_engine.h"
+#include "small_vector.h"
+#include "text_formatter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <vector>
 #include <tuple>
 
+class FourMomentumBlock;
+class Particle;
+struct DecayChannel;
+
+// Direct decay products of a particle. Nearly every decay has two to four, which are stored in the block a decayed
+// particle allocates for them (see Particle::Extras), so leaves do not carry the space.
+using DecayProducts = SmallVector<std::shared_ptr<Particle>, 4>;
+
+// Read-only view of a particle's direct decay products. They may be shared with copies of the tree, so they are only
+// handed out as const; Particle::mutable_decay_product gives a product of this tree alone to modify in place.
+class DecayProductsView
+{
+private:
+  const DecayProducts* products;
+
+public:
+  class iterator
+  {
+  private:
+    const std::shared_ptr<Particle>* position;
+
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = Particle;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Particle*;
+    using reference = const Particle&;
+
+    explicit iterator(const std::shared_ptr<Particle>* position) : position(position) {}
+    reference operator*() const { return **position; }
+    pointer operator->() const { return position->get(); }
+    iterator& operator++() { ++position; return *this; }
+    iterator operator++(int) { iterator old = *this; ++position; return old; }
+    iterator& operator--() { --position; return *this; }
+    iterator operator--(int) { iterator old = *this; --position; return old; }
+    bool operator==(const iterator& other) const { return position == other.position; }
+    bool operator!=(const iterator& other) const { return position != other.position; }
+  };
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+  explicit DecayProductsView(const DecayProducts& products) : products(&products) {}
+
+  std::size_t size() const { return products->size(); }
+  bool empty() const { return products->empty(); }
+  const Particle& operator[](std::size_t i) const { return *(*products)[i]; }
+  std::shared_ptr<const Particle> shared(std::size_t i) const { return (*products)[i]; } // Keeps a product alive on its own
+
+  iterator begin() const { return iterator(products->begin()); }
+  iterator end() const { return iterator(products->end()); }
+  reverse_iterator rbegin() const { return reverse_iterator(end()); }
+  reverse_iterator rend() const { return reverse_iterator(begin()); }
+};
+
+// Told about every change to an observed particle's own four-momentum and to the running total of its decay products
+class ParticleObserver
+{
+public:
+  virtual void momentum_changed(const Particle& particle, const FourMomentum& delta) = 0;
+  virtual void decay_momentum_changed(const Particle& particle, const FourMomentum& delta) = 0;
+
+protected:
+  ~ParticleObserver() = default;
+};
+
+// Base of every particle type: one cache line holding the species ID, momentum, tree links and a pointer to the
+// extras that only decayed or observed particles allocate. Trees link particles through shared_ptr, not by index,
+// so copies can share subtrees; DecayTreeArena flattens a tree into index-linked ParticleRecords when that is wanted.
 class Particle
 {
 protected:
-  std::string particle_type;
-  std::unique_ptr<FourMomentum> four_momentum;
-  double mass;
-  double charge;
-  double spin;
+  struct Observation; // Observers, and what they were last told while suspended
+  struct Extras; // Decay products and observation, allocated the first time either is needed
+
+  Species species;
   bool is_antiparticle;
-  std::vector<std::shared_ptr<Particle>> decay_products;
+  // How many particles list this one as a decay product. Above one, copies of a tree share it and it is copied
+  // before being modified; its parent link is then null, as it has no single parent. Atomic, and the parent link only
+  // changes as the count passes one, so trees sharing a subtree can be copied and destroyed on
+  // different threads. Modifying a tree still needs it to have a single writer, as everywhere else.
+  std::atomic<std::uint32_t> owners{0};
+  FourMomentum four_momentum; // Stored inline, no separate allocation
+  Particle* parent_particle = nullptr; // Non-owning, set while this particle is the decay product of one parent only
+  std::unique_ptr<Extras> extras; // Null for leaves; observers are not copied or moved with the particle
+
+  const DecayProducts& products() const; // Empty, without allocating, for a leaf
+  DecayProducts& products(); // Allocates the extras on first use
+  Observation* observation() const; // nullptr unless observers were ever added
+
+  void momentum_changed(const FourMomentum& delta); // Reports a change of this particle's own momentum
+  void decay_momentum_changed(const FourMomentum& delta); // Reports 'delta' to observers of this particle and its ancestors, invalidating their trees
+  bool observed() const; // Whether this particle or an ancestor has observers, ie whether decay momentum changes are reported
+  void adopt_decay_products(); // Points the parent link of every direct decay product this particle alone owns at it
+  void release_decay_products(); // Drops this particle's ownership of its direct decay products, unlinking them
+  DecayProducts take_decay_products(); // Hands its products, with their ownership, to a particle moved from this one
 
 public:
-  Particle(double mass, double charge, double spin, double E, double px, double py, double pz, const std::string& type, bool is_anti);
-  Particle(const Particle& other, bool copy_decay_products = true); // Copy constructor
+  Particle(double px, double py, double pz, Species species, bool is_anti); // Energy from the species' rest mass
+  Particle(const Particle& other, bool copy_decay_products = true); // Copy constructor, O(1) in the size of the decay tree
   Particle& operator=(const Particle& other); // Copy assignment operator
   Particle(Particle&& other) noexcept;
   Particle& operator=(Particle&& other) noexcept;
   virtual ~Particle();
 
-  virtual void decay() = 0; // Pure virtual function for decay mechanisms
-  virtual void print() const;
+  virtual void decay() = 0; // Pure virtual function for decay mechanisms, draws from thread_random_engine()
+  void decay_with(RandomEngine& rng); // Decay (including subsequent decays) using the caller's random stream
+  virtual void set_decay_channel(const DecayChannel& channel); // Called once a channel is chosen, eg to record its decay type
+  void print() const; // Prints this particle and every (subsequent) decay product
+  void print(TextFormatter& out) const;
+  void print_properties() const; // Prints this particle's own fields only
+  virtual void format_properties(TextFormatter& out) const; // Renders them, overridden to add each type's fields
   virtual std::shared_ptr<Particle> clone() const = 0;
 
+  // Per-species constants, read from species_descriptor() rather than stored in each particle
+  const SpeciesDescriptor& get_descriptor() const;
   double get_mass() const;
   double get_charge() const;
   double get_spin() const;
   std::string get_type() const;
+  Species get_species() const;
   bool get_is_antiparticle() const;
 
   double get_e() const;
@@ -42,33 +145,59 @@ public:
   double get_py() const;
   double get_pz() const;
 
-  virtual int get_electron_lepton_number() const;
-  virtual int get_muon_lepton_number() const;
-  virtual int get_tau_lepton_number() const;
-  virtual double get_baryon_number() const;
+  int get_electron_lepton_number() const;
+  int get_muon_lepton_number() const;
+  int get_tau_lepton_number() const;
+  double get_baryon_number() const;
+  QuantumNumbers get_quantum_numbers() const;
 
   void set_momentum(double E, double px, double py, double pz);
   std::tuple<double, double, double, double> get_momentum() const;
+  const FourMomentum& get_four_momentum() const;
+  ParticleRecord record() const; // Compact copy of this particle, without tree links
 
+  // Makes this particle's decay products those of 'source'. Nothing is copied: the subtree is shared, as it is by
+  // the copy constructor and clone(), and each shared product is only copied when one side asks to modify it
+  // through mutable_decay_product.
   void copying_decay_products(const Particle& source);
 
   int total_decay_products() const;
   void add_decay_product(std::shared_ptr<Particle> product);
-  const std::vector<std::shared_ptr<Particle>>& get_decay_products() const;
+  DecayProductsView get_decay_products() const; // Read-only, as products may be shared with copies
+  Particle& mutable_decay_product(std::size_t index); // Copy-on-write access to one product, for modifying it in place
+  bool decay_product_shared(std::size_t index) const; // Whether another tree lists the same product object
   void clear_decay_products();
+  // A flattened copy of this particle and all its (subsequent) decay products in pre-order, built on each call. The
+  // particles themselves stay linked by shared_ptr; keep the arena while it is needed rather than calling this again.
+  DecayTreeArena decay_tree() const;
 
   FourMomentum sum_decay_products_fourmomentum() const;
+  FourMomentum get_decay_momentum_total() const; // The same total, under the name the observers use
+  void add_observer(ParticleObserver* observer);
+  void remove_observer(ParticleObserver* observer); // Removes one registration
+  // Between these, changes are not reported to this particle's own observers, so it can be decayed on another
+  // thread; resume_observers() then reports the net change of its momentum and decay momentum in one call each.
+  void suspend_observers();
+  void resume_observers();
+  const Particle* get_parent_particle() const; // nullptr unless this is the decay product of a single parent
+  void append_decay_momenta(FourMomentumBlock& block) const; // Appends the four-momenta of all (subsequent) decay products
 
   bool check_lepton_number_conservation(int initial_electron_number, int initial_muon_number, int initial_tau_number, 
-                                   const std::vector<std::shared_ptr<Particle>>& decay_products);
+                                   const DecayProducts& decay_products);
     
-  bool check_baryon_number_conservation(const std::vector<std::shared_ptr<Particle>>& decay_products);
-  bool check_charge_conservation(const std::vector<std::shared_ptr<Particle>>& decay_products) const;
-  void distribute_energy_momentum(std::vector<std::shared_ptr<Particle>>& decay_products, double total_energy, double initial_px,
+  bool check_baryon_number_conservation(const DecayProducts& decay_products);
+  bool check_charge_conservation(const DecayProducts& decay_products) const;
+  // Every conservation law at once: nonzero in the lane (see quantum_numbers.h) of each one the products violate
+  QuantumNumbers quantum_number_violations(const DecayProducts& decay_products) const;
+  // Gives the products a phase-space point that conserves the initial four-momentum. Returns false, leaving them
+  // untouched, if their masses (less 'borrowed_energy' each) add up to more than the initial invariant mass.
+  bool distribute_energy_momentum(DecayProducts& decay_products, double total_energy, double initial_px,
      double initial_py, double initial_pz, double borrowed_energy);
-  bool check_conservation(const std::vector<std::shared_ptr<Particle>>& decay_products, double initial_energy, double initial_px, double initial_py, double initial_pz);
-  bool check_invariant_mass(const std::vector<std::shared_ptr<Particle>>& decay_products, double borrowed_energy) const;
+  bool check_conservation(const DecayProducts& decay_products, double initial_energy, double initial_px, double initial_py, double initial_pz);
+  bool check_invariant_mass(const DecayProducts& decay_products, double borrowed_energy) const;
 
 };
 
+static_assert(sizeof(Particle) <= 64, "Particle must fit in one cache line; put rarely used state in Particle::Extras");
+
 #endif // PARTICLE_H
\ No newline at end of file
@@ -1,138 +1,775 @@
 #ifndef PARTICLE_CATALOGUE_H
 #define PARTICLE_CATALOGUE_H
 
-#include <unordered_map>
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <iostream>
 #include <memory>
 #include <iomanip>
-#include <map>
+#include <string_view>
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 #include "particle.h" 
+#include "fourmom_block.h"
+#include "decay_table.h"
+#include "random_engine.h"
+#include "thread_pool.h"
+#include "particle_view.h"
+#include "catalogue_index.h"
+#include "angular_index.h"
+#include "lepton.h"
+
+// Stable reference to a particle in a ParticleCatalogue. It stays valid while the particle is in the catalogue, however
+// many others are added or removed; once the particle is removed the slot's generation moves on and the handle goes stale.
+struct ParticleHandle
+{
+  std::uint32_t index = UINT32_MAX;
+  std::uint32_t generation = 0;
+
+  bool operator==(const ParticleHandle& other) const { return index == other.index && generation == other.generation; }
+  bool operator!=(const ParticleHandle& other) const { return !(*this == other); }
+};
 
 // Using the template prevents this file from being split into interface and implementation.
 template<typename T>
-class ParticleCatalogue
+class ParticleCatalogue : private ParticleObserver
 {
 private:
-  // Map from particle type to a list of particles of that type
-  std::unordered_map<std::string, std::vector<std::shared_ptr<T>>> particles_by_type;
+  // Dense, swap-and-pop array of one species' particles, with the slot that owns each one so it can be repointed
+  struct Bucket
+  {
+    std::vector<std::shared_ptr<T>> particles;
+    std::vector<std::uint32_t> slots;
+  };
+  using Buckets = std::array<Bucket, species_count>;
+
+  // One bucket per species, indexed by its dense ID: no hashing or string building on insert or lookup
+  Buckets particles_by_species;
+
+  // Slot map behind ParticleHandle. A live slot holds its particle's species and position in the bucket;
+  // a free one holds the next free slot in 'position'. Generations are bumped on removal so old handles go stale.
+  struct Slot
+  {
+    std::uint32_t generation = 0;
+    std::uint32_t position = 0;
+    Species species = Species::Electron;
+    bool live = false;
+  };
+  static constexpr std::uint32_t no_slot = UINT32_MAX;
+  std::vector<Slot> slots;
+  std::uint32_t free_slot = no_slot; // Head of the free list
+
+  const Slot* find_slot(ParticleHandle handle) const
+  {
+    if(handle.index >= slots.size() || !slots[handle.index].live || slots[handle.index].generation != handle.generation)
+    {
+      return nullptr;
+    }
+    return &slots[handle.index];
+  }
+
+  // Swaps the particle with the last of its type, pops it and frees its slot
+  void erase_at(Bucket& bucket, std::uint32_t position)
+  {
+    const std::shared_ptr<T>& particle = bucket.particles[position];
+    particle->remove_observer(this);
+    --particle_count;
+    base_momentum_total -= particle->get_four_momentum();
+    decay_momentum_total -= particle->get_decay_momentum_total();
+
+    unindex_particle(bucket.slots[position], *particle);
+    Slot& slot = slots[bucket.slots[position]];
+    slot.live = false;
+    ++slot.generation;
+    slot.position = free_slot;
+    free_slot = bucket.slots[position];
+
+    if(position + 1 != bucket.particles.size())
+    {
+      bucket.particles[position] = std::move(bucket.particles.back());
+      bucket.slots[position] = bucket.slots.back();
+      slots[bucket.slots[position]].position = position;
+    }
+    bucket.particles.pop_back();
+    bucket.slots.pop_back();
+  }
+
+  void start_observing()
+  {
+    for(T& particle : all_particles())
+    {
+      particle.add_observer(this);
+    }
+  }
+
+  const Bucket* find_bucket(std::string_view type) const // nullptr for an unknown type name
+  {
+    Species species;
+    return species_from_name(type, species) ? &particles_by_species[species_index(species)] : nullptr;
+  }
+
+  // Running aggregates, updated as particles are added or removed and as their momenta and decay products change
+  std::size_t particle_count = 0;
+  FourMomentum base_momentum_total;
+  FourMomentum decay_momentum_total;
+
+  // Optional secondary indexes over slots, see enable_index
+  std::array<SortedIndex, sorted_index_count> sorted_indexes;
+  std::array<bool, sorted_index_count> sorted_enabled{};
+  ChargeBitmaps charge_index;
+  bool charge_enabled = false;
+  std::unordered_multimap<const Particle*, std::uint32_t> indexed_slots; // Finds the slots to re-key when a momentum changes
+
+  bool any_sorted_index() const
+  {
+    return std::find(sorted_enabled.begin(), sorted_enabled.end(), true) != sorted_enabled.end();
+  }
+
+  void index_particle(std::uint32_t slot, const T& particle)
+  {
+    for(std::size_t i = 0; i < sorted_index_count; ++i)
+    {
+      if(sorted_enabled[i])
+      {
+        sorted_indexes[i].insert(slot, index_key(static_cast<ParticleIndex>(i), particle.get_four_momentum()));
+      }
+    }
+    if(any_sorted_index())
+    {
+      indexed_slots.emplace(&particle, slot);
+    }
+    if(charge_enabled)
+    {
+      charge_index.set(slot, particle.get_charge());
+    }
+  }
+
+  void unindex_particle(std::uint32_t slot, const T& particle)
+  {
+    for(std::size_t i = 0; i < sorted_index_count; ++i)
+    {
+      if(sorted_enabled[i])
+      {
+        sorted_indexes[i].erase(slot);
+      }
+    }
+    auto range = indexed_slots.equal_range(&particle);
+    for(auto it = range.first; it != range.second; ++it)
+    {
+      if(it->second == slot)
+      {
+        indexed_slots.erase(it);
+        break;
+      }
+    }
+    if(charge_enabled)
+    {
+      charge_index.reset(slot);
+    }
+  }
+
+  void rebuild_indexes()
+  {
+    for(SortedIndex& index : sorted_indexes)
+    {
+      index.clear();
+    }
+    charge_index.clear();
+    indexed_slots.clear();
+    for(const Bucket& bucket : particles_by_species)
+    {
+      for(std::size_t i = 0; i < bucket.particles.size(); ++i)
+      {
+        index_particle(bucket.slots[i], *bucket.particles[i]);
+      }
+    }
+  }
+
+  const T& particle_at(std::uint32_t slot) const
+  {
+    return *particles_by_species[species_index(slots[slot].species)].particles[slots[slot].position];
+  }
+
+  // Calls f(slot) for every particle whose 'index' quantity lies in [low, high], from the index if it is enabled
+  // and by a scan of the catalogue otherwise
+  template<typename F>
+  void for_each_slot_in_range(ParticleIndex index, double low, double high, F f) const
+  {
+    if(index == ParticleIndex::Charge && charge_enabled)
+    {
+      if(std::isnan(low) || std::isnan(high) || low > high)
+      {
+        return;
+      }
+      // The bitmaps only hold charges within +-1, so clamping keeps infinite or huge bounds to a few iterations
+      low = std::clamp(low, -3.0, 3.0);
+      high = std::clamp(high, -3.0, 3.0);
+      for(long thirds = std::lround(std::ceil(low * 3 - 1e-9)); thirds <= std::lround(std::floor(high * 3 + 1e-9)); ++thirds)
+      {
+        charge_index.for_each(thirds / 3.0, f);
+      }
+      return;
+    }
+    if(index != ParticleIndex::Charge && sorted_enabled[static_cast<std::size_t>(index)])
+    {
+      sorted_indexes[static_cast<std::size_t>(index)].for_each_in_range(low, high, f);
+      return;
+    }
+    for(const Bucket& bucket : particles_by_species)
+    {
+      for(std::size_t i = 0; i < bucket.particles.size(); ++i)
+      {
+        const T& particle = *bucket.particles[i];
+        double key = index == ParticleIndex::Charge ? particle.get_charge() : index_key(index, particle.get_four_momentum());
+        if(key >= low && key <= high)
+        {
+          f(bucket.slots[i]);
+        }
+      }
+    }
+  }
+
+  void momentum_changed(const Particle& particle, const FourMomentum& delta) override
+  {
+    base_momentum_total += delta;
+    auto range = indexed_slots.equal_range(&particle);
+    for(auto it = range.first; it != range.second; ++it)
+    {
+      for(std::size_t i = 0; i < sorted_index_count; ++i)
+      {
+        if(sorted_enabled[i])
+        {
+          sorted_indexes[i].update(it->second, index_key(static_cast<ParticleIndex>(i), particle.get_four_momentum()));
+        }
+      }
+    }
+  }
+
+  void decay_momentum_changed(const Particle&, const FourMomentum& delta) override
+  {
+    decay_momentum_total += delta;
+  }
+
+  void stop_observing()
+  {
+    for(T& particle : all_particles())
+    {
+      particle.remove_observer(this);
+    }
+  }
 
 public:
-  void add_particle(std::shared_ptr<T> particle)
+  // Every particle in the catalogue, type by type. Like ParticleSpan it yields T& and neither allocates nor copies
+  // shared_ptrs; valid until the catalogue is next modified.
+  class AllParticles
   {
-    particles_by_type[particle->get_type()].push_back(particle);
+  private:
+    using Outer = typename Buckets::const_iterator;
+    Outer first;
+    Outer last;
+    std::size_t count;
+
+  public:
+    class iterator
+    {
+    private:
+      Outer outer;
+      Outer outer_end;
+      std::size_t index = 0;
+
+      void skip_empty_types()
+      {
+        while(outer != outer_end && index == outer->particles.size())
+        {
+          ++outer;
+          index = 0;
+        }
+      }
+
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = T*;
+      using reference = T&;
+
+      iterator(Outer outer, Outer outer_end) : outer(outer), outer_end(outer_end) { skip_empty_types(); }
+
+      T& operator*() const { return *outer->particles[index]; }
+      T* operator->() const { return outer->particles[index].get(); }
+      const std::shared_ptr<T>& shared() const { return outer->particles[index]; }
+      iterator& operator++() { ++index; skip_empty_types(); return *this; }
+      iterator operator++(int) { iterator previous = *this; ++*this; return previous; }
+      bool operator==(const iterator& other) const { return outer == other.outer && index == other.index; }
+      bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+
+    AllParticles(Outer first, Outer last, std::size_t count) : first(first), last(last), count(count) {}
+    iterator begin() const { return iterator(first, last); }
+    iterator end() const { return iterator(last, last); }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+  };
+
+  ParticleCatalogue() = default;
+
+  // Copies share the particles and keep the same handles
+  ParticleCatalogue(const ParticleCatalogue& other)
+    : particles_by_species(other.particles_by_species), slots(other.slots), free_slot(other.free_slot),
+      particle_count(other.particle_count), base_momentum_total(other.base_momentum_total),
+      decay_momentum_total(other.decay_momentum_total), sorted_indexes(other.sorted_indexes),
+      sorted_enabled(other.sorted_enabled), charge_index(other.charge_index), charge_enabled(other.charge_enabled),
+      indexed_slots(other.indexed_slots)
+  {
+    start_observing();
   }
 
-  void remove_particle(const std::string& type, std::shared_ptr<T> particle)
+  ParticleCatalogue& operator=(const ParticleCatalogue& other)
   {
-    auto& particles = particles_by_type[type];
-    auto new_end = std::remove_if(particles.begin(), particles.end(),
-                                  [&particle](const std::shared_ptr<T>& p) { return p == particle; });
-    particles.erase(new_end, particles.end());
+    if(this != &other)
+    {
+      stop_observing();
+      particles_by_species = other.particles_by_species;
+      slots = other.slots;
+      free_slot = other.free_slot;
+      particle_count = other.particle_count;
+      base_momentum_total = other.base_momentum_total;
+      decay_momentum_total = other.decay_momentum_total;
+      sorted_indexes = other.sorted_indexes;
+      sorted_enabled = other.sorted_enabled;
+      charge_index = other.charge_index;
+      charge_enabled = other.charge_enabled;
+      indexed_slots = other.indexed_slots;
+      start_observing();
+    }
+    return *this;
   }
 
+  ~ParticleCatalogue()
+  {
+    stop_observing(); // Particles can outlive the catalogue through other shared_ptrs
+  }
+
+  ParticleHandle add_particle(std::shared_ptr<T> particle)
+  {
+    std::uint32_t index = free_slot;
+    if(index == no_slot)
+    {
+      index = static_cast<std::uint32_t>(slots.size());
+      slots.emplace_back();
+    }
+    else
+    {
+      free_slot = slots[index].position;
+    }
+
+    particle->add_observer(this);
+    ++particle_count;
+    base_momentum_total += particle->get_four_momentum();
+    decay_momentum_total += particle->get_decay_momentum_total();
+
+    Slot& slot = slots[index];
+    Bucket& bucket = particles_by_species[species_index(particle->get_species())];
+    slot.species = particle->get_species();
+    slot.position = static_cast<std::uint32_t>(bucket.particles.size());
+    slot.live = true;
+    bucket.particles.push_back(std::move(particle));
+    bucket.slots.push_back(index);
+    index_particle(index, *bucket.particles.back());
+    return ParticleHandle{index, slot.generation};
+  }
+
+  // O(1); returns false if the handle is stale. Moves the last particle of the same type into the gap.
+  bool remove_particle(ParticleHandle handle)
+  {
+    const Slot* slot = find_slot(handle);
+    if(!slot)
+    {
+      return false;
+    }
+    erase_at(particles_by_species[species_index(slot->species)], slot->position);
+    return true;
+  }
+
+  // For callers without a handle: searches the type's bucket, so linear in its size
+  void remove_particle(const std::string& type, const std::shared_ptr<T>& particle)
+  {
+    Species species;
+    if(!species_from_name(type, species))
+    {
+      return;
+    }
+    Bucket& bucket = particles_by_species[species_index(species)];
+    auto it = std::find(bucket.particles.begin(), bucket.particles.end(), particle);
+    if(it != bucket.particles.end())
+    {
+      erase_at(bucket, static_cast<std::uint32_t>(it - bucket.particles.begin()));
+    }
+  }
+
+  bool contains(ParticleHandle handle) const { return find_slot(handle) != nullptr; }
+
+  // nullptr for a stale handle
+  T* get(ParticleHandle handle) const
+  {
+    const Slot* slot = find_slot(handle);
+    return slot ? particles_by_species[species_index(slot->species)].particles[slot->position].get() : nullptr;
+  }
+
+  std::shared_ptr<T> shared(ParticleHandle handle) const
+  {
+    const Slot* slot = find_slot(handle);
+    return slot ? particles_by_species[species_index(slot->species)].particles[slot->position] : nullptr;
+  }
+
+  void clear()
+  {
+    stop_observing();
+    for(Bucket& bucket : particles_by_species)
+    {
+      for(std::uint32_t index : bucket.slots)
+      {
+        Slot& slot = slots[index];
+        slot.live = false;
+        ++slot.generation;
+        slot.position = free_slot;
+        free_slot = index;
+      }
+      bucket.particles.clear();
+      bucket.slots.clear();
+    }
+    rebuild_indexes();
+    particle_count = 0;
+    base_momentum_total = FourMomentum();
+    decay_momentum_total = FourMomentum();
+  }
+
+  // Rebuilds the running totals from scratch, eg to shed rounding accumulated over many updates
+  void recompute_aggregates()
+  {
+    particle_count = 0;
+    base_momentum_total = FourMomentum();
+    decay_momentum_total = FourMomentum();
+    for(const T& particle : all_particles())
+    {
+      particle_count++;
+      base_momentum_total += particle.get_four_momentum();
+      decay_momentum_total += particle.get_decay_momentum_total();
+    }
+    rebuild_indexes();
+  }
+
+  // Secondary indexes are off until asked for. Each one enabled is built straight away and from then on kept up to
+  // date as particles are added, removed or given new momenta; queries on an index that is off fall back to a scan.
+  void enable_index(ParticleIndex index)
+  {
+    if(index == ParticleIndex::Charge)
+    {
+      charge_enabled = true;
+    }
+    else
+    {
+      sorted_enabled[static_cast<std::size_t>(index)] = true;
+    }
+    rebuild_indexes();
+  }
+
+  void disable_index(ParticleIndex index)
+  {
+    if(index == ParticleIndex::Charge)
+    {
+      charge_enabled = false;
+    }
+    else
+    {
+      sorted_enabled[static_cast<std::size_t>(index)] = false;
+    }
+    rebuild_indexes();
+  }
+
+  bool has_index(ParticleIndex index) const
+  {
+    return index == ParticleIndex::Charge ? charge_enabled : sorted_enabled[static_cast<std::size_t>(index)];
+  }
+
+  // Particles whose energy, pT, invariant mass or charge lies in [low, high]: O(log n + k) on a sorted index,
+  // O(n / 64 + k) on the charge bitmaps. Sorted indexes return them in increasing order of the key.
+  std::vector<ParticleHandle> select(ParticleIndex index, double low, double high) const
+  {
+    std::vector<ParticleHandle> selected;
+    for_each_slot_in_range(index, low, high, [&](std::uint32_t slot)
+    {
+      selected.push_back(ParticleHandle{slot, slots[slot].generation});
+    });
+    return selected;
+  }
+
+  // As above, restricted to one charge, eg select(ParticleIndex::TransverseMomentum, 20e3, inf, -1)
+  std::vector<ParticleHandle> select(ParticleIndex index, double low, double high, double charge) const
+  {
+    if(index == ParticleIndex::Charge)
+    {
+      throw std::invalid_argument("Charge cannot be both the range and the filter of a selection.");
+    }
+    std::vector<ParticleHandle> selected;
+    for_each_slot_in_range(index, low, high, [&](std::uint32_t slot)
+    {
+      bool match = charge_enabled ? charge_index.test(slot, charge)
+                                  : std::lround(particle_at(slot).get_charge() * 3) == std::lround(charge * 3);
+      if(match)
+      {
+        selected.push_back(ParticleHandle{slot, slots[slot].generation});
+      }
+    });
+    return selected;
+  }
+
+  // Snapshot of where every particle points in (eta, phi), for cone and nearest-neighbour queries by handle.
+  // Built in O(n); rebuild it after the catalogue or the particles' momenta change.
+  AngularIndex<ParticleHandle> angular_index(double cell_size = 0.4) const
+  {
+    std::vector<AngularIndex<ParticleHandle>::Point> points;
+    points.reserve(particle_count);
+    for(const Bucket& bucket : particles_by_species)
+    {
+      for(std::size_t i = 0; i < bucket.particles.size(); ++i)
+      {
+        ParticleHandle handle{bucket.slots[i], slots[bucket.slots[i]].generation};
+        points.push_back(AngularIndex<ParticleHandle>::point(bucket.particles[i]->get_four_momentum(), handle));
+      }
+    }
+    return AngularIndex<ParticleHandle>(std::move(points), cell_size);
+  }
+
+  // Sets each (anti)muon's isolation flag: isolated when the scalar pT sum of the other particles within
+  // delta R < 'radius' of it is below 'max_pt_fraction' of its own pT
+  void update_muon_isolation(double radius = 0.4, double max_pt_fraction = 0.1)
+  {
+    AngularIndex<ParticleHandle> index = angular_index(radius);
+    for(Species species : {Species::Muon, Species::AntiMuon})
+    {
+      const Bucket& bucket = particles_by_species[species_index(species)];
+      for(std::size_t i = 0; i < bucket.particles.size(); ++i)
+      {
+        Muon* muon = dynamic_cast<Muon*>(bucket.particles[i].get());
+        if(!muon)
+        {
+          continue;
+        }
+        ParticleHandle self{bucket.slots[i], slots[bucket.slots[i]].generation};
+        const FourMomentum& momentum = muon->get_four_momentum();
+        double cone_pt = 0;
+        index.for_each_in_cone(momentum.pseudorapidity(), momentum.azimuth(), radius,
+                               [&](const AngularIndex<ParticleHandle>::Point& point, double)
+        {
+          if(point.id != self)
+          {
+            cone_pt += point.pt;
+          }
+        });
+        muon->set_isolated(cone_pt < max_pt_fraction * momentum.transverse_momentum());
+      }
+    }
+  }
+
+  // O(1) aggregates
+  std::size_t size() const { return particle_count; }
+  std::size_t count_of_type(const std::string& type) const
+  {
+    const Bucket* bucket = find_bucket(type);
+    return bucket ? bucket->particles.size() : 0;
+  }
+  const FourMomentum& base_momentum() const { return base_momentum_total; }
+  const FourMomentum& decay_momentum() const { return decay_momentum_total; }
+
+  // Non-owning views: no allocation and no reference counting, however many particles there are
+  ParticleSpan<T> particles_of_type(const std::string& type) const
+  {
+    const Bucket* bucket = find_bucket(type);
+    return bucket ? ParticleSpan<T>(bucket->particles.data(), bucket->particles.size()) : ParticleSpan<T>();
+  }
+  ParticleSpan<T> particles_of_type(Species species) const
+  {
+    const Bucket& bucket = particles_by_species[species_index(species)];
+    return ParticleSpan<T>(bucket.particles.data(), bucket.particles.size());
+  }
+  AllParticles all_particles() const { return AllParticles(particles_by_species.begin(), particles_by_species.end(), particle_count); }
+
+  // Owning copy, for callers that keep the particles beyond the next change to the catalogue
   std::vector<std::shared_ptr<T>> get_particles_of_type(const std::string& type) const
   {
-    auto it = particles_by_type.find(type);
-    if(it != particles_by_type.end())
+    const Bucket* bucket = find_bucket(type);
+    if(bucket)
     {
-      return it->second;
+      return bucket->particles;
     }
     return {}; // Return empty vector if not found
   }
 
-  void print_catalogue_by_type(const std::string& type) const
+  // The printing functions render through one TextFormatter per call and write 'sink' in large blocks
+  void print_catalogue_by_type(const std::string& type, std::ostream& sink = std::cout) const
   {
-    auto particles = get_particles_of_type(type);
-    std::cout<<"Printing "<<particles.size()<<" particles of type "<<type<<" and its decay products:\n";
-    for(const auto& particle : particles) {
-      particle->print();
-      std::cout<<"Total number of decay products for "<<particle->get_type()<<" (including subsequent decays): " 
-                   <<particle->total_decay_products()<<"\n\n";
+    TextFormatter out(sink);
+    ParticleSpan<T> particles = particles_of_type(type);
+    out<<"Printing "<<particles.size()<<" particles of type "<<type<<" and its decay products:\n";
+    for(const T& particle : particles) {
+      particle.print(out);
+      out<<"Total number of decay products for "<<particle.get_type()<<" (including subsequent decays): " 
+         <<particle.total_decay_products()<<"\n\n";
     }
   }
 
   void number_of_type(const std::string& type) const
   {
-    std::cout<<"Number of particles of type "<<type<<": "<<get_particles_of_type(type).size()<<std::endl;
+    std::cout<<"Number of particles of type "<<type<<": "<<count_of_type(type)<<std::endl;
   }
 
   void total_number() const
   {
-    size_t total_particles = 0;
-    for (const auto& entry : particles_by_type)
-    {
-      total_particles += entry.second.size();
-    }
-    std::cout<<"Total number of particles in catalogue: "<<total_particles<<std::endl;
+    std::cout<<"Total number of particles in catalogue: "<<particle_count<<std::endl;
   }
 
-  void print_all() const
+  void print_all(std::ostream& sink = std::cout) const
   {
+    TextFormatter out(sink);
     size_t total_particles = 0;
     size_t decay_particles = 0;
-    std::cout<<"Printing all particles in the catalogue:"<<std::endl;
-    for(const auto& entry : particles_by_type)
+    out<<"Printing all particles in the catalogue:\n";
+    for(const T& particle : all_particles())
     {
-      total_particles += entry.second.size();
-      for(const auto& particle : entry.second)
-      {
-        particle->print();
-        std::cout<<"Total number of decay products for "<<particle->get_type()<<" (including subsequent decays): " 
-                     <<particle->total_decay_products()<<"\n\n";
-        decay_particles += particle->total_decay_products();
-      }
+      total_particles++;
+      particle.print(out);
+      out<<"Total number of decay products for "<<particle.get_type()<<" (including subsequent decays): " 
+         <<particle.total_decay_products()<<"\n\n";
+      decay_particles += particle.total_decay_products();
     }
-    std::cout<<"Total number of base particles printed: "<<total_particles<<"\n";
-    std::cout<<"Total number of decay particles printed: "<<decay_particles<<"\n";
+    out<<"Total number of base particles printed: "<<total_particles<<"\n";
+    out<<"Total number of decay particles printed: "<<decay_particles<<"\n";
   }
 
-  void sum_all() const
+  // Four-momenta of all base particles (or of all their decay products) as columns for the batch kernels
+  FourMomentumBlock momentum_block(bool decay_products = false) const
   {
-    FourMomentum total_momentum(0, 0, 0, 0); // Initialize with zero four-momentum
-    FourMomentum totaldecay(0, 0, 0, 0);
-
-    for(const auto& entry : particles_by_type)
+    FourMomentumBlock block(decay_products ? 0 : particle_count);
+    for(const T& particle : all_particles())
     {
-      for(const auto& particle : entry.second)
+      if(decay_products)
+      {
+        particle.append_decay_momenta(block);
+      }
+      else
       {
-        auto [energy, px, py, pz] = particle->get_momentum();
-        // Create a temporary FourMomentum object to sum
-        FourMomentum particle_momentum(energy, px, py, pz);
-        total_momentum = total_momentum + particle_momentum; // Sum up four-momenta
-        totaldecay = totaldecay + particle->sum_decay_products_fourmomentum();
+        block.push_back(particle.get_four_momentum());
       }
     }
-    std::cout<<"Total sum of Four-Momentum of all base particles in the catalogue: ("<<total_momentum.get_e()<<", "<<total_momentum.get_px()
-             <<", "<<total_momentum.get_py()<<", "<<total_momentum.get_pz()<<") MeV/c\n";
+    return block;
+  }
+
+  void sum_all(std::ostream& sink = std::cout) const
+  {
+    TextFormatter out(sink);
+    const FourMomentum& total_momentum = base_momentum_total; // Kept up to date as the catalogue changes
+    const FourMomentum& totaldecay = decay_momentum_total;
+
+    out<<"Total sum of Four-Momentum of all base particles in the catalogue: ("<<total_momentum.get_e()<<", "<<total_momentum.get_px()
+       <<", "<<total_momentum.get_py()<<", "<<total_momentum.get_pz()<<") MeV/c\n";
     double total_invariant_mass = total_momentum.invariant_mass(); // Calculate the total invariant mass
-    std::cout<<"Total Invariant Mass of all base particles in the catalogue: "<<total_invariant_mass<<" MeV/c^2\n";
+    out<<"Total Invariant Mass of all base particles in the catalogue: "<<total_invariant_mass<<" MeV/c^2\n";
     
-    std::cout<<"Total Four-Momentum of all decay particles in the catalogue: ("<<totaldecay.get_e()<<", "<<totaldecay.get_px()
-             <<", "<<totaldecay.get_py()<<", "<<totaldecay.get_pz()<<") MeV/c\n";
+    out<<"Total Four-Momentum of all decay particles in the catalogue: ("<<totaldecay.get_e()<<", "<<totaldecay.get_px()
+       <<", "<<totaldecay.get_py()<<", "<<totaldecay.get_pz()<<") MeV/c\n";
     double decay_invariant_mass = totaldecay.invariant_mass(); // Calculate the total invariant mass
-    std::cout<<"Total Invariant Mass of all decay particles in the catalogue: "<<decay_invariant_mass<<" MeV/c^2\n";
+    out<<"Total Invariant Mass of all decay particles in the catalogue: "<<decay_invariant_mass<<" MeV/c^2\n";
   }
 
+  // Decays every undecayed unstable particle across 'pool'. Particle i (in species order, then insertion order)
+  // draws from stream i of 'seed', and its subsequent decays run in the same task on the same stream, so the
+  // result depends only on the seed and the catalogue, not on the number of threads or how work was stolen.
+  // A particle added more than once is decayed once. Observers of the parents (this catalogue and any other that
+  // holds them, eg a copy) are suspended during the parallel phase and told the net changes afterwards, on this
+  // thread. Particles that are decay products of other trees are decayed afterwards on this thread too, as their
+  // changes travel up through ancestors that other tasks may share.
+  void decay_all(ThreadPool& pool, std::uint64_t seed = random_seed().load())
+  {
+    std::vector<T*> parents;
+    std::unordered_set<const T*> seen;
+    for(T& particle : all_particles())
+    {
+      if(particle.get_decay_products().empty() && decay_table().has_channels(particle.get_species()) && seen.insert(&particle).second)
+      {
+        parents.push_back(&particle);
+      }
+    }
+
+    std::vector<std::size_t> independent, attached; // Positions in 'parents', which fix each one's stream
+    for(std::size_t i = 0; i < parents.size(); ++i)
+    {
+      (parents[i]->get_parent_particle() ? attached : independent).push_back(i);
+      parents[i]->suspend_observers();
+    }
+
+    RandomEngine base(seed);
+    auto decay_parent = [&](std::size_t i)
+    {
+      RandomEngine rng = base.split(i);
+      parents[i]->decay_with(rng);
+    };
+    try
+    {
+      std::size_t grain = std::clamp<std::size_t>(independent.size() / (pool.size() * 16), 1, 1024); // Enough chunks left over to steal
+      pool.parallel_for(independent.size(), grain, [&](std::size_t begin, std::size_t end)
+      {
+        for(std::size_t j = begin; j < end; ++j)
+        {
+          decay_parent(independent[j]);
+        }
+      });
+      for(std::size_t i : attached)
+      {
+        decay_parent(i);
+      }
+    }
+    catch(...)
+    {
+      for(T* parent : parents)
+      {
+        parent->resume_observers();
+      }
+      throw;
+    }
+    for(T* parent : parents)
+    {
+      parent->resume_observers();
+    }
+  }
 
 void print_particle_types()
 {
   std::cout<<"Available particle types:\n";
   std::cout<<std::left<<std::setw(27)<<"Type"<<std::setw(5)<<"Number"<<std::endl;
-  for(const auto& entry : particles_by_type)
+  for(std::size_t i = 0; i < species_count; ++i)
   {
-    std::cout<<std::left<<std::setw(25)<<entry.first
-             <<std::setw(5)<<std::internal<<std::setfill(' ')<<get_particles_of_type(entry.first).size()<<std::endl;
+    if(!particles_by_species[i].particles.empty())
+    {
+      std::cout<<std::left<<std::setw(25)<<species_names[i]
+               <<std::setw(5)<<std::internal<<std::setfill(' ')<<particles_by_species[i].particles.size()<<std::endl;
+    }
   }
 }
 
 std::vector<std::string> get_particle_types() const
 {
   std::vector<std::string> types;
-  for (const auto& entry : particles_by_type)
+  for(std::size_t i = 0; i < species_count; ++i)
   {
-    types.push_back(entry.first);
+    if(!particles_by_species[i].particles.empty())
+    {
+      types.emplace_back(species_names[i]);
+    }
   }
   return types;
 }
@@ -0,0 +1,151 @@
+#include "particle_factory.h"
+#include "bosons.h"
+#include "lepton.h"
+#include "quark.h"
+#include <cmath>
+#include <cstddef>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  thread_local std::pmr::memory_resource* current_particle_resource = nullptr; // nullptr for the heap
+
+  // The particles of a make_particle_block call, with the vector's buffer taken from the same resource
+  template<typename ParticleType>
+  struct ParticleBlock
+  {
+    std::pmr::vector<ParticleType> particles;
+
+    explicit ParticleBlock(std::pmr::memory_resource* resource) : particles(resource) {}
+  };
+
+  // Calls 'build' with a null pointer to the concrete class of 'species' (as a type tag) followed by that class's constructor arguments
+  template<typename Build>
+  auto build_species(Species species, double px, double py, double pz, ColourCharge colour, double borrowed_energy, Build&& build)
+  {
+    bool is_anti = species < Species::Photon && (species_index(species) & 1); // Fermion antiparticles have odd IDs
+    if(colour == ColourCharge::Neutral)
+    {
+      colour = is_anti ? ColourCharge::AntiRed : ColourCharge::Red;
+    }
+
+    switch(species)
+    {
+      case Species::Electron:
+      case Species::AntiElectron:
+      { // Whole energy deposited in the first calorimeter layer
+        double energy = std::sqrt(px*px + py*py + pz*pz + 0.511*0.511);
+        return build(static_cast<Electron*>(nullptr), px, py, pz, std::vector<double>{energy, 0, 0, 0}, is_anti);
+      }
+      case Species::Muon:
+      case Species::AntiMuon: return build(static_cast<Muon*>(nullptr), px, py, pz, false, is_anti);
+      case Species::Tau:
+      case Species::AntiTau: return build(static_cast<Tau*>(nullptr), px, py, pz, is_anti);
+      case Species::ElectronNeutrino:
+      case Species::AntiElectronNeutrino: return build(static_cast<ElectronNeutrino*>(nullptr), px, py, pz, false, is_anti);
+      case Species::MuonNeutrino:
+      case Species::AntiMuonNeutrino: return build(static_cast<MuonNeutrino*>(nullptr), px, py, pz, false, is_anti);
+      case Species::TauNeutrino:
+      case Species::AntiTauNeutrino: return build(static_cast<TauNeutrino*>(nullptr), px, py, pz, false, is_anti);
+      case Species::UpQuark:
+      case Species::AntiUpQuark: return build(static_cast<UpQuark*>(nullptr), px, py, pz, colour, is_anti);
+      case Species::DownQuark:
+      case Species::AntiDownQuark: return build(static_cast<DownQuark*>(nullptr), px, py, pz, colour, is_anti);
+      case Species::CharmQuark:
+      case Species::AntiCharmQuark: return build(static_cast<CharmQuark*>(nullptr), px, py, pz, colour, is_anti);
+      case Species::StrangeQuark:
+      case Species::AntiStrangeQuark: return build(static_cast<StrangeQuark*>(nullptr), px, py, pz, colour, is_anti);
+      case Species::TopQuark:
+      case Species::AntiTopQuark: return build(static_cast<TopQuark*>(nullptr), px, py, pz, colour, is_anti);
+      case Species::BottomQuark:
+      case Species::AntiBottomQuark: return build(static_cast<BottomQuark*>(nullptr), px, py, pz, colour, is_anti);
+      case Species::Photon: return build(static_cast<Photon*>(nullptr), px, py, pz);
+      case Species::WPlus: return build(static_cast<WBoson*>(nullptr), 1, px, py, pz, borrowed_energy);
+      case Species::WMinus: return build(static_cast<WBoson*>(nullptr), -1, px, py, pz, borrowed_energy);
+      case Species::ZBoson: return build(static_cast<ZBoson*>(nullptr), px, py, pz, borrowed_energy);
+      case Species::HiggsBoson: return build(static_cast<HiggsBoson*>(nullptr), px, py, pz);
+      case Species::Gluon: return build(static_cast<Gluon*>(nullptr), colour, anticolour(colour), px, py, pz);
+    }
+    throw std::invalid_argument("Unknown particle species.");
+  }
+}
+
+std::pmr::memory_resource* particle_memory_resource()
+{
+  return current_particle_resource ? current_particle_resource : std::pmr::new_delete_resource();
+}
+
+ParticleMemoryScope::ParticleMemoryScope(std::pmr::memory_resource* resource) : previous(current_particle_resource)
+{
+  current_particle_resource = resource;
+}
+
+ParticleMemoryScope::~ParticleMemoryScope()
+{
+  current_particle_resource = previous;
+}
+
+void* EventArena::CountingResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  void* pointer = upstream->allocate(bytes, alignment);
+  live.fetch_add(1, std::memory_order_relaxed);
+  return pointer;
+}
+
+void EventArena::CountingResource::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+{
+  live.fetch_sub(1, std::memory_order_relaxed);
+  upstream->deallocate(pointer, bytes, alignment);
+}
+
+bool EventArena::CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+EventArena::EventArena(std::size_t first_block_bytes)
+  : first_block(new std::byte[first_block_bytes]), resource(first_block.get(), first_block_bytes), counted(&resource), scope(&counted) {}
+
+void EventArena::release()
+{
+  if(live_allocations() != 0)
+  { // A particle still alive would be left pointing into memory the next event reuses
+    throw std::logic_error("EventArena released while " + std::to_string(live_allocations()) +
+                           " allocations from its event are still alive");
+  }
+  resource.release();
+}
+
+std::shared_ptr<Particle> make_particle(Species species, double px, double py, double pz, ColourCharge colour, double borrowed_energy)
+{
+  return build_species(species, px, py, pz, colour, borrowed_energy, [](auto* type, auto&&... args) -> std::shared_ptr<Particle>
+  {
+    using ParticleType = std::remove_pointer_t<decltype(type)>;
+    return allocate_particle<ParticleType>(std::forward<decltype(args)>(args)...);
+  });
+}
+
+std::vector<std::shared_ptr<Particle>> make_particle_block(Species species, std::size_t count, ColourCharge colour, double borrowed_energy)
+{
+  return build_species(species, 0, 0, 0, colour, borrowed_energy, [count](auto* type, const auto&... args) -> std::vector<std::shared_ptr<Particle>>
+  {
+    using ParticleType = std::remove_pointer_t<decltype(type)>;
+    std::pmr::memory_resource* resource = particle_memory_resource();
+    auto block = std::allocate_shared<ParticleBlock<ParticleType>>(std::pmr::polymorphic_allocator<ParticleBlock<ParticleType>>(resource),
+                                                                   resource);
+    block->particles.reserve(count); // Never reallocates below, so the pointers handed out stay valid
+    std::vector<std::shared_ptr<Particle>> particles;
+    particles.reserve(count);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      block->particles.emplace_back(args...);
+      particles.emplace_back(block, &block->particles.back()); // Aliasing pointer: each particle keeps the whole block alive
+    }
+    return particles;
+  });
+}
@@ -3,15 +3,107 @@
 
 #include "particle_catalogue.h"
 #include "particle.h"
+#include "quark.h"
+#include "species.h"
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
 #include <iostream>
 
+// Memory that make_particle, make_particle_block and create_add_particle take new particles from on the calling
+// thread; each particle and its reference count share one allocation from it. By default this is
+// std::pmr::new_delete_resource(), ie the heap, as with std::make_shared. Only that allocation comes from here: what a
+// particle allocates itself (the block holding its decay products and observers, an electron's calorimeter
+// deposits, decay type strings) still comes from the heap and is freed with the particle.
+std::pmr::memory_resource* particle_memory_resource();
+
+// Points particle_memory_resource() at 'resource' on this thread until the scope ends. Any resource will do, eg a
+// std::pmr::unsynchronized_pool_resource, which keeps a free list per size and so in effect one pool per species.
+// The resource must outlive every particle created from it.
+class ParticleMemoryScope
+{
+private:
+  std::pmr::memory_resource* previous;
+
+public:
+  explicit ParticleMemoryScope(std::pmr::memory_resource* resource);
+  ParticleMemoryScope(const ParticleMemoryScope&) = delete;
+  ParticleMemoryScope& operator=(const ParticleMemoryScope&) = delete;
+  ~ParticleMemoryScope();
+};
+
+// A monotonic arena for one event: while it exists, particles created on this thread (decay products included)
+// are carved out of its blocks one after another, freeing one costs nothing, and everything is given back at once
+// by release() or the destructor. The first block is kept and reused after release(), so an event loop that
+// releases the arena between events makes no heap allocations for the particles themselves once events fit in it
+// (see particle_memory_resource() for what a particle still allocates from the heap).
+// Every particle created in an event must be destroyed before the arena is released; release() counts the
+// allocations still live and throws std::logic_error, releasing nothing, if there are any.
+class EventArena
+{
+private:
+  // Forwards to the arena, counting the allocations not yet given back
+  class CountingResource : public std::pmr::memory_resource
+  {
+  private:
+    std::pmr::memory_resource* upstream;
+    std::atomic<std::size_t> live{0}; // Particles may be freed on another thread than the one that made them
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  public:
+    explicit CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+    std::size_t live_allocations() const { return live.load(std::memory_order_relaxed); }
+  };
+
+  std::unique_ptr<std::byte[]> first_block;
+  std::pmr::monotonic_buffer_resource resource;
+  CountingResource counted;
+  ParticleMemoryScope scope;
+
+public:
+  explicit EventArena(std::size_t first_block_bytes = 64 * 1024);
+  EventArena(const EventArena&) = delete;
+  EventArena& operator=(const EventArena&) = delete;
+
+  std::pmr::memory_resource* memory_resource() { return &counted; }
+  std::size_t live_allocations() const { return counted.live_allocations(); } // Particles (or blocks of them) not yet freed
+  void release(); // Starts the next event; throws std::logic_error while live_allocations() is nonzero
+};
+
+// Allocates one particle, and its reference count alongside, from particle_memory_resource(); what make_particle,
+// create_add_particle and every clone() use, so copies land in the same arena or pool as the particles they copy
 template<typename ParticleType, typename... Args>
-std::shared_ptr<ParticleType> create_add_particle(ParticleCatalogue<Particle>& catalogue, Args&&... args)
+std::shared_ptr<ParticleType> allocate_particle(Args&&... args)
+{
+  return std::allocate_shared<ParticleType>(std::pmr::polymorphic_allocator<ParticleType>(particle_memory_resource()),
+                                            std::forward<Args>(args)...);
+}
+
+// Builds a particle of any species from its ID, eg for decay products or ingested records, in particle_memory_resource().
+// Quarks and gluons take 'colour' (Neutral picks a matching default), W and Z bosons take the energy they borrow when
+// produced virtually.
+std::shared_ptr<Particle> make_particle(Species species, double px, double py, double pz, ColourCharge colour = ColourCharge::Neutral,
+                                        double borrowed_energy = 0);
+
+// 'count' particles of one species at rest, constructed in a single contiguous allocation from particle_memory_resource()
+// that they share ownership of
+std::vector<std::shared_ptr<Particle>> make_particle_block(Species species, std::size_t count, ColourCharge colour = ColourCharge::Neutral,
+                                                          double borrowed_energy = 0);
+
+// Works with ParticleCatalogue and with ConcurrentParticleCatalogue, which generator threads may fill in parallel
+template<typename ParticleType, typename Catalogue, typename... Args>
+std::shared_ptr<ParticleType> create_add_particle(Catalogue& catalogue, Args&&... args)
 {
   try
   {
-    auto particle = std::make_shared<ParticleType>(std::forward<Args>(args)...);
+    auto particle = allocate_particle<ParticleType>(std::forward<Args>(args)...);
+    FourMomentum::checked(particle->get_e(), particle->get_px(), particle->get_py(), particle->get_pz()); // Validation happens here, not in FourMomentum's constructor
     catalogue.add_particle(particle);
     return particle;
   }
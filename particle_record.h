@@ -0,0 +1,33 @@
+#ifndef PARTICLE_RECORD_H
+#define PARTICLE_RECORD_H
+
+#include "fourmom.h"
+#include "species.h"
+#include <cstdint>
+#include <type_traits>
+
+// Compact, allocation-free description of one particle: inline momentum, a species ID instead of a
+// type string and tree links as indices into whichever buffer owns the records (eg a whole event).
+// Records are what trees are flattened into (DecayTreeArena, snapshots, exports), not what a Particle is built on;
+// Particle keeps its own 64-byte layout and links its products by shared_ptr.
+struct ParticleRecord
+{
+  static constexpr std::uint32_t no_index = 0xFFFFFFFF;
+  static constexpr std::uint8_t antiparticle_flag = 1;
+
+  FourMomentum momentum;
+  std::uint32_t parent = no_index;
+  std::uint32_t first_child = no_index;
+  std::uint32_t next_sibling = no_index;
+  std::uint32_t child_count = 0;
+  std::uint32_t descendant_count = 0; // Size of the subtree below this record, which follows it in pre-order
+  Species species = Species::Photon;
+  std::uint8_t flags = 0;
+
+  bool is_antiparticle() const { return flags & antiparticle_flag; }
+};
+
+static_assert(sizeof(ParticleRecord) <= 64, "ParticleRecord must fit in one cache line");
+static_assert(std::is_trivially_copyable_v<ParticleRecord>, "ParticleRecord must be copyable in bulk");
+
+#endif // PARTICLE_RECORD_H
@@ -0,0 +1,53 @@
+#ifndef PARTICLE_VIEW_H
+#define PARTICLE_VIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+// Non-owning view of a contiguous run of shared_ptrs that iterates the particles themselves (T&), so walking it
+// allocates nothing and never touches a reference count. Valid until the container it came from is modified.
+template<typename T>
+class ParticleSpan
+{
+private:
+  const std::shared_ptr<T>* first = nullptr;
+  const std::shared_ptr<T>* last = nullptr;
+
+public:
+  class iterator
+  {
+  private:
+    const std::shared_ptr<T>* current = nullptr;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    iterator() = default;
+    explicit iterator(const std::shared_ptr<T>* current) : current(current) {}
+
+    T& operator*() const { return **current; }
+    T* operator->() const { return current->get(); }
+    const std::shared_ptr<T>& shared() const { return *current; } // For callers that do need to keep the particle
+    iterator& operator++() { ++current; return *this; }
+    iterator operator++(int) { iterator previous = *this; ++current; return previous; }
+    bool operator==(const iterator& other) const { return current == other.current; }
+    bool operator!=(const iterator& other) const { return current != other.current; }
+  };
+
+  ParticleSpan() = default;
+  ParticleSpan(const std::shared_ptr<T>* first, std::size_t count) : first(first), last(first + count) {}
+
+  iterator begin() const { return iterator(first); }
+  iterator end() const { return iterator(last); }
+  std::size_t size() const { return static_cast<std::size_t>(last - first); }
+  bool empty() const { return first == last; }
+  T& operator[](std::size_t i) const { return *first[i]; }
+  const std::shared_ptr<T>& shared(std::size_t i) const { return first[i]; }
+};
+
+#endif // PARTICLE_VIEW_H
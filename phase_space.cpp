@@ -0,0 +1,206 @@
+#include "phase_space.h"
+#include "fourmom_block.h"
+#include <algorithm>
+#include <cmath>
+
+double two_body_momentum(double parent_mass, double mass1, double mass2)
+{
+  double mass_sum = mass1 + mass2;
+  double mass_difference = mass1 - mass2;
+  double p_squared = (parent_mass * parent_mass - mass_sum * mass_sum) * (parent_mass * parent_mass - mass_difference * mass_difference);
+  return (p_squared > 0 && parent_mass > 0) ? std::sqrt(p_squared) / (2.0 * parent_mass) : 0;
+}
+
+FourMomentum boost_from_rest_frame(const FourMomentum& momentum, const FourMomentum& frame)
+{
+  double frame_mass = frame.invariant_mass();
+  if(frame_mass <= 0)
+  { // A massless frame has no rest frame to boost from
+    return momentum;
+  }
+
+  double boosted_e = (frame.get_e() * momentum.get_e() + frame.get_px() * momentum.get_px()
+                      + frame.get_py() * momentum.get_py() + frame.get_pz() * momentum.get_pz()) / frame_mass;
+  double factor = (momentum.get_e() + boosted_e) / (frame.get_e() + frame_mass);
+  return FourMomentum(boosted_e, momentum.get_px() + factor * frame.get_px(), momentum.get_py() + factor * frame.get_py(),
+                      momentum.get_pz() + factor * frame.get_pz());
+}
+
+// Isotropic pair of back-to-back momenta of magnitude p, in the rest frame of their parent
+static std::pair<FourMomentum, FourMomentum> back_to_back(double p, double mass1, double mass2, RandomEngine& rng)
+{
+  double cos_theta = 2.0 * rng.uniform() - 1.0;
+  double sin_theta = std::sqrt(std::max(1.0 - cos_theta * cos_theta, 0.0));
+  double phi = 2.0 * M_PI * rng.uniform();
+
+  double px = p * sin_theta * std::cos(phi);
+  double py = p * sin_theta * std::sin(phi);
+  double pz = p * cos_theta;
+  return {FourMomentum(std::sqrt(p * p + mass1 * mass1), px, py, pz),
+          FourMomentum(std::sqrt(p * p + mass2 * mass2), -px, -py, -pz)};
+}
+
+std::pair<FourMomentum, FourMomentum> two_body_decay(const FourMomentum& parent, double mass1, double mass2, RandomEngine& rng)
+{
+  double p = two_body_momentum(parent.invariant_mass(), mass1, mass2);
+  auto [first, second] = back_to_back(p, mass1, mass2, rng);
+  return {boost_from_rest_frame(first, parent), boost_from_rest_frame(second, parent)};
+}
+
+void two_body_decay(const FourMomentumBlock& parents, double mass1, double mass2, RandomEngine& rng,
+                    FourMomentumBlock& first, FourMomentumBlock& second)
+{
+  std::size_t n = parents.size();
+  first.resize(n);
+  second.resize(n);
+  std::vector<double> cos_theta(n), phi(n);
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    cos_theta[i] = 2.0 * rng.uniform() - 1.0;
+    phi[i] = 2.0 * M_PI * rng.uniform();
+  }
+
+  const double* E = parents.e();
+  const double* px = parents.px();
+  const double* py = parents.py();
+  const double* pz = parents.pz();
+  double* e1 = first.e();
+  double* px1 = first.px();
+  double* py1 = first.py();
+  double* pz1 = first.pz();
+  double* e2 = second.e();
+  double* px2 = second.px();
+  double* py2 = second.py();
+  double* pz2 = second.pz();
+  double mass_sum = mass1 + mass2;
+  double mass_difference = mass1 - mass2;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    double parent_mass = std::sqrt(std::max(E[i] * E[i] - px[i] * px[i] - py[i] * py[i] - pz[i] * pz[i], 0.0));
+    double p_squared = (parent_mass * parent_mass - mass_sum * mass_sum) * (parent_mass * parent_mass - mass_difference * mass_difference);
+    double p = p_squared > 0 && parent_mass > 0 ? std::sqrt(p_squared) / (2.0 * parent_mass) : 0;
+
+    double sin_theta = std::sqrt(std::max(1.0 - cos_theta[i] * cos_theta[i], 0.0));
+    double qx = p * sin_theta * std::cos(phi[i]);
+    double qy = p * sin_theta * std::sin(phi[i]);
+    double qz = p * cos_theta[i];
+    double rest_e1 = std::sqrt(p * p + mass1 * mass1);
+    double rest_e2 = std::sqrt(p * p + mass2 * mass2);
+
+    // Same boost as boost_from_rest_frame; a massless parent leaves the daughters unboosted
+    bool boosted = parent_mass > 0;
+    double inverse_mass = boosted ? 1.0 / parent_mass : 0.0;
+    double q_dot_p = px[i] * qx + py[i] * qy + pz[i] * qz;
+    double boosted_e1 = boosted ? (E[i] * rest_e1 + q_dot_p) * inverse_mass : rest_e1;
+    double boosted_e2 = boosted ? (E[i] * rest_e2 - q_dot_p) * inverse_mass : rest_e2;
+    double factor1 = boosted ? (rest_e1 + boosted_e1) / (E[i] + parent_mass) : 0.0;
+    double factor2 = boosted ? (rest_e2 + boosted_e2) / (E[i] + parent_mass) : 0.0;
+
+    e1[i] = boosted_e1;
+    px1[i] = qx + factor1 * px[i];
+    py1[i] = qy + factor1 * py[i];
+    pz1[i] = qz + factor1 * pz[i];
+    e2[i] = boosted_e2;
+    px2[i] = -qx + factor2 * px[i];
+    py2[i] = -qy + factor2 * py[i];
+    pz2[i] = -qz + factor2 * pz[i];
+  }
+}
+
+std::vector<FourMomentum> n_body_decay(const FourMomentum& parent, const std::vector<double>& masses, RandomEngine& rng)
+{
+  std::vector<FourMomentum> daughters;
+  size_t n = masses.size();
+  if(n == 0)
+  {
+    return daughters;
+  }
+  daughters.reserve(n);
+  if(n == 1)
+  {
+    daughters.push_back(parent);
+    return daughters;
+  }
+  if(n == 2)
+  {
+    auto [first, second] = two_body_decay(parent, masses[0], masses[1], rng);
+    daughters.push_back(first);
+    daughters.push_back(second);
+    return daughters;
+  }
+
+  double parent_mass = parent.invariant_mass();
+  double mass_sum = 0;
+  for(double mass : masses)
+  {
+    mass_sum += mass;
+  }
+  double kinetic = std::max(parent_mass - mass_sum, 0.0);
+
+  // Largest possible weight, with all the kinetic energy given to each step of the chain in turn
+  double max_weight = 1;
+  double lightest = 0, heaviest = kinetic + masses[0];
+  for(size_t k = 1; k < n; ++k)
+  {
+    lightest += masses[k - 1];
+    heaviest += masses[k];
+    max_weight *= two_body_momentum(heaviest, lightest, masses[k]);
+  }
+
+  // Invariant masses of the subsystems {0..k}, spaced by sorted uniform fractions of the kinetic energy. The chain's
+  // weight is the product of its two-body momenta; accepting it with probability weight/max_weight makes the
+  // accepted points uniform in phase space.
+  std::vector<double> fractions(n, 0.0);
+  std::vector<double> subsystem_masses(n);
+  std::vector<double> momenta(n, 0.0);
+  fractions[n - 1] = 1.0;
+  while(true)
+  {
+    for(size_t k = 1; k < n - 1; ++k)
+    {
+      fractions[k] = rng.uniform();
+    }
+    std::sort(fractions.begin() + 1, fractions.end() - 1);
+
+    double partial_mass_sum = 0;
+    double weight = 1;
+    for(size_t k = 0; k < n; ++k)
+    {
+      partial_mass_sum += masses[k];
+      subsystem_masses[k] = partial_mass_sum + fractions[k] * kinetic;
+      if(k > 0)
+      {
+        momenta[k] = two_body_momentum(subsystem_masses[k], subsystem_masses[k - 1], masses[k]);
+        weight *= momenta[k];
+      }
+    }
+    if(!(max_weight > 0) || rng.uniform() * max_weight <= weight)
+    {
+      break; // No phase space at all (products at rest) also ends here
+    }
+  }
+
+  // Grow the system one particle at a time: subsystem k decays to subsystem k-1 plus particle k
+  for(size_t k = 1; k < n; ++k)
+  {
+    auto [subsystem, particle] = back_to_back(momenta[k], subsystem_masses[k - 1], masses[k], rng);
+    if(k == 1)
+    {
+      daughters.push_back(subsystem);
+    }
+    else
+    {
+      for(auto& daughter : daughters)
+      {
+        daughter = boost_from_rest_frame(daughter, subsystem);
+      }
+    }
+    daughters.push_back(particle);
+  }
+
+  for(auto& daughter : daughters)
+  {
+    daughter = boost_from_rest_frame(daughter, parent);
+  }
+  return daughters;
+}
@@ -0,0 +1,30 @@
+#ifndef PHASE_SPACE_H
+#define PHASE_SPACE_H
+
+#include "fourmom.h"
+#include "random_engine.h"
+#include <vector>
+
+class FourMomentumBlock;
+
+// Momentum magnitude of either daughter in the rest frame of a two-body decay (0 if kinematically forbidden)
+double two_body_momentum(double parent_mass, double mass1, double mass2);
+
+// Boosts a four-momentum given in the rest frame of 'frame' into the frame 'frame' is measured in
+FourMomentum boost_from_rest_frame(const FourMomentum& momentum, const FourMomentum& frame);
+
+// Exact isotropic two-body decay of 'parent', daughters returned in the parent's frame
+std::pair<FourMomentum, FourMomentum> two_body_decay(const FourMomentum& parent, double mass1, double mass2, RandomEngine& rng);
+
+// Columnar two_body_decay of every parent in 'parents' into daughters of the same two masses. The angles are drawn
+// first, then the kinematics and boosts run as one branch-free pass over the columns. 'first' and 'second' are resized.
+void two_body_decay(const FourMomentumBlock& parents, double mass1, double mass2, RandomEngine& rng,
+                    FourMomentumBlock& first, FourMomentumBlock& second);
+
+// GENBOD-style N-body phase-space point: a chain of exact two-body decays through sorted intermediate masses, kept
+// with probability proportional to its weight so that points are uniform in phase space (a few tries on average).
+// Four-momentum is conserved and every daughter is on its mass shell. The masses must not add up to more than the
+// parent's invariant mass; if they do, the daughters are left at rest in the parent's frame.
+std::vector<FourMomentum> n_body_decay(const FourMomentum& parent, const std::vector<double>& masses, RandomEngine& rng);
+
+#endif // PHASE_SPACE_H
@@ -0,0 +1,108 @@
+#ifndef QUANTUM_NUMBERS_H
+#define QUANTUM_NUMBERS_H
+
+#include "species.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Additive quantum numbers of a species packed into one 64-bit word, one signed byte per lane: charge and baryon
+// number in thirds, the three lepton family numbers and the colour representation (3 for quarks, -3 for
+// antiquarks, 8 for gluons). Whole words add lane by lane without carries between lanes, so a decay's products
+// sum in one integer add each and every conservation law is checked exactly by comparing two words.
+using QuantumNumbers = std::uint64_t;
+
+enum class QuantumLane : unsigned { ChargeThirds, BaryonThirds, ElectronLepton, MuonLepton, TauLepton, Colour };
+
+constexpr QuantumNumbers quantum_lane_mask(QuantumLane lane)
+{
+  return QuantumNumbers{0xFF} << (8 * static_cast<unsigned>(lane));
+}
+
+constexpr QuantumNumbers lepton_number_lanes = quantum_lane_mask(QuantumLane::ElectronLepton) |
+                                               quantum_lane_mask(QuantumLane::MuonLepton) |
+                                               quantum_lane_mask(QuantumLane::TauLepton);
+
+// Colour is a representation, not an additive charge, so it is carried but not conserved here
+constexpr QuantumNumbers conserved_lanes = quantum_lane_mask(QuantumLane::ChargeThirds) |
+                                           quantum_lane_mask(QuantumLane::BaryonThirds) | lepton_number_lanes;
+
+constexpr QuantumNumbers pack_quantum_numbers(int charge_thirds, int baryon_thirds, int electron_number, int muon_number,
+                                              int tau_number, int colour)
+{
+  int lanes[] = {charge_thirds, baryon_thirds, electron_number, muon_number, tau_number, colour};
+  QuantumNumbers word = 0;
+  for(unsigned i = 0; i < 6; ++i)
+  {
+    word |= QuantumNumbers{static_cast<std::uint8_t>(lanes[i])} << (8 * i);
+  }
+  return word;
+}
+
+constexpr int quantum_lane(QuantumNumbers word, QuantumLane lane)
+{
+  return static_cast<std::int8_t>(static_cast<std::uint8_t>(word >> (8 * static_cast<unsigned>(lane))));
+}
+
+// Lane-wise two's complement addition: the top bit of each lane is added separately so no carry crosses a lane.
+// Exact while every lane's sum stays within a signed byte, ie for decays of up to 42 products.
+constexpr QuantumNumbers add_quantum_numbers(QuantumNumbers a, QuantumNumbers b)
+{
+  constexpr QuantumNumbers high_bits = 0x8080808080808080;
+  return ((a & ~high_bits) + (b & ~high_bits)) ^ ((a ^ b) & high_bits);
+}
+
+// Nonzero in the lane of every conservation law that 'initial' and 'final' disagree on
+constexpr QuantumNumbers quantum_number_violations(QuantumNumbers initial, QuantumNumbers final)
+{
+  return (initial ^ final) & conserved_lanes;
+}
+
+namespace quantum_detail
+{
+  constexpr std::array<QuantumNumbers, species_count> make_quantum_table()
+  {
+    std::array<QuantumNumbers, species_count> table{};
+    // Leptons come in families of lepton, antilepton, neutrino, antineutrino
+    for(int family = 0; family < 3; ++family)
+    {
+      int lepton_numbers[3] = {};
+      for(int member = 0; member < 4; ++member)
+      {
+        int sign = member % 2 == 0 ? 1 : -1;
+        lepton_numbers[family] = sign;
+        int charge_thirds = member < 2 ? -3 * sign : 0;
+        table[4 * family + member] = pack_quantum_numbers(charge_thirds, 0, lepton_numbers[0], lepton_numbers[1], lepton_numbers[2], 0);
+      }
+    }
+    // Quarks then antiquarks, in the order up, down, charm, strange, top, bottom
+    constexpr int quark_charge_thirds[6] = {2, -1, 2, -1, 2, -1};
+    for(int flavour = 0; flavour < 6; ++flavour)
+    {
+      std::size_t quark = species_index(Species::UpQuark) + 2 * flavour;
+      table[quark] = pack_quantum_numbers(quark_charge_thirds[flavour], 1, 0, 0, 0, 3);
+      table[quark + 1] = pack_quantum_numbers(-quark_charge_thirds[flavour], -1, 0, 0, 0, -3);
+    }
+    table[species_index(Species::Photon)] = pack_quantum_numbers(0, 0, 0, 0, 0, 0);
+    table[species_index(Species::WPlus)] = pack_quantum_numbers(3, 0, 0, 0, 0, 0);
+    table[species_index(Species::WMinus)] = pack_quantum_numbers(-3, 0, 0, 0, 0, 0);
+    table[species_index(Species::ZBoson)] = pack_quantum_numbers(0, 0, 0, 0, 0, 0);
+    table[species_index(Species::HiggsBoson)] = pack_quantum_numbers(0, 0, 0, 0, 0, 0);
+    table[species_index(Species::Gluon)] = pack_quantum_numbers(0, 0, 0, 0, 0, 8);
+    return table;
+  }
+  constexpr auto quantum_table = make_quantum_table();
+}
+
+constexpr QuantumNumbers quantum_numbers(Species species)
+{
+  return quantum_detail::quantum_table[species_index(species)];
+}
+
+static_assert(quantum_lane(quantum_numbers(Species::AntiMuon), QuantumLane::ChargeThirds) == 3, "AntiMuon has charge +1");
+static_assert(quantum_lane(quantum_numbers(Species::AntiMuon), QuantumLane::MuonLepton) == -1, "AntiMuon has L_mu = -1");
+static_assert(quantum_number_violations(quantum_numbers(Species::WPlus),
+                                        add_quantum_numbers(quantum_numbers(Species::AntiTau), quantum_numbers(Species::TauNeutrino))) == 0,
+              "W+ -> tau+ nu_tau conserves everything");
+
+#endif // QUANTUM_NUMBERS_H
@@ -1,37 +1,38 @@
 #include "quark.h"
 #include "particle.h"
+#include "particle_factory.h"
 #include "fourmom.h"
 #include <iostream>
 
-Quark::Quark(double mass, double charge, double px, double py, double pz, const std::string& type, ColourCharge colour, bool is_anti, double baryon_number)
-  : Particle(mass, charge, 0.5, sqrt(px*px + py*py + pz*pz + mass*mass), px, py, pz, type, is_anti), colour(colour), baryon_number(baryon_number)
+Quark::Quark(double px, double py, double pz, Species species, ColourCharge colour, bool is_anti)
+  : Particle(px, py, pz, species, is_anti), colour(colour)
 {
   check_colour_consistency();
 }
 
 UpQuark::UpQuark(double px, double py, double pz, ColourCharge colour, bool is_anti)
-  : Quark(up_mass, is_anti ? -2.0/3.0 : 2.0/3.0, px, py, pz, is_anti ? "AntiUpQuark" : "UpQuark", colour, is_anti, is_anti ? -1.0/3.0 : 1.0/3.0) {}
+  : Quark(px, py, pz, is_anti ? Species::AntiUpQuark : Species::UpQuark, colour, is_anti) {}
 
 DownQuark::DownQuark(double px, double py, double pz, ColourCharge colour, bool is_anti)
-  : Quark(down_mass, is_anti ? 1.0/3.0 : -1.0/3.0, px, py, pz, is_anti ? "AntiDownQuark" : "DownQuark", colour, is_anti, is_anti ? -1.0/3.0 : 1.0/3.0) {}
+  : Quark(px, py, pz, is_anti ? Species::AntiDownQuark : Species::DownQuark, colour, is_anti) {}
 
 CharmQuark::CharmQuark(double px, double py, double pz, ColourCharge colour, bool is_anti)
-  : Quark(charm_mass, is_anti ? -2.0/3.0 : 2.0/3.0, px, py, pz, is_anti ? "AntiCharmQuark" : "CharmQuark", colour, is_anti, is_anti ? -1.0/3.0 : 1.0/3.0) {}
+  : Quark(px, py, pz, is_anti ? Species::AntiCharmQuark : Species::CharmQuark, colour, is_anti) {}
 
 StrangeQuark::StrangeQuark(double px, double py, double pz, ColourCharge colour, bool is_anti)
-  : Quark(strange_mass, is_anti ? 1.0/3.0 : -1.0/3.0, px, py, pz, is_anti ? "AntiStrangeQuark" : "StrangeQuark", colour, is_anti, is_anti ? -1.0/3.0 : 1.0/3.0) {}
+  : Quark(px, py, pz, is_anti ? Species::AntiStrangeQuark : Species::StrangeQuark, colour, is_anti) {}
 
 TopQuark::TopQuark(double px, double py, double pz, ColourCharge colour, bool is_anti)
-  : Quark(top_mass, is_anti ? -2.0/3.0 : 2.0/3.0, px, py, pz, is_anti ? "AntiTopQuark" : "TopQuark", colour, is_anti, is_anti ? -1.0/3.0 : 1.0/3.0) {}
+  : Quark(px, py, pz, is_anti ? Species::AntiTopQuark : Species::TopQuark, colour, is_anti) {}
 
 BottomQuark::BottomQuark(double px, double py, double pz, ColourCharge colour, bool is_anti)
-  : Quark(bottom_mass, is_anti ? 1.0/3.0 : -1.0/3.0, px, py, pz, is_anti ? "AntiBottomQuark" : "BottomQuark", colour, is_anti, is_anti ? -1.0/3.0 : 1.0/3.0) {}
+  : Quark(px, py, pz, is_anti ? Species::AntiBottomQuark : Species::BottomQuark, colour, is_anti) {}
 
 
 // Deep copy functionality
 
 Quark::Quark(const Quark& other)
-  : Particle(other), colour(other.colour), baryon_number(other.baryon_number) {}
+  : Particle(other), colour(other.colour) {}
 
 Quark& Quark::operator=(const Quark& other)
 {
@@ -39,15 +40,13 @@ Quark& Quark::operator=(const Quark& other)
   {
     Particle::operator=(other);
     colour = other.colour;
-    baryon_number = other.baryon_number;
   }
   return *this;
 }
 
 Quark::Quark(Quark&& other) noexcept
   : Particle(std::move(other)), // Invoke the base class move constructor
-    colour(other.colour), // Move the colour
-    baryon_number(other.baryon_number) {} // Move the baryon number
+    colour(other.colour) {} // Move the colour
 
 Quark& Quark::operator=(Quark&& other) noexcept
 {
@@ -55,7 +54,6 @@ Quark& Quark::operator=(Quark&& other) noexcept
   {
     Particle::operator=(std::move(other)); // Invoke the base class move assignment operator
     colour = other.colour; // Move the colour
-    baryon_number = other.baryon_number; // Move the baryon number
   }
   return *this;
 }
@@ -206,46 +204,26 @@ BottomQuark& BottomQuark::operator=(BottomQuark&& other) noexcept
 
 void Quark::check_colour_consistency()
 {
-  // Lambda for swapping colours to their anticolours and vice versa
-  auto swap_colour = [this]()->ColourCharge
-  {
-    switch (this->colour)
-    {
-      case ColourCharge::Red: return ColourCharge::AntiRed;
-      case ColourCharge::Green: return ColourCharge::AntiGreen;
-      case ColourCharge::Blue: return ColourCharge::AntiBlue;
-      case ColourCharge::AntiRed: return ColourCharge::Red;
-      case ColourCharge::AntiGreen: return ColourCharge::Green;
-      case ColourCharge::AntiBlue: return ColourCharge::Blue;
-      default: 
-        throw std::invalid_argument("Invalid colour charge.");
-    }
-  };
-
   // Determine if a swap is needed based on is_anti and the current colour charge
   bool needs_swap = (is_antiparticle && (colour == ColourCharge::Red || colour == ColourCharge::Green || colour == ColourCharge::Blue)) ||
                     (!is_antiparticle && (colour == ColourCharge::AntiRed || colour == ColourCharge::AntiGreen || colour == ColourCharge::AntiBlue));
 
   if(needs_swap)
   {
-    colour = swap_colour(); // Perform the swap
-    std::cout<<"Invalid colour assignment for "<<particle_type<<". Swapping "<<(is_antiparticle ? "Colour" : "AntiColour") <<" of "
+    colour = anticolour(colour); // Perform the swap
+    std::cout<<"Invalid colour assignment for "<<species_name(species)<<". Swapping "<<(is_antiparticle ? "Colour" : "AntiColour") <<" of "
     <<(is_antiparticle ? "AntiQuark" : "Quark")<<" to its respective "<<(is_antiparticle ? "AntiColour" : "Colour")<<".\n";
   }
 }
 
-double Quark::get_baryon_number() const
-{
-  return is_antiparticle ? -1.0/3.0 : 1.0/3.0;
-}
 
 
-void Quark::print() const
+void Quark::format_properties(TextFormatter& out) const
 {
-  Particle::print(); // Call the base class print function
-  std::cout<<"  Colour Charge: "<<colour_charge_to_string(colour)<<"\n"
-           <<"  Baron number: "<<(baryon_number)<<"\n"
-           <<"  Antiparticle: "<<(is_antiparticle ? "Yes" : "No")<<"\n";
+  Particle::format_properties(out); // Call the base class print function
+  out<<"  Colour Charge: "<<colour_charge_to_string(colour)<<"\n"
+     <<"  Baron number: "<<get_baryon_number()<<"\n"
+     <<"  Antiparticle: "<<(is_antiparticle ? "Yes" : "No")<<"\n";
 }
 
 // Quark decays
@@ -273,29 +251,57 @@ std::string colour_charge_to_string(ColourCharge colour)
   }
 }
 
+bool colour_charge_from_string(const std::string& name, ColourCharge& colour)
+{
+  for(ColourCharge candidate : {ColourCharge::Red, ColourCharge::Green, ColourCharge::Blue, ColourCharge::AntiRed, ColourCharge::AntiGreen, ColourCharge::AntiBlue})
+  {
+    if(colour_charge_to_string(candidate) == name)
+    {
+      colour = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Swapping colours to their anticolours and vice versa
+ColourCharge anticolour(ColourCharge colour)
+{
+  switch (colour)
+  {
+    case ColourCharge::Red: return ColourCharge::AntiRed;
+    case ColourCharge::Green: return ColourCharge::AntiGreen;
+    case ColourCharge::Blue: return ColourCharge::AntiBlue;
+    case ColourCharge::AntiRed: return ColourCharge::Red;
+    case ColourCharge::AntiGreen: return ColourCharge::Green;
+    case ColourCharge::AntiBlue: return ColourCharge::Blue;
+    default: return colour;
+  }
+}
+
 // Clones
 std::shared_ptr<Particle> UpQuark::clone() const
 {
-  return std::make_shared<UpQuark>(*this);
+  return allocate_particle<UpQuark>(*this);
 }
 std::shared_ptr<Particle> DownQuark::clone() const
 {
-  return std::make_shared<DownQuark>(*this);
+  return allocate_particle<DownQuark>(*this);
 }
 std::shared_ptr<Particle> CharmQuark::clone() const
 {
-  return std::make_shared<CharmQuark>(*this);
+  return allocate_particle<CharmQuark>(*this);
 }
 std::shared_ptr<Particle> StrangeQuark::clone() const
 {
-  return std::make_shared<StrangeQuark>(*this);
+  return allocate_particle<StrangeQuark>(*this);
 }
 std::shared_ptr<Particle> TopQuark::clone() const
 {
-  return std::make_shared<TopQuark>(*this);
+  return allocate_particle<TopQuark>(*this);
 }
 std::shared_ptr<Particle> BottomQuark::clone() const
 {
-  return std::make_shared<BottomQuark>(*this);
+  return allocate_particle<BottomQuark>(*this);
 }
 
@@ -14,34 +14,29 @@ enum class ColourCharge
 };
 
 std::string colour_charge_to_string(ColourCharge colour);
+bool colour_charge_from_string(const std::string& name, ColourCharge& colour); // Returns false if 'name' is not a colour
+ColourCharge anticolour(ColourCharge colour); // Neutral stays Neutral
 
 class Quark : public Particle
 {
 protected:
   ColourCharge colour;
-  double baryon_number;
 
 public:
-  Quark(double mass, double charge, double px, double py, double pz, const std::string& type, ColourCharge colour, bool is_anti,
-    double baryon_number);
+  Quark(double px, double py, double pz, Species species, ColourCharge colour, bool is_anti);
   Quark(const Quark& other); // Copy constructor
   Quark(Quark&& other) noexcept; // Move constructor
   Quark& operator=(const Quark& other); // Copy assignment operator
   Quark& operator=(Quark&& other) noexcept; // Move assignment operator
   virtual ~Quark() = default;
-  virtual void print() const override;
+  virtual void format_properties(TextFormatter& out) const override;
   virtual void decay() override; // Making Quark an abstract class since all Quarks must implement decay()
   void check_colour_consistency();
-
-  double get_baryon_number() const override;
 };
 
 
 class UpQuark : public Quark
 {
-private:
-  static constexpr double up_mass = 2.2;
-
 public:
   UpQuark(double px, double py, double pz, ColourCharge colour, bool is_anti = false);
   UpQuark(const UpQuark& other); // Copy constructor
@@ -56,9 +51,6 @@ public:
 
 class DownQuark : public Quark
 {
-private:
-  static constexpr double down_mass = 4.7;
-
 public:
   DownQuark(double px, double py, double pz, ColourCharge colour, bool is_anti = false);
   DownQuark(const DownQuark& other); // Copy constructor
@@ -73,9 +65,6 @@ public:
 
 class CharmQuark : public Quark
 {
-private:
-  static constexpr double charm_mass = 1280;
-
 public:
   CharmQuark(double px, double py, double pz, ColourCharge colour, bool is_anti = false);
   CharmQuark(const CharmQuark& other); // Copy constructor
@@ -90,9 +79,6 @@ public:
 
 class StrangeQuark : public Quark
 {
-private:
-  static constexpr double strange_mass = 95;
-
 public:
   StrangeQuark(double px, double py, double pz, ColourCharge colour, bool is_anti = false);
   StrangeQuark(const StrangeQuark& other); // Copy constructor
@@ -107,9 +93,6 @@ public:
 
 class TopQuark : public Quark
 {
-private:
-  static constexpr double top_mass = 173100;
-
 public:
   TopQuark(double px, double py, double pz, ColourCharge colour, bool is_anti = false);
   TopQuark(const TopQuark& other); // Copy constructor
@@ -124,9 +107,6 @@ public:
 
 class BottomQuark : public Quark
 {
-private:
-  static constexpr double bottom_mass = 4180;
-
 public:
   BottomQuark(double px, double py, double pz, ColourCharge colour, bool is_anti = false);
   BottomQuark(const BottomQuark& other); // Copy constructor
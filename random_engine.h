@@ -0,0 +1,170 @@
+#ifndef RANDOM_ENGINE_H
+#define RANDOM_ENGINE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+// Counter-based Philox4x32-10 generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// The state is just a key (the seed) and a counter (stream + position), so constructing one is free,
+// any stream can be jumped to directly, and the same (seed, stream) gives the same numbers on every thread.
+class RandomEngine
+{
+private:
+  std::array<std::uint32_t, 2> key;
+  std::array<std::uint32_t, 4> counter; // counter[0..1]: block position, counter[2..3]: stream id
+  std::array<std::uint32_t, 4> block;
+  int block_index;
+
+  static constexpr std::uint32_t multiplier0 = 0xD2511F53;
+  static constexpr std::uint32_t multiplier1 = 0xCD9E8D57;
+  static constexpr std::uint32_t weyl0 = 0x9E3779B9;
+  static constexpr std::uint32_t weyl1 = 0xBB67AE85;
+
+  // Philox rounds applied to the current counter
+  std::array<std::uint32_t, 4> generate_block() const
+  {
+    std::array<std::uint32_t, 4> x = counter;
+    std::array<std::uint32_t, 2> k = key;
+    for(int round = 0; round < 10; ++round)
+    {
+      std::uint64_t product0 = static_cast<std::uint64_t>(multiplier0) * x[0];
+      std::uint64_t product1 = static_cast<std::uint64_t>(multiplier1) * x[2];
+      x = {static_cast<std::uint32_t>(product1 >> 32) ^ x[1] ^ k[0], static_cast<std::uint32_t>(product1),
+           static_cast<std::uint32_t>(product0 >> 32) ^ x[3] ^ k[1], static_cast<std::uint32_t>(product0)};
+      k[0] += weyl0;
+      k[1] += weyl1;
+    }
+    return x;
+  }
+
+  void next_block()
+  {
+    block = generate_block();
+    block_index = 0;
+    if(++counter[0] == 0)
+    {
+      ++counter[1];
+    }
+  }
+
+public:
+  using result_type = std::uint64_t;
+
+  static constexpr std::uint64_t default_seed = 0x5EEDC0FFEE123457ULL;
+
+  explicit RandomEngine(std::uint64_t seed = default_seed, std::uint64_t stream = 0)
+    : key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+      counter{0, 0, static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)},
+      block{}, block_index(4) {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  result_type operator()()
+  {
+    if(block_index >= 4)
+    {
+      next_block();
+    }
+    std::uint64_t low = block[block_index++];
+    std::uint64_t high = block[block_index++];
+    return (high << 32) | low;
+  }
+
+  // Uniform double in [0, 1) built from the top 53 bits, identical on every standard library
+  double uniform()
+  {
+    return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+  }
+
+  std::uint64_t get_seed() const
+  {
+    return (static_cast<std::uint64_t>(key[1]) << 32) | key[0];
+  }
+
+  std::uint64_t get_stream() const
+  {
+    return (static_cast<std::uint64_t>(counter[3]) << 32) | counter[2];
+  }
+
+  // Independent stream derived from this one, eg one per event or per sub-decay
+  RandomEngine split(std::uint64_t id) const
+  {
+    std::uint64_t mixed = get_stream() ^ (id + 0x9E3779B97F4A7C15ULL + (get_stream() << 6) + (get_stream() >> 2));
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+    return RandomEngine(get_seed(), mixed ^ (mixed >> 31));
+  }
+
+  // Skips 'n' 64-bit outputs in O(1)
+  void discard(std::uint64_t n)
+  {
+    std::uint64_t position = ((static_cast<std::uint64_t>(counter[1]) << 32) | counter[0]) * 2 - (4 - block_index) / 2 + n;
+    std::uint64_t block_position = position / 2;
+    counter[0] = static_cast<std::uint32_t>(block_position);
+    counter[1] = static_cast<std::uint32_t>(block_position >> 32);
+    block_index = 4;
+    if(position % 2 != 0)
+    {
+      next_block();
+      block_index = 2;
+    }
+  }
+};
+
+// Seed used by every thread's default engine; thread engines take consecutive streams in creation order
+inline std::atomic<std::uint64_t>& random_seed()
+{
+  static std::atomic<std::uint64_t> seed{RandomEngine::default_seed};
+  return seed;
+}
+
+inline RandomEngine*& active_random_engine()
+{
+  thread_local RandomEngine* active = nullptr;
+  return active;
+}
+
+inline RandomEngine& default_thread_random_engine()
+{
+  static std::atomic<std::uint64_t> next_stream{0};
+  thread_local RandomEngine engine(random_seed().load(), next_stream.fetch_add(1));
+  return engine;
+}
+
+// Engine used by the decay code on this thread: the innermost ScopedRandomEngine, or the thread's default
+inline RandomEngine& thread_random_engine()
+{
+  RandomEngine* active = active_random_engine();
+  return active ? *active : default_thread_random_engine();
+}
+
+// Reseeds the default engine of the calling thread (stream 0) and of any thread started afterwards
+inline void seed_random_engines(std::uint64_t seed)
+{
+  random_seed().store(seed);
+  default_thread_random_engine() = RandomEngine(seed, 0);
+}
+
+// Makes 'engine' the calling thread's decay engine for the lifetime of the scope
+class ScopedRandomEngine
+{
+private:
+  RandomEngine* previous;
+
+public:
+  explicit ScopedRandomEngine(RandomEngine& engine) : previous(active_random_engine())
+  {
+    active_random_engine() = &engine;
+  }
+  ScopedRandomEngine(const ScopedRandomEngine&) = delete;
+  ScopedRandomEngine& operator=(const ScopedRandomEngine&) = delete;
+  ~ScopedRandomEngine()
+  {
+    active_random_engine() = previous;
+  }
+};
+
+#endif // RANDOM_ENGINE_H
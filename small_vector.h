@@ -0,0 +1,200 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A vector that keeps up to 'InlineCapacity' elements inside itself and only moves them to the heap when it grows
+// past that, so short sequences (eg the two or three products of most decays) cost no allocation at all. Supports
+// the subset of std::vector's interface the catalogue uses. Iterators are plain pointers and, as with std::vector,
+// are invalidated by anything that grows the container; moving a small vector also moves its inline elements.
+template<typename T, std::size_t InlineCapacity>
+class SmallVector
+{
+private:
+  static_assert(InlineCapacity > 0, "Use std::vector for no inline storage");
+
+  T* storage; // The inline buffer or a heap block
+  std::uint32_t count = 0; // 32-bit sizes keep the container, and so each decayed particle, smaller
+  std::uint32_t slots = InlineCapacity;
+  alignas(T) unsigned char inline_buffer[InlineCapacity * sizeof(T)];
+
+  T* inline_storage() { return std::launder(reinterpret_cast<T*>(inline_buffer)); }
+  bool is_inline() const { return slots == InlineCapacity; } // Heap blocks are always bigger
+
+  void reallocate(std::size_t new_capacity)
+  {
+    T* block = std::allocator<T>().allocate(new_capacity);
+    std::uninitialized_move(storage, storage + count, block); // Elements are nothrow movable, see below
+    std::destroy(storage, storage + count);
+    release_storage();
+    storage = block;
+    slots = static_cast<std::uint32_t>(new_capacity);
+  }
+
+  void release_storage()
+  {
+    if(!is_inline())
+    {
+      std::allocator<T>().deallocate(storage, slots);
+    }
+  }
+
+  void grow_for(std::size_t extra)
+  {
+    if(count + extra > slots)
+    {
+      reallocate(std::max<std::size_t>(count + extra, 2 * std::size_t{slots}));
+    }
+  }
+
+  void take_from(SmallVector&& other) noexcept
+  {
+    if(other.is_inline())
+    {
+      std::uninitialized_move(other.storage, other.storage + other.count, storage);
+      count = other.count;
+      other.clear();
+    }
+    else
+    { // Steals the heap block and leaves 'other' empty and inline
+      storage = other.storage;
+      count = other.count;
+      slots = other.slots;
+      other.storage = other.inline_storage();
+      other.count = 0;
+      other.slots = InlineCapacity;
+    }
+  }
+
+public:
+  static_assert(std::is_nothrow_move_constructible_v<T>, "Elements are moved when the storage changes");
+
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr std::size_t inline_capacity = InlineCapacity;
+
+  SmallVector() : storage(inline_storage()) {}
+
+  template<typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  SmallVector(InputIt first, InputIt last) : SmallVector()
+  {
+    for(; first != last; ++first)
+    {
+      push_back(*first);
+    }
+  }
+
+  SmallVector(std::initializer_list<T> values) : SmallVector(values.begin(), values.end()) {}
+  SmallVector(const SmallVector& other) : SmallVector(other.begin(), other.end()) {}
+  SmallVector(SmallVector&& other) noexcept : SmallVector() { take_from(std::move(other)); }
+
+  SmallVector& operator=(const SmallVector& other)
+  {
+    if(this != &other)
+    {
+      clear();
+      reserve(other.count);
+      std::uninitialized_copy(other.begin(), other.end(), storage);
+      count = other.count;
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other) noexcept
+  {
+    if(this != &other)
+    {
+      clear();
+      release_storage();
+      storage = inline_storage();
+      slots = InlineCapacity;
+      take_from(std::move(other));
+    }
+    return *this;
+  }
+
+  ~SmallVector()
+  {
+    clear();
+    release_storage();
+  }
+
+  std::size_t size() const { return count; }
+  std::size_t capacity() const { return slots; }
+  bool empty() const { return count == 0; }
+
+  T* data() { return storage; }
+  const T* data() const { return storage; }
+  T& operator[](std::size_t i) { return storage[i]; }
+  const T& operator[](std::size_t i) const { return storage[i]; }
+  T& front() { return storage[0]; }
+  const T& front() const { return storage[0]; }
+  T& back() { return storage[count - 1]; }
+  const T& back() const { return storage[count - 1]; }
+
+  iterator begin() { return storage; }
+  iterator end() { return storage + count; }
+  const_iterator begin() const { return storage; }
+  const_iterator end() const { return storage + count; }
+  const_iterator cbegin() const { return storage; }
+  const_iterator cend() const { return storage + count; }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  void reserve(std::size_t new_capacity)
+  {
+    if(new_capacity > slots)
+    {
+      reallocate(new_capacity);
+    }
+  }
+
+  template<typename... Args>
+  T& emplace_back(Args&&... args)
+  {
+    if(count == slots)
+    { // Built first, as 'args' may refer to an element that reallocating would move
+      T value(std::forward<Args>(args)...);
+      grow_for(1);
+      ::new(static_cast<void*>(storage + count)) T(std::move(value));
+    }
+    else
+    {
+      ::new(static_cast<void*>(storage + count)) T(std::forward<Args>(args)...);
+    }
+    return storage[count++];
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  void pop_back()
+  {
+    std::destroy_at(storage + --count);
+  }
+
+  void clear() // Keeps the capacity, like std::vector
+  {
+    std::destroy(storage, storage + count);
+    count = 0;
+  }
+};
+
+#endif // SMALL_VECTOR_H
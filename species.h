@@ -0,0 +1,181 @@
+#ifndef SPECIES_H
+#define SPECIES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Dense identifier of every particle species (antiparticles are separate species), usable as an array index
+enum class Species : std::uint8_t
+{
+  Electron, AntiElectron, ElectronNeutrino, AntiElectronNeutrino,
+  Muon, AntiMuon, MuonNeutrino, AntiMuonNeutrino,
+  Tau, AntiTau, TauNeutrino, AntiTauNeutrino,
+  UpQuark, AntiUpQuark, DownQuark, AntiDownQuark,
+  CharmQuark, AntiCharmQuark, StrangeQuark, AntiStrangeQuark,
+  TopQuark, AntiTopQuark, BottomQuark, AntiBottomQuark,
+  Photon, WPlus, WMinus, ZBoson, HiggsBoson, Gluon
+};
+
+constexpr std::size_t species_count = static_cast<std::size_t>(Species::Gluon) + 1;
+
+constexpr std::size_t species_index(Species species)
+{
+  return static_cast<std::size_t>(species);
+}
+
+// Type names as printed and as used by the string-based catalogue API
+constexpr std::array<std::string_view, species_count> species_names =
+{
+  "Electron", "AntiElectron", "ElectronNeutrino", "AntiElectronNeutrino",
+  "Muon", "AntiMuon", "MuonNeutrino", "AntiMuonNeutrino",
+  "Tau", "AntiTau", "TauNeutrino", "AntiTauNeutrino",
+  "UpQuark", "AntiUpQuark", "DownQuark", "AntiDownQuark",
+  "CharmQuark", "AntiCharmQuark", "StrangeQuark", "AntiStrangeQuark",
+  "TopQuark", "AntiTopQuark", "BottomQuark", "AntiBottomQuark",
+  "Photon", "W+", "W-", "ZBoson", "HiggsBoson", "Gluon"
+};
+
+constexpr std::string_view species_name(Species species)
+{
+  return species_names[species_index(species)];
+}
+
+// Charge conjugate; self-conjugate species (Photon, ZBoson, HiggsBoson, Gluon) map to themselves
+constexpr Species antiparticle_of(Species species)
+{
+  if(species < Species::Photon)
+  {
+    return static_cast<Species>(species_index(species) ^ 1); // Particles and antiparticles are interleaved
+  }
+  if(species == Species::WPlus || species == Species::WMinus)
+  {
+    return species == Species::WPlus ? Species::WMinus : Species::WPlus;
+  }
+  return species;
+}
+
+// Particle Data Group Monte Carlo numbering, antiparticles negative
+constexpr std::array<int, species_count> species_pdg_codes =
+{
+  11, -11, 12, -12,
+  13, -13, 14, -14,
+  15, -15, 16, -16,
+  2, -2, 1, -1,
+  4, -4, 3, -3,
+  6, -6, 5, -5,
+  22, 24, -24, 23, 25, 21
+};
+
+constexpr int pdg_code(Species species)
+{
+  return species_pdg_codes[species_index(species)];
+}
+
+namespace species_detail
+{
+  constexpr int max_pdg_code = 25;
+  constexpr std::uint8_t no_species = 0xFF;
+
+  // PDG code + max_pdg_code -> dense species index, or no_species
+  constexpr std::array<std::uint8_t, 2 * max_pdg_code + 1> make_pdg_table()
+  {
+    std::array<std::uint8_t, 2 * max_pdg_code + 1> table{};
+    for(auto& entry : table)
+    {
+      entry = no_species;
+    }
+    for(std::size_t i = 0; i < species_count; ++i)
+    {
+      table[species_pdg_codes[i] + max_pdg_code] = static_cast<std::uint8_t>(i);
+    }
+    return table;
+  }
+  constexpr auto pdg_table = make_pdg_table();
+
+  // Perfect hash of the species names: FNV-1a with a seed searched at compile time so that every name lands in
+  // its own slot. A lookup is one hash and one string comparison, with no allocation.
+  constexpr std::size_t name_slots = 64;
+
+  constexpr std::uint32_t name_hash(std::string_view name, std::uint32_t seed)
+  {
+    std::uint32_t hash = 2166136261u ^ seed;
+    for(char c : name)
+    {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash ^ (hash >> 15);
+  }
+
+  constexpr bool seed_is_perfect(std::uint32_t seed)
+  {
+    std::array<bool, name_slots> used{};
+    for(std::string_view name : species_names)
+    {
+      std::size_t slot = name_hash(name, seed) % name_slots;
+      if(used[slot])
+      {
+        return false;
+      }
+      used[slot] = true;
+    }
+    return true;
+  }
+
+  constexpr std::uint32_t find_name_seed()
+  {
+    std::uint32_t seed = 0;
+    while(!seed_is_perfect(seed))
+    {
+      ++seed;
+    }
+    return seed;
+  }
+  constexpr std::uint32_t name_seed = find_name_seed();
+
+  constexpr std::array<std::uint8_t, name_slots> make_name_table()
+  {
+    std::array<std::uint8_t, name_slots> table{};
+    for(auto& entry : table)
+    {
+      entry = no_species;
+    }
+    for(std::size_t i = 0; i < species_count; ++i)
+    {
+      table[name_hash(species_names[i], name_seed) % name_slots] = static_cast<std::uint8_t>(i);
+    }
+    return table;
+  }
+  constexpr auto name_table = make_name_table();
+}
+
+// Returns false if 'name' is not a known species
+constexpr bool species_from_name(std::string_view name, Species& species)
+{
+  std::uint8_t index = species_detail::name_table[species_detail::name_hash(name, species_detail::name_seed) % species_detail::name_slots];
+  if(index == species_detail::no_species || species_names[index] != name)
+  {
+    return false;
+  }
+  species = static_cast<Species>(index);
+  return true;
+}
+
+// Returns false if 'code' is not the PDG code of a known species
+constexpr bool species_from_pdg(int code, Species& species)
+{
+  if(code < -species_detail::max_pdg_code || code > species_detail::max_pdg_code)
+  {
+    return false;
+  }
+  std::uint8_t index = species_detail::pdg_table[code + species_detail::max_pdg_code];
+  if(index == species_detail::no_species)
+  {
+    return false;
+  }
+  species = static_cast<Species>(index);
+  return true;
+}
+
+#endif // SPECIES_H
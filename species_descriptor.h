@@ -0,0 +1,75 @@
+#ifndef SPECIES_DESCRIPTOR_H
+#define SPECIES_DESCRIPTOR_H
+
+#include "quantum_numbers.h"
+#include "species.h"
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// Everything about a species that is the same for each of its particles. Particles store only their Species and
+// read these through species_descriptor(), a constant-time table lookup with no virtual call.
+struct SpeciesDescriptor
+{
+  std::string_view name;
+  int pdg_code;
+  double mass; // MeV/c^2
+  double charge; // In units of e
+  double spin;
+  int electron_lepton_number;
+  int muon_lepton_number;
+  int tau_lepton_number;
+  double baryon_number;
+  QuantumNumbers quantum_numbers;
+};
+
+namespace species_detail
+{
+  // Rest masses in MeV/c^2, antiparticles the same; neutrino masses are taken as zero
+  constexpr std::array<double, species_count> species_masses =
+  {
+    0.511, 0.511, 0, 0,
+    105.66, 105.66, 0, 0,
+    1776.86, 1776.86, 0, 0,
+    2.2, 2.2, 4.7, 4.7,
+    1280, 1280, 95, 95,
+    173100, 173100, 4180, 4180,
+    0, 80377, 80377, 91187.6, 125110, 0
+  };
+
+  constexpr double species_spin(Species species)
+  {
+    if(species < Species::Photon)
+    {
+      return 0.5; // Leptons and quarks
+    }
+    return species == Species::HiggsBoson ? 0 : 1;
+  }
+
+  constexpr std::array<SpeciesDescriptor, species_count> make_descriptor_table()
+  {
+    std::array<SpeciesDescriptor, species_count> table{};
+    for(std::size_t i = 0; i < species_count; ++i)
+    {
+      Species species = static_cast<Species>(i);
+      QuantumNumbers numbers = ::quantum_numbers(species);
+      table[i] = {species_names[i], species_pdg_codes[i], species_masses[i],
+                  quantum_lane(numbers, QuantumLane::ChargeThirds) / 3.0, species_spin(species),
+                  quantum_lane(numbers, QuantumLane::ElectronLepton), quantum_lane(numbers, QuantumLane::MuonLepton),
+                  quantum_lane(numbers, QuantumLane::TauLepton), quantum_lane(numbers, QuantumLane::BaryonThirds) / 3.0,
+                  numbers};
+    }
+    return table;
+  }
+  constexpr auto descriptor_table = make_descriptor_table();
+}
+
+constexpr const SpeciesDescriptor& species_descriptor(Species species)
+{
+  return species_detail::descriptor_table[species_index(species)];
+}
+
+static_assert(species_descriptor(Species::AntiDownQuark).charge == 1.0 / 3.0, "AntiDownQuark has charge +1/3");
+static_assert(species_descriptor(Species::WMinus).charge == -1, "W- has charge -1");
+
+#endif // SPECIES_DESCRIPTOR_H
@@ -0,0 +1,43 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cmath>
+#include <iostream>
+
+// Checks for the standalone test programs in this directory. A failed CHECK prints its file, line and condition and
+// the test carries on; main returns test_result(), nonzero if anything failed.
+inline int& failed_checks()
+{
+  static int failed = 0;
+  return failed;
+}
+
+inline void report_check(bool passed, const char* condition, const char* file, int line)
+{
+  if(!passed)
+  {
+    std::cerr<<file<<":"<<line<<": check failed: "<<condition<<std::endl;
+    failed_checks()++;
+  }
+}
+
+#define CHECK(condition) report_check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, tolerance) report_check(std::abs((a) - (b)) <= (tolerance), #a " ~ " #b, __FILE__, __LINE__)
+
+// Runs 'expression' and checks that it throws 'Exception'
+#define CHECK_THROWS(expression, Exception) \
+  do \
+  { \
+    bool thrown = false; \
+    try { expression; } \
+    catch(const Exception&) { thrown = true; } \
+    report_check(thrown, #expression " throws " #Exception, __FILE__, __LINE__); \
+  } while(false)
+
+inline int test_result(const char* name)
+{
+  std::cout<<name<<": "<<(failed_checks() == 0 ? "passed" : "FAILED")<<std::endl;
+  return failed_checks() == 0 ? 0 : 1;
+}
+
+#endif // TESTS_CHECK_H
@@ -0,0 +1,137 @@
+// AngularIndex (angular_index.h): cone and nearest-neighbour queries find exactly what a scan of every point finds,
+// across phi = +-pi and beyond the eta range of the grid
+
+#include "../angular_index.h"
+#include "../lepton.h"
+#include "../particle_catalogue.h"
+#include "../particle_factory.h"
+#include "check.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+  using Index = AngularIndex<int>;
+
+  std::set<int> brute_cone(const std::vector<Index::Point>& points, double eta, double phi, double radius)
+  {
+    std::set<int> found;
+    for(const Index::Point& point : points)
+    {
+      if(delta_r(eta, phi, point.eta, point.phi) < radius)
+      {
+        found.insert(point.id);
+      }
+    }
+    return found;
+  }
+
+  std::vector<double> brute_nearest(const std::vector<Index::Point>& points, double eta, double phi, std::size_t k)
+  {
+    std::vector<double> distances;
+    for(const Index::Point& point : points)
+    {
+      distances.push_back(delta_r(eta, phi, point.eta, point.phi));
+    }
+    std::sort(distances.begin(), distances.end());
+    distances.resize(std::min(k, distances.size()));
+    return distances;
+  }
+}
+
+int main()
+{
+  // delta_phi folds into [-pi, pi]
+  CHECK_NEAR(delta_phi(3.1, -3.1), 6.2 - 2 * M_PI, 1e-12);
+  CHECK_NEAR(std::abs(delta_phi(M_PI - 0.05, -M_PI + 0.05)), 0.1, 1e-12);
+  CHECK_NEAR(delta_r(0, 0, 0.3, 0.4), 0.5, 1e-12);
+
+  std::mt19937 generator(15);
+  std::uniform_real_distribution<double> eta_value(-6, 6), phi_value(-M_PI, M_PI), radius_value(0.05, 1.5);
+  std::vector<Index::Point> points;
+  for(int i = 0; i < 2000; ++i)
+  {
+    points.push_back(Index::Point{eta_value(generator), phi_value(generator), 1.0, i});
+  }
+  // Points right on the seam and at the edges of the grid
+  points.push_back(Index::Point{0.0, M_PI, 1.0, 2000});
+  points.push_back(Index::Point{0.0, -M_PI, 1.0, 2001});
+  points.push_back(Index::Point{5.0, 0.0, 1.0, 2002});
+  points.push_back(Index::Point{-5.0, 0.0, 1.0, 2003});
+
+  for(double cell_size : {0.4, 1.0, 7.0})
+  {
+    Index index(points, cell_size);
+    CHECK(index.size() == points.size());
+
+    for(int query = 0; query < 300; ++query)
+    {
+      double eta = eta_value(generator), radius = radius_value(generator);
+      double phi = query % 3 == 0 ? M_PI - 0.01 : phi_value(generator); // A third of the queries sit on the seam
+      std::set<int> found;
+      bool distances_right = true;
+      for(const Index::Neighbour& neighbour : index.cone(eta, phi, radius))
+      {
+        CHECK(found.insert(neighbour.id).second); // Each point at most once
+        const Index::Point& point = points[neighbour.id];
+        distances_right = distances_right && std::abs(neighbour.delta_r - delta_r(eta, phi, point.eta, point.phi)) < 1e-12;
+      }
+      CHECK(distances_right);
+      CHECK(found == brute_cone(points, eta, phi, radius));
+
+      std::size_t k = 1 + query % 20;
+      std::vector<Index::Neighbour> nearest = index.nearest(eta, phi, k);
+      std::vector<double> nearest_distances;
+      for(const Index::Neighbour& neighbour : nearest)
+      {
+        nearest_distances.push_back(neighbour.delta_r);
+      }
+      CHECK(nearest_distances == brute_nearest(points, eta, phi, k)); // Closest first
+    }
+
+    // A cone wider than the whole phi range, and asking for more neighbours than there are points
+    CHECK(index.cone(0, 0, 10).size() == brute_cone(points, 0, 0, 10).size());
+    CHECK(index.nearest(0, 0, points.size() + 5).size() == points.size());
+    CHECK(index.nearest(0, 0, 0).empty());
+  }
+
+  // Neighbours across the seam are found from either side
+  Index seam({Index::Point{0.0, M_PI - 0.05, 1.0, 1}, Index::Point{0.0, -M_PI + 0.05, 1.0, 2}, Index::Point{0.0, 0.0, 1.0, 3}});
+  std::vector<Index::Neighbour> across = seam.cone(0.0, M_PI - 0.05, 0.2);
+  CHECK(across.size() == 2);
+  std::vector<Index::Neighbour> closest = seam.nearest(0.0, -M_PI + 0.05, 2);
+  CHECK(closest.size() == 2 && closest[0].id == 2 && closest[1].id == 1);
+  CHECK_NEAR(closest[1].delta_r, 0.1, 1e-12);
+
+  // An empty index answers every query with nothing
+  Index empty({});
+  CHECK(empty.cone(0, 0, 1).empty());
+  CHECK(empty.nearest(0, 0, 3).empty());
+
+  // Over a catalogue the ids are handles, and muon isolation counts the pT of everything else in the cone
+  ParticleCatalogue<Particle> catalogue;
+  auto crowded = std::make_shared<Muon>(10, 0, 0); // phi = 0, with a hard photon beside it
+  auto seam_muon = std::make_shared<Muon>(-10, 0.1, 0); // phi just below pi, with a hard photon just above -pi
+  auto alone = std::make_shared<Muon>(0, 10, 0, true, true);
+  ParticleHandle crowded_handle = catalogue.add_particle(crowded);
+  catalogue.add_particle(seam_muon);
+  catalogue.add_particle(alone);
+  catalogue.add_particle(make_particle(Species::Photon, 5, 0.5, 0));
+  catalogue.add_particle(make_particle(Species::Photon, -5, -0.3, 0));
+  catalogue.add_particle(make_particle(Species::Photon, 0.05, 0.5, 0)); // In the lone muon's cone but soft
+  AngularIndex<ParticleHandle> by_handle = catalogue.angular_index();
+  CHECK(by_handle.size() == catalogue.size());
+  std::vector<AngularIndex<ParticleHandle>::Neighbour> closest_to_crowded = by_handle.nearest(crowded->get_four_momentum(), 1);
+  CHECK(closest_to_crowded.size() == 1 && closest_to_crowded[0].id == crowded_handle);
+  CHECK(catalogue.get(closest_to_crowded[0].id) == crowded.get());
+  catalogue.update_muon_isolation();
+  CHECK(!crowded->get_isolated());
+  CHECK(!seam_muon->get_isolated());
+  CHECK(alone->get_isolated());
+
+  return test_result("angular index");
+}
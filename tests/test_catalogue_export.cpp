@@ -0,0 +1,449 @@
+// CatalogueExporter (catalogue_export.h): every format reads back to the same decay trees as DecayTreeArena, however
+// the trees fall across the blocks handed to the writer thread
+
+#include "../bosons.h"
+#include "../catalogue_export.h"
+#include "../lepton.h"
+#include "../particle_catalogue.h"
+#include "../random_engine.h"
+#include "check.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const char* const columnar_path = "test_catalogue_export.pcol";
+  const char* const json_path = "test_catalogue_export.jsonl";
+  const char* const csv_path = "test_catalogue_export.csv";
+
+  // One node read back from an export; parents are indices within the node's own tree, -1 for the base particle
+  struct Node
+  {
+    std::size_t tree = 0;
+    long long parent = -1;
+    Species species = Species::Photon;
+    double e = 0, px = 0, py = 0, pz = 0;
+  };
+
+  std::string read_bytes(const std::string& path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  // Every decay tree in the catalogue, as DecayTreeArena flattens it, with the tree each record belongs to
+  void expected_nodes(const ParticleCatalogue<Particle>& catalogue, std::vector<ParticleRecord>& records, std::vector<std::size_t>& trees)
+  {
+    std::size_t tree = 0;
+    for(const Particle& particle : catalogue.all_particles())
+    {
+      DecayTreeArena arena = particle.decay_tree();
+      records.insert(records.end(), arena.records().begin(), arena.records().end());
+      trees.insert(trees.end(), arena.size(), tree++);
+    }
+  }
+
+  // Momenta are compared exactly: numbers are written in a form that reads back to the same double
+  bool same_nodes(const std::vector<Node>& nodes, const std::vector<ParticleRecord>& records, const std::vector<std::size_t>& trees)
+  {
+    if(nodes.size() != records.size())
+    {
+      return false;
+    }
+    for(std::size_t i = 0; i < nodes.size(); ++i)
+    {
+      const Node& node = nodes[i];
+      const ParticleRecord& record = records[i];
+      long long parent = record.parent == ParticleRecord::no_index ? -1 : static_cast<long long>(record.parent);
+      if(node.tree != trees[i] || node.parent != parent || node.species != record.species || node.e != record.momentum.get_e() ||
+         node.px != record.momentum.get_px() || node.py != record.momentum.get_py() || node.pz != record.momentum.get_pz())
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template<typename Value>
+  Value read_raw(const std::string& bytes, std::size_t& at)
+  {
+    Value value;
+    std::memcpy(&value, bytes.data() + at, sizeof(value));
+    at += sizeof(value);
+    return value;
+  }
+
+  // Reads the columnar file back, checking its framing, that each block starts at a base particle and that the
+  // descendant counts and flags match 'records'
+  std::vector<Node> read_columnar(const std::string& bytes, const std::vector<ParticleRecord>& records, std::size_t& blocks)
+  {
+    std::vector<Node> nodes;
+    blocks = 0;
+    if(bytes.size() < 16 || bytes.compare(0, 8, "PCATCOLS") != 0)
+    {
+      CHECK(!"columnar export starts with its tag");
+      return nodes;
+    }
+    std::size_t at = 8;
+    CHECK(read_raw<std::uint32_t>(bytes, at) == 1);
+    CHECK(read_raw<std::uint32_t>(bytes, at) == 0x01020304);
+    std::size_t tree = 0;
+    bool framed = true, counts_match = true;
+    while(framed && at + 16 <= bytes.size())
+    {
+      std::uint64_t particles = read_raw<std::uint64_t>(bytes, at);
+      std::uint64_t count = read_raw<std::uint64_t>(bytes, at);
+      auto padded = [](std::size_t size) { return (size + 7) / 8 * 8; };
+      std::size_t block_bytes = 4 * 8 * count + padded(4 * count) * 2 + padded(count) * 2;
+      framed = count > 0 && at + block_bytes <= bytes.size();
+      if(!framed)
+      {
+        break;
+      }
+      std::size_t first = nodes.size(), roots = 0, root = 0;
+      nodes.resize(first + count);
+      for(double Node::*column : {&Node::e, &Node::px, &Node::py, &Node::pz})
+      {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+          nodes[first + i].*column = read_raw<double>(bytes, at);
+        }
+      }
+      std::size_t descendants_at = at + padded(4 * count), species_at = descendants_at + padded(4 * count);
+      std::size_t flags_at = species_at + padded(count);
+      for(std::size_t i = 0; i < count; ++i)
+      {
+        Node& node = nodes[first + i];
+        std::uint32_t parent = read_raw<std::uint32_t>(bytes, at);
+        if(parent == ParticleRecord::no_index)
+        {
+          if(i != 0)
+          {
+            tree++;
+          }
+          root = i;
+          roots++;
+          node.parent = -1;
+        }
+        else
+        {
+          framed = framed && i != 0 && parent >= root && parent < i; // A tree never continues from the last block
+          node.parent = static_cast<long long>(parent) - static_cast<long long>(root);
+        }
+        node.tree = tree;
+        node.species = static_cast<Species>(static_cast<std::uint8_t>(bytes[species_at + i]));
+        if(first + i < records.size())
+        {
+          std::size_t descendants_column = descendants_at + 4 * i;
+          counts_match = counts_match && read_raw<std::uint32_t>(bytes, descendants_column) == records[first + i].descendant_count &&
+                         static_cast<std::uint8_t>(bytes[flags_at + i]) == records[first + i].flags;
+        }
+      }
+      framed = framed && roots == particles;
+      at = flags_at + padded(count);
+      tree++;
+      blocks++;
+    }
+    CHECK(framed);
+    CHECK(at == bytes.size());
+    CHECK(counts_match);
+    return nodes;
+  }
+
+  // A parser for just what the JSON Lines encoder writes: objects with string and number values and nested
+  // decay_products arrays
+  class JsonReader
+  {
+  private:
+    const std::string& text;
+    std::size_t at = 0;
+    std::vector<Node>& nodes;
+    std::size_t tree_start; // Where the line's base particle is in 'nodes'
+
+    bool take(char expected)
+    {
+      if(at < text.size() && text[at] == expected)
+      {
+        at++;
+        return true;
+      }
+      return false;
+    }
+
+    std::string string()
+    {
+      std::string value;
+      if(!take('"'))
+      {
+        throw std::invalid_argument("expected a string");
+      }
+      while(at < text.size() && text[at] != '"')
+      {
+        value.push_back(text[at++]);
+      }
+      take('"');
+      return value;
+    }
+
+    double number()
+    {
+      const char* start = text.c_str() + at;
+      char* end = nullptr;
+      double value = std::strtod(start, &end);
+      if(end == start)
+      {
+        throw std::invalid_argument("expected a number");
+      }
+      at += end - start;
+      return value;
+    }
+
+    void object(std::size_t tree, long long parent)
+    {
+      std::size_t index = nodes.size();
+      nodes.push_back(Node{tree, parent});
+      long long in_tree = static_cast<long long>(index - tree_start); // What this object's products give as parent
+      if(!take('{'))
+      {
+        throw std::invalid_argument("expected an object");
+      }
+      do
+      {
+        std::string key = string();
+        if(!take(':'))
+        {
+          throw std::invalid_argument("expected a colon");
+        }
+        if(key == "species")
+        {
+          if(!species_from_name(string(), nodes[index].species))
+          {
+            throw std::invalid_argument("unknown species");
+          }
+        }
+        else if(key == "pdg")
+        {
+          pdg_ok = pdg_ok && number() == pdg_code(nodes[index].species);
+        }
+        else if(key == "e") { nodes[index].e = number(); }
+        else if(key == "px") { nodes[index].px = number(); }
+        else if(key == "py") { nodes[index].py = number(); }
+        else if(key == "pz") { nodes[index].pz = number(); }
+        else if(key == "decay_products")
+        {
+          if(!take('['))
+          {
+            throw std::invalid_argument("expected an array");
+          }
+          do
+          {
+            object(tree, in_tree);
+          } while(take(','));
+          if(!take(']'))
+          {
+            throw std::invalid_argument("unclosed array");
+          }
+        }
+        else
+        {
+          throw std::invalid_argument("unexpected key " + key);
+        }
+      } while(take(','));
+      if(!take('}'))
+      {
+        throw std::invalid_argument("unclosed object");
+      }
+    }
+
+  public:
+    bool pdg_ok = true;
+
+    JsonReader(const std::string& line, std::vector<Node>& nodes) : text(line), nodes(nodes), tree_start(nodes.size()) {}
+
+    // Parses one line; false unless it is exactly one object
+    bool line(std::size_t tree)
+    {
+      object(tree, -1);
+      return at == text.size();
+    }
+  };
+
+  std::vector<Node> read_json_lines(const std::string& text, bool& parsed)
+  {
+    std::vector<Node> nodes;
+    std::istringstream in(text);
+    std::string line;
+    parsed = true;
+    for(std::size_t tree = 0; std::getline(in, line); ++tree)
+    {
+      JsonReader reader(line, nodes);
+      try
+      {
+        parsed = parsed && reader.line(tree) && reader.pdg_ok;
+      }
+      catch(const std::invalid_argument&)
+      {
+        parsed = false;
+      }
+    }
+    return nodes;
+  }
+
+  std::vector<Node> read_csv(const std::string& text, bool& parsed)
+  {
+    std::vector<Node> nodes;
+    std::istringstream in(text);
+    std::string line;
+    std::getline(in, line);
+    parsed = line == "event,node,parent,species,pdg,e,px,py,pz";
+    std::size_t node_in_tree = 0;
+    while(std::getline(in, line))
+    {
+      std::vector<std::string> fields;
+      std::istringstream row(line);
+      for(std::string field; std::getline(row, field, ',');)
+      {
+        fields.push_back(field);
+      }
+      Node node;
+      if(fields.size() != 9 || !species_from_name(fields[3], node.species))
+      {
+        parsed = false;
+        continue;
+      }
+      node.tree = std::stoull(fields[0]);
+      node.parent = std::stoll(fields[2]);
+      node_in_tree = node.parent == -1 ? 0 : node_in_tree + 1;
+      parsed = parsed && std::stoull(fields[1]) == node_in_tree && std::stoi(fields[4]) == pdg_code(node.species);
+      node.e = std::strtod(fields[5].c_str(), nullptr);
+      node.px = std::strtod(fields[6].c_str(), nullptr);
+      node.py = std::strtod(fields[7].c_str(), nullptr);
+      node.pz = std::strtod(fields[8].c_str(), nullptr);
+      nodes.push_back(node);
+    }
+    return nodes;
+  }
+
+  // Exports 'catalogue' to 'path' through CatalogueExporter, a particle or an arena at a time
+  bool export_to(const ParticleCatalogue<Particle>& catalogue, const char* path, ExportFormat format, std::size_t block_nodes,
+                 bool through_arenas = false)
+  {
+    CatalogueExporter exporter;
+    if(!exporter.open(path, format, block_nodes))
+    {
+      return false;
+    }
+    for(const Particle& particle : catalogue.all_particles())
+    {
+      if(through_arenas)
+      {
+        exporter.write(particle.decay_tree());
+      }
+      else
+      {
+        exporter.write(particle);
+      }
+    }
+    return exporter.close();
+  }
+}
+
+int main()
+{
+  // Decayed W, Z and tau trees of a few levels, between particles that never decayed
+  ParticleCatalogue<Particle> catalogue;
+  RandomEngine rng(20);
+  std::ostringstream quiet; // Decays report calorimeter adjustments on std::cerr
+  std::streambuf* cerr_buffer = std::cerr.rdbuf(quiet.rdbuf());
+  for(int i = 0; i < 6; ++i)
+  {
+    auto w_boson = std::make_shared<WBoson>(i % 2 == 0 ? 1 : -1, 10 + i, -20, 76);
+    w_boson->decay_with(rng);
+    auto z_boson = std::make_shared<ZBoson>(190, 423 - 50 * i, 780);
+    z_boson->decay_with(rng);
+    auto tau_particle = std::make_shared<Tau>(24, 256, 34 + i, i % 2 == 1);
+    tau_particle->decay_with(rng);
+    auto nested = std::make_shared<ZBoson>(-5, 7.25, 0.1 * i);
+    nested->decay_with(rng);
+    nested->add_decay_product(z_boson->clone()); // A decayed Z below another Z's products
+    catalogue.add_particle(w_boson);
+    catalogue.add_particle(std::make_shared<Electron>(1.0 / 3, 2, 3 + i));
+    catalogue.add_particle(z_boson);
+    catalogue.add_particle(tau_particle);
+    catalogue.add_particle(nested);
+  }
+  std::cerr.rdbuf(cerr_buffer);
+  std::vector<ParticleRecord> records;
+  std::vector<std::size_t> trees;
+  expected_nodes(catalogue, records, trees);
+  bool grandchildren = false;
+  for(const ParticleRecord& record : records)
+  {
+    grandchildren = grandchildren || (record.parent != ParticleRecord::no_index && record.parent != 0);
+  }
+  CHECK(records.size() > 3 * catalogue.size());
+  CHECK(grandchildren);
+
+  // Small blocks put a hand-off inside almost every tree's worth of nodes; one node per block hands off every tree;
+  // the default holds the whole catalogue in one block
+  for(std::size_t block_nodes : {std::size_t(3), std::size_t(1), std::size_t(1) << 16})
+  {
+    std::size_t blocks = 0;
+    CHECK(export_to(catalogue, columnar_path, ExportFormat::Columnar, block_nodes));
+    const std::string columnar = read_bytes(columnar_path);
+    CHECK(same_nodes(read_columnar(columnar, records, blocks), records, trees));
+    CHECK(block_nodes == 1 ? blocks == catalogue.size() : block_nodes == 3 ? blocks > catalogue.size() / 4 : blocks == 1);
+
+    bool parsed = false;
+    CHECK(export_to(catalogue, json_path, ExportFormat::JsonLines, block_nodes));
+    const std::string json = read_bytes(json_path);
+    CHECK(same_nodes(read_json_lines(json, parsed), records, trees));
+    CHECK(parsed);
+
+    CHECK(export_to(catalogue, csv_path, ExportFormat::Csv, block_nodes));
+    const std::string csv = read_bytes(csv_path);
+    CHECK(same_nodes(read_csv(csv, parsed), records, trees));
+    CHECK(parsed);
+
+    // Writing arenas gives the same bytes as writing the particles they were built from
+    CHECK(export_to(catalogue, columnar_path, ExportFormat::Columnar, block_nodes, true));
+    CHECK(read_bytes(columnar_path) == columnar);
+    CHECK(export_to(catalogue, json_path, ExportFormat::JsonLines, block_nodes, true));
+    CHECK(read_bytes(json_path) == json);
+    CHECK(export_to(catalogue, csv_path, ExportFormat::Csv, block_nodes, true));
+    CHECK(read_bytes(csv_path) == csv);
+  }
+
+  // export_catalogue writes what the exporter does with its default block size
+  CHECK(export_catalogue(catalogue, csv_path, ExportFormat::Csv));
+  std::string csv = read_bytes(csv_path);
+  CHECK(export_to(catalogue, csv_path, ExportFormat::Csv, 1 << 16));
+  CHECK(read_bytes(csv_path) == csv);
+
+  // An empty catalogue gives just the header, and a file that cannot be opened is reported
+  ParticleCatalogue<Particle> empty;
+  CHECK(export_catalogue(empty, columnar_path, ExportFormat::Columnar));
+  CHECK(read_bytes(columnar_path).size() == 16);
+  CHECK(export_catalogue(empty, json_path, ExportFormat::JsonLines));
+  CHECK(read_bytes(json_path).empty());
+  CHECK(export_catalogue(empty, csv_path, ExportFormat::Csv));
+  CHECK(read_bytes(csv_path) == "event,node,parent,species,pdg,e,px,py,pz\n");
+  CHECK(!export_catalogue(catalogue, "no_such_directory/export.csv", ExportFormat::Csv));
+  CatalogueExporter closed;
+  CHECK(!closed.is_open());
+  CHECK(!closed.close());
+
+  std::remove(columnar_path);
+  std::remove(json_path);
+  std::remove(csv_path);
+  return test_result("catalogue export");
+}
@@ -0,0 +1,120 @@
+// Generational handles into ParticleCatalogue's slot map: lookup, O(1) removal, stale handles and slot reuse
+
+#include "../lepton.h"
+#include "../particle_catalogue.h"
+#include "../particle_factory.h"
+#include "check.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+  // Recomputes the running momentum total by walking the catalogue
+  FourMomentum walked_total(const ParticleCatalogue<Particle>& catalogue)
+  {
+    FourMomentum total;
+    for(const Particle& particle : catalogue.all_particles())
+    {
+      total += particle.get_four_momentum();
+    }
+    return total;
+  }
+}
+
+int main()
+{
+  ParticleCatalogue<Particle> catalogue;
+
+  // A handle finds its particle however many others are added or removed around it
+  auto first = std::make_shared<Electron>(1, 2, 3);
+  auto second = std::make_shared<Electron>(4, 5, 6);
+  auto muon = std::make_shared<Muon>(7, 8, 9);
+  ParticleHandle first_handle = catalogue.add_particle(first);
+  ParticleHandle second_handle = catalogue.add_particle(second);
+  ParticleHandle muon_handle = catalogue.add_particle(muon);
+  CHECK(catalogue.size() == 3);
+  CHECK(catalogue.get(first_handle) == first.get());
+  CHECK(catalogue.shared(muon_handle) == muon);
+
+  // Removing the first electron moves the second into its place in the bucket; the second's handle still finds it
+  CHECK(catalogue.remove_particle(first_handle));
+  CHECK(!catalogue.contains(first_handle));
+  CHECK(catalogue.get(first_handle) == nullptr);
+  CHECK(catalogue.shared(first_handle) == nullptr);
+  CHECK(!catalogue.remove_particle(first_handle)); // Stale: a second removal is refused
+  CHECK(catalogue.get(second_handle) == second.get());
+  CHECK(catalogue.count_of_type("Electron") == 1);
+  CHECK(catalogue.size() == 2);
+
+  // The freed slot is reused with a new generation, so the old handle stays stale
+  auto third = std::make_shared<Electron>(0, 0, 1);
+  ParticleHandle third_handle = catalogue.add_particle(third);
+  CHECK(third_handle.index == first_handle.index);
+  CHECK(third_handle.generation != first_handle.generation);
+  CHECK(third_handle != first_handle);
+  CHECK(!catalogue.contains(first_handle));
+  CHECK(catalogue.get(third_handle) == third.get());
+
+  // Handles that never came from this catalogue are refused rather than read out of bounds
+  CHECK(!catalogue.contains(ParticleHandle{}));
+  CHECK(!catalogue.contains(ParticleHandle{1000, 0}));
+  CHECK(!catalogue.remove_particle(ParticleHandle{1000, 0}));
+
+  // Removal by value, for callers without a handle; an unknown type name is ignored
+  catalogue.remove_particle("Muon", muon);
+  CHECK(!catalogue.contains(muon_handle));
+  catalogue.remove_particle("no such type", second);
+  CHECK(catalogue.contains(second_handle));
+
+  // Copies share the particles and keep the same handles
+  ParticleCatalogue<Particle> copy(catalogue);
+  CHECK(copy.get(second_handle) == second.get());
+  CHECK(copy.get(third_handle) == third.get());
+
+  // clear() makes every handle stale
+  catalogue.clear();
+  CHECK(catalogue.size() == 0);
+  CHECK(!catalogue.contains(second_handle));
+  CHECK(!catalogue.contains(third_handle));
+  CHECK(copy.contains(second_handle)); // The copy is unaffected
+
+  // Random adds and removes: every live handle finds its particle and the running total matches a walk
+  std::mt19937 generator(13);
+  std::vector<std::shared_ptr<Particle>> particles;
+  std::vector<ParticleHandle> handles;
+  for(int i = 0; i < 500; ++i)
+  {
+    particles.push_back(make_particle(static_cast<Species>(i % species_count), i, 1, 2));
+    handles.push_back(catalogue.add_particle(particles.back()));
+  }
+  for(int round = 0; round < 2000; ++round)
+  {
+    std::size_t i = generator() % handles.size();
+    if(catalogue.contains(handles[i]))
+    {
+      CHECK(catalogue.get(handles[i]) == particles[i].get());
+      CHECK(catalogue.remove_particle(handles[i]));
+      CHECK(!catalogue.contains(handles[i]));
+    }
+    else
+    {
+      handles[i] = catalogue.add_particle(particles[i]);
+    }
+  }
+  std::size_t live = 0;
+  for(std::size_t i = 0; i < handles.size(); ++i)
+  {
+    if(catalogue.contains(handles[i]))
+    {
+      live++;
+      CHECK(catalogue.get(handles[i]) == particles[i].get());
+    }
+  }
+  CHECK(live == catalogue.size());
+  FourMomentum total = walked_total(catalogue);
+  CHECK_NEAR(catalogue.base_momentum().get_e(), total.get_e(), 1e-6 * total.get_e());
+  CHECK_NEAR(catalogue.base_momentum().get_px(), total.get_px(), 1e-6 * total.get_e());
+
+  return test_result("catalogue handles");
+}
@@ -0,0 +1,110 @@
+// Secondary indexes on ParticleCatalogue: indexed selections agree with a scan as particles are added, removed
+// and given new momenta, and the charge bitmaps cope with unbounded or invalid ranges
+
+#include "../particle_catalogue.h"
+#include "../particle_factory.h"
+#include "check.h"
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+  std::multiset<const Particle*> selected(const ParticleCatalogue<Particle>& catalogue, const std::vector<ParticleHandle>& handles)
+  {
+    std::multiset<const Particle*> particles;
+    for(ParticleHandle handle : handles)
+    {
+      CHECK(catalogue.contains(handle));
+      particles.insert(catalogue.get(handle));
+    }
+    return particles;
+  }
+}
+
+int main()
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  ParticleCatalogue<Particle> indexed, scanned; // The same particles, with and without indexes
+  indexed.enable_index(ParticleIndex::Energy); // Before adding, so it is kept up to date on insert
+  std::mt19937 generator(14);
+  std::uniform_real_distribution<double> component(-500, 500);
+  std::vector<std::shared_ptr<Particle>> particles;
+  std::vector<ParticleHandle> indexed_handles, scanned_handles;
+  for(int i = 0; i < 1000; ++i)
+  {
+    particles.push_back(make_particle(static_cast<Species>(i % species_count), component(generator), component(generator), component(generator)));
+    indexed_handles.push_back(indexed.add_particle(particles.back()));
+    scanned_handles.push_back(scanned.add_particle(particles.back()));
+  }
+  indexed.enable_index(ParticleIndex::TransverseMomentum); // After adding, so it is built from the catalogue
+  indexed.enable_index(ParticleIndex::InvariantMass);
+  indexed.enable_index(ParticleIndex::Charge);
+  CHECK(indexed.has_index(ParticleIndex::Charge));
+  CHECK(!scanned.has_index(ParticleIndex::Energy));
+
+  for(int round = 0; round < 1000; ++round)
+  {
+    std::size_t i = generator() % particles.size();
+    switch(round % 3)
+    {
+    case 0: // New momenta re-key the sorted indexes through the observer
+      particles[i]->set_momentum(std::abs(component(generator)) + 600, component(generator), component(generator), component(generator));
+      break;
+    case 1:
+      if(indexed.contains(indexed_handles[i]))
+      {
+        indexed.remove_particle(indexed_handles[i]);
+        scanned.remove_particle(scanned_handles[i]);
+      }
+      else
+      {
+        indexed_handles[i] = indexed.add_particle(particles[i]);
+        scanned_handles[i] = scanned.add_particle(particles[i]);
+      }
+      break;
+    default:
+      for(int k = 0; k < 3; ++k)
+      {
+        ParticleIndex index = static_cast<ParticleIndex>(k);
+        double low = std::abs(component(generator));
+        CHECK(selected(indexed, indexed.select(index, low, low + 300)) == selected(scanned, scanned.select(index, low, low + 300)));
+        CHECK(selected(indexed, indexed.select(index, low, low + 300, -1)) == selected(scanned, scanned.select(index, low, low + 300, -1)));
+      }
+      CHECK(selected(indexed, indexed.select(ParticleIndex::Charge, -0.4, 0.7)) == selected(scanned, scanned.select(ParticleIndex::Charge, -0.4, 0.7)));
+    }
+  }
+
+  // Sorted indexes return particles in increasing order of the key
+  std::vector<ParticleHandle> by_energy = indexed.select(ParticleIndex::Energy, 0, inf);
+  CHECK(by_energy.size() == indexed.size());
+  for(std::size_t i = 1; i < by_energy.size(); ++i)
+  {
+    CHECK(indexed.get(by_energy[i - 1])->get_e() <= indexed.get(by_energy[i])->get_e());
+  }
+
+  // Unbounded, reversed and NaN charge ranges: the bitmaps answer at once and agree with the scan
+  CHECK(indexed.select(ParticleIndex::Charge, -inf, inf).size() == indexed.size());
+  CHECK(selected(indexed, indexed.select(ParticleIndex::Charge, -inf, inf)) == selected(scanned, scanned.select(ParticleIndex::Charge, -inf, inf)));
+  CHECK(selected(indexed, indexed.select(ParticleIndex::Charge, -1e300, 0)) == selected(scanned, scanned.select(ParticleIndex::Charge, -1e300, 0)));
+  CHECK(indexed.select(ParticleIndex::Charge, 1, -1).empty());
+  CHECK(indexed.select(ParticleIndex::Charge, nan, 1).empty());
+  CHECK(indexed.select(ParticleIndex::Charge, -1, nan).empty());
+  CHECK(scanned.select(ParticleIndex::Charge, nan, 1).empty());
+  CHECK(indexed.select(ParticleIndex::Charge, 5, inf).empty());
+  CHECK_THROWS(indexed.select(ParticleIndex::Charge, -1, 1, 0), std::invalid_argument);
+
+  // Copies carry their indexes; clear() empties them
+  ParticleCatalogue<Particle> copy(indexed);
+  CHECK(copy.select(ParticleIndex::Energy, 0, inf).size() == indexed.size());
+  indexed.clear();
+  CHECK(indexed.select(ParticleIndex::Energy, 0, inf).empty());
+  CHECK(indexed.select(ParticleIndex::Charge, -inf, inf).empty());
+
+  return test_result("catalogue indexes");
+}
@@ -0,0 +1,161 @@
+// ConcurrentParticleCatalogue: threads inserting at once lose nothing, and a reader running alongside them only ever
+// sees complete particles, in each thread's insertion order
+
+#include "../bosons.h"
+#include "../concurrent_particle_catalogue.h"
+#include "../particle_factory.h"
+#include "check.h"
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  constexpr int writers = 4;
+  constexpr int per_writer = 5000;
+  constexpr Species species_written[] = {Species::Electron, Species::Photon, Species::Muon};
+
+  // Writer w's n-th particle has px = w and py = n, so order and completeness can be read back from the momentum
+  void write(ConcurrentParticleCatalogue<Particle>& catalogue, int writer)
+  {
+    for(int n = 0; n < per_writer; ++n)
+    {
+      catalogue.add_particle(make_particle(species_written[n % 3], writer, n, 1));
+    }
+  }
+
+  // True if each writer's particles of 'species' appear with increasing n
+  bool in_writer_order(const ConcurrentParticleCatalogue<Particle>& catalogue, Species species)
+  {
+    std::map<int, int> last_seen;
+    bool ordered = true;
+    catalogue.for_each_of_type(species, [&](const Particle& particle)
+    {
+      int writer = static_cast<int>(particle.get_px()), n = static_cast<int>(particle.get_py());
+      auto previous = last_seen.find(writer);
+      ordered = ordered && particle.get_species() == species && (previous == last_seen.end() || previous->second < n);
+      last_seen[writer] = n;
+    });
+    return ordered;
+  }
+}
+
+int main()
+{
+  ConcurrentParticleCatalogue<Particle> catalogue;
+  CHECK(catalogue.size() == 0);
+
+  // A reader scans while the writers run: sizes never shrink and every particle it reaches is complete
+  std::atomic<bool> writing{true};
+  bool reader_ok = true;
+  std::size_t reader_scans = 0;
+  std::thread reader([&]
+  {
+    std::size_t last_size = 0;
+    while(writing.load())
+    {
+      std::size_t size = catalogue.size();
+      reader_ok = reader_ok && size >= last_size;
+      last_size = size;
+      std::size_t visited = 0;
+      catalogue.for_each([&](const Particle& particle)
+      {
+        visited++;
+        reader_ok = reader_ok && particle.get_pz() == 1;
+      });
+      reader_ok = reader_ok && visited >= size; // Writers may add more between size() and the scan, never fewer
+      reader_ok = reader_ok && in_writer_order(catalogue, Species::Photon);
+      reader_scans++;
+    }
+  });
+
+  std::vector<std::thread> threads;
+  for(int w = 0; w < writers; ++w)
+  {
+    threads.emplace_back(write, std::ref(catalogue), w);
+  }
+  for(std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  writing.store(false);
+  reader.join();
+  CHECK(reader_ok);
+  CHECK(reader_scans > 0);
+
+  // Everything arrived, sorted by species and in each writer's order
+  CHECK(catalogue.size() == std::size_t(writers) * per_writer);
+  std::size_t by_type = 0;
+  for(Species species : species_written)
+  {
+    by_type += catalogue.count_of_type(species);
+    CHECK(in_writer_order(catalogue, species));
+  }
+  CHECK(by_type == catalogue.size());
+  CHECK(catalogue.count_of_type(Species::Photon) == std::size_t(writers) * ((per_writer + 1) / 3));
+  CHECK(catalogue.count_of_type("Photon") == catalogue.count_of_type(Species::Photon));
+  CHECK(catalogue.count_of_type("Tau") == 0);
+  CHECK(catalogue.count_of_type("no such particle") == 0);
+
+  // A snapshot shares the particles and has the running totals the concurrent catalogue leaves out
+  ParticleCatalogue<Particle> snapshot = catalogue.snapshot();
+  CHECK(snapshot.size() == catalogue.size());
+  CHECK(snapshot.count_of_type("Muon") == catalogue.count_of_type(Species::Muon));
+  CHECK_NEAR(snapshot.base_momentum().get_pz(), double(catalogue.size()), 1e-6);
+
+  // Const readers on several threads can count and print decayed particles at once; nothing is cached behind const
+  ConcurrentParticleCatalogue<Particle> decayed;
+  RandomEngine rng(16);
+  std::ostringstream quiet; // Decays report calorimeter adjustments on std::cerr
+  std::streambuf* cerr_buffer = std::cerr.rdbuf(quiet.rdbuf());
+  for(int i = 0; i < 20; ++i)
+  {
+    auto z_boson = std::make_shared<ZBoson>(190, 423 + i, 780);
+    z_boson->decay_with(rng);
+    decayed.add_particle(z_boson);
+  }
+  std::cerr.rdbuf(cerr_buffer);
+  std::vector<std::string> printed(4);
+  std::vector<int> products(4, 0);
+  std::vector<std::thread> printers;
+  for(int t = 0; t < 4; ++t)
+  {
+    printers.emplace_back([&, t]
+    {
+      std::ostringstream out_stream;
+      decayed.for_each([&](const Particle& particle)
+      {
+        TextFormatter out(out_stream);
+        particle.print(out);
+        products[t] += particle.total_decay_products();
+      });
+      printed[t] = out_stream.str();
+    });
+  }
+  for(std::thread& printer : printers)
+  {
+    printer.join();
+  }
+  std::ostringstream expected;
+  int expected_products = 0;
+  decayed.for_each([&](const Particle& particle)
+  {
+    TextFormatter out(expected);
+    particle.print(out);
+    expected_products += particle.total_decay_products();
+  });
+  bool readers_agree = true;
+  for(int t = 0; t < 4; ++t)
+  {
+    readers_agree = readers_agree && printed[t] == expected.str() && products[t] == expected_products;
+  }
+  CHECK(readers_agree);
+  CHECK(expected_products > 0);
+
+  return test_result("concurrent catalogue");
+}
@@ -0,0 +1,206 @@
+// Copies of a particle share its decay tree; mutable_decay_product copies a product only while another tree lists it
+
+#include "../bosons.h"
+#include "../lepton.h"
+#include "../particle_catalogue.h"
+#include "../particle_factory.h"
+#include "check.h"
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+  std::string printed(const Particle& particle)
+  {
+    std::ostringstream out;
+    {
+      TextFormatter formatter(out);
+      particle.print(formatter);
+    }
+    return out.str();
+  }
+
+  // Checks every node's decay momentum total, and the flattened tree's, against its products
+  void check_totals(const Particle& particle)
+  {
+    FourMomentum sum;
+    for(const Particle& product : particle.get_decay_products())
+    {
+      check_totals(product);
+      sum += product.get_four_momentum();
+      sum += product.get_decay_momentum_total();
+    }
+    CHECK_NEAR(particle.get_decay_momentum_total().get_e(), sum.get_e(), 1e-6);
+    CHECK_NEAR(particle.get_decay_momentum_total().get_px(), sum.get_px(), 1e-6);
+    CHECK_NEAR(particle.sum_decay_products_fourmomentum().get_e(), sum.get_e(), 1e-6);
+    CHECK_NEAR(particle.decay_tree().sum_decay_products().get_e(), sum.get_e(), 1e-6);
+    CHECK(particle.decay_tree().total_decay_products() == particle.total_decay_products());
+  }
+
+  class CountingObserver : public ParticleObserver
+  {
+  public:
+    int decay_changes = 0;
+    void momentum_changed(const Particle&, const FourMomentum&) override {}
+    void decay_momentum_changed(const Particle&, const FourMomentum&) override { decay_changes++; }
+  };
+}
+
+int main()
+{
+  // Products are only handed out read-only
+  static_assert(std::is_same_v<decltype(std::declval<DecayProductsView>()[0]), const Particle&>);
+  static_assert(std::is_same_v<decltype(*std::declval<DecayProductsView>().begin()), const Particle&>);
+  static_assert(std::is_same_v<decltype(std::declval<DecayProductsView>().shared(0)), std::shared_ptr<const Particle>>);
+
+  std::ostringstream quiet; // Decays report failed conservation checks on std::cerr, as do the checks here
+  std::streambuf* cerr_buffer = std::cerr.rdbuf(quiet.rdbuf());
+  auto z_boson = std::make_shared<ZBoson>(190, 423, 780);
+  z_boson->decay();
+  auto w_boson = std::make_shared<WBoson>(1, 10, 76, 82);
+  w_boson->decay();
+  std::cerr.rdbuf(cerr_buffer);
+  z_boson->add_decay_product(w_boson); // A deeper tree: the W's own products are grandchildren of the Z
+  const std::size_t w_index = z_boson->get_decay_products().size() - 1;
+  CHECK(w_boson->get_parent_particle() == z_boson.get());
+  CHECK(!z_boson->decay_product_shared(w_index));
+  const std::string original = printed(*z_boson);
+
+  // A clone shares every product, and a shared product has no single parent
+  auto copy = std::static_pointer_cast<ZBoson>(z_boson->clone());
+  CHECK(printed(*copy) == original);
+  CHECK(&copy->get_decay_products()[0] == &z_boson->get_decay_products()[0]);
+  CHECK(copy->decay_product_shared(0));
+  CHECK(z_boson->decay_product_shared(0));
+  CHECK(w_boson->get_parent_particle() == nullptr);
+
+  // Modifying a grandchild through the copy copies the path down to it and nothing else
+  Particle& copied_w = copy->mutable_decay_product(w_index);
+  CHECK(&copied_w != w_boson.get());
+  CHECK(copied_w.get_parent_particle() == copy.get());
+  CHECK(!copy->decay_product_shared(w_index));
+  CHECK(!z_boson->decay_product_shared(w_index)); // The original W is the original Z's alone again
+  CHECK(copied_w.decay_product_shared(0)); // Grandchildren are still shared
+  Particle& grandchild = copied_w.mutable_decay_product(0);
+  CHECK(&grandchild != &w_boson->get_decay_products()[0]);
+  CHECK(grandchild.get_parent_particle() == &copied_w);
+  grandchild.set_momentum(grandchild.get_e() + 5, grandchild.get_px() + 1, grandchild.get_py(), grandchild.get_pz());
+  CHECK(printed(*z_boson) == original);
+  CHECK(printed(*copy) != original);
+  CHECK(&copy->get_decay_products()[0] == &z_boson->get_decay_products()[0]); // Untouched siblings stay shared
+  check_totals(*z_boson);
+  check_totals(*copy);
+
+  // Changes made through mutable_decay_product reach the copy's observers, and only the copy's
+  ParticleCatalogue<Particle> catalogue;
+  catalogue.add_particle(copy);
+  CountingObserver original_observer;
+  z_boson->add_observer(&original_observer);
+  Particle& first = copy->mutable_decay_product(0);
+  first.set_momentum(first.get_e() + 3, first.get_px(), first.get_py() + 2, first.get_pz());
+  FourMomentum running = catalogue.decay_momentum();
+  catalogue.recompute_aggregates();
+  CHECK_NEAR(running.get_e(), catalogue.decay_momentum().get_e(), 1e-6);
+  CHECK_NEAR(running.get_py(), catalogue.decay_momentum().get_py(), 1e-6);
+  CHECK(original_observer.decay_changes == 0);
+  CHECK(printed(*z_boson) == original);
+  z_boson->remove_observer(&original_observer);
+
+  // Once the original is gone its products are the copy's alone and are modified in place
+  DecayProductsView products = copy->get_decay_products();
+  std::shared_ptr<const Particle> kept = products.shared(1); // Keeps a product alive without owning it as a product
+  z_boson.reset();
+  w_boson.reset();
+  CHECK(!copy->decay_product_shared(1));
+  const Particle* before = &copy->get_decay_products()[1];
+  CHECK(&copy->mutable_decay_product(1) == before);
+  CHECK(kept.get() == before);
+  check_totals(*copy);
+
+  // Products from one block share a control block, but are not shared between trees, so they are not copied
+  std::vector<std::shared_ptr<Particle>> block = make_particle_block(Species::Photon, 3);
+  auto muon = std::make_shared<Muon>(1, 2, 3);
+  for(const auto& photon : block)
+  {
+    muon->add_decay_product(photon);
+  }
+  CHECK(block[0].use_count() > 1);
+  CHECK(!muon->decay_product_shared(0));
+  CHECK(&muon->mutable_decay_product(0) == block[0].get());
+  CHECK(block[0]->get_parent_particle() == muon.get());
+
+  // Copy and move assignment keep the ownership counts straight
+  Muon other(5, 5, 5);
+  other = *muon;
+  CHECK(other.total_decay_products() == 3);
+  CHECK(muon->decay_product_shared(2));
+  other = Muon(0, 0, 1);
+  CHECK(other.total_decay_products() == 0);
+  CHECK(!muon->decay_product_shared(2));
+  Muon moved(std::move(*std::static_pointer_cast<Muon>(muon->clone())));
+  CHECK(moved.total_decay_products() == 3);
+  CHECK(muon->decay_product_shared(0)); // The moved-into particle owns the clone's share
+  muon->clear_decay_products();
+  CHECK(!moved.decay_product_shared(0));
+  CHECK(&moved.mutable_decay_product(0) == &moved.get_decay_products()[0]);
+  CHECK(moved.get_decay_products()[0].get_parent_particle() == &moved); // Linked again once it is asked for
+
+  // Moving the products out of a catalogued particle takes them out of the catalogue's running totals
+  ParticleCatalogue<Particle> moved_from;
+  auto catalogued = std::make_shared<ZBoson>(190, 423, 780);
+  auto assigned_from = std::make_shared<ZBoson>(1, 2, 300);
+  cerr_buffer = std::cerr.rdbuf(quiet.rdbuf());
+  catalogued->decay();
+  assigned_from->decay();
+  std::cerr.rdbuf(cerr_buffer);
+  moved_from.add_particle(catalogued);
+  moved_from.add_particle(assigned_from);
+  CHECK(moved_from.decay_momentum().get_e() > 0);
+  ZBoson stolen(std::move(*catalogued));
+  CHECK(stolen.total_decay_products() > 0 && catalogued->total_decay_products() == 0);
+  ZBoson overwritten(0, 0, 1);
+  overwritten = std::move(*assigned_from);
+  CHECK(overwritten.total_decay_products() > 0 && assigned_from->total_decay_products() == 0);
+  FourMomentum running_after_move = moved_from.decay_momentum();
+  moved_from.recompute_aggregates();
+  CHECK_NEAR(running_after_move.get_e(), moved_from.decay_momentum().get_e(), 1e-6);
+  CHECK_NEAR(running_after_move.get_pz(), moved_from.decay_momentum().get_pz(), 1e-6);
+  CHECK_NEAR(moved_from.decay_momentum().get_e(), 0, 1e-6);
+  check_totals(stolen);
+
+  // Copies sharing a subtree can be made and dropped on several threads at once
+  std::vector<std::thread> copiers;
+  std::atomic<bool> copies_shared{true};
+  for(int t = 0; t < 4; ++t)
+  {
+    copiers.emplace_back([&stolen, &copies_shared]
+    {
+      for(int i = 0; i < 500; ++i)
+      {
+        std::shared_ptr<Particle> copy = stolen.clone();
+        std::shared_ptr<Particle> copy_of_copy = copy->clone();
+        if(!copy_of_copy->decay_product_shared(0))
+        {
+          copies_shared = false;
+        }
+      }
+    });
+  }
+  for(std::thread& copier : copiers)
+  {
+    copier.join();
+  }
+  CHECK(copies_shared);
+  CHECK(!stolen.decay_product_shared(0));
+  CHECK(stolen.get_decay_products()[0].get_parent_particle() == nullptr); // Shared once, so unlinked until asked for
+  CHECK(&stolen.mutable_decay_product(0) == &stolen.get_decay_products()[0]);
+  CHECK(stolen.get_decay_products()[0].get_parent_particle() == &stolen);
+
+  return test_result("copy on write");
+}
@@ -0,0 +1,142 @@
+// Decay table parsing and alias-method channel sampling (decay_table.h)
+
+#include "../decay_table.h"
+#include "../random_engine.h"
+#include "../species.h"
+#include "check.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+  DecayTable table_from(const std::string& text)
+  {
+    std::istringstream input(text);
+    return DecayTable(input);
+  }
+
+  // Checks that sampling 'species' picks each channel in proportion to its branching ratio
+  void check_frequencies(const DecayTable& table, Species species, RandomEngine& rng)
+  {
+    const auto& channels = table.channels(species);
+    double total_ratio = 0;
+    for(const DecayChannel& channel : channels)
+    {
+      total_ratio += channel.branching_ratio;
+    }
+    const int samples = 400000;
+    std::vector<int> counts(channels.size(), 0);
+    for(int i = 0; i < samples; ++i)
+    {
+      counts[table.sample_index(species, rng.uniform())]++;
+    }
+    for(std::size_t c = 0; c < channels.size(); ++c)
+    {
+      double expected = channels[c].branching_ratio / total_ratio;
+      double sigma = std::sqrt(expected * (1 - expected) / samples);
+      CHECK_NEAR(static_cast<double>(counts[c]) / samples, expected, 5 * sigma + 1e-12);
+    }
+  }
+}
+
+int main()
+{
+  RandomEngine rng(11, 3);
+
+  // Uneven ratios, including ones that need several alias columns
+  DecayTable uneven = table_from(
+    "# comment line\n"
+    "\n"
+    "ZBoson \"A\" 0.5 Electron AntiElectron\n"
+    "ZBoson \"B\" 0.3 Muon AntiMuon   # trailing comment\n"
+    "ZBoson \"C\" 0.15 Tau AntiTau\n"
+    "ZBoson \"D\" 0.04 UpQuark:Green AntiUpQuark:AntiGreen\n"
+    "ZBoson \"E\" 0.01 Photon Photon\n");
+  CHECK(uneven.channels(Species::ZBoson).size() == 5);
+  check_frequencies(uneven, Species::ZBoson, rng);
+
+  // Ratios need not add up to 1
+  DecayTable unnormalised = table_from("HiggsBoson \"X\" 3 Photon Photon\nHiggsBoson \"Y\" 1 ZBoson ZBoson\n");
+  check_frequencies(unnormalised, Species::HiggsBoson, rng);
+
+  // The built-in table, every species
+  const DecayTable& builtin = decay_table();
+  for(Species species : {Species::WPlus, Species::WMinus, Species::ZBoson, Species::HiggsBoson, Species::Tau, Species::AntiTau})
+  {
+    CHECK(builtin.has_channels(species));
+    check_frequencies(builtin, species, rng);
+  }
+  CHECK(!builtin.has_channels(Species::Electron));
+  CHECK(builtin.sample(Species::Photon, 0.5) == nullptr);
+
+  // Edge uniforms stay in range
+  CHECK(uneven.sample_index(Species::ZBoson, 0.0) < 5);
+  CHECK(uneven.sample_index(Species::ZBoson, 0.9999999999999999) < 5);
+
+  // Antiparticles without channels of their own decay into charge conjugates, colours swapped
+  DecayTable tau_only = table_from("Tau \"Hadronic\" 1 AntiUpQuark:AntiRed DownQuark:Red TauNeutrino\n");
+  const auto& anti_channels = tau_only.channels(Species::AntiTau);
+  CHECK(anti_channels.size() == 1);
+  CHECK(anti_channels[0].products[0].species == Species::UpQuark);
+  CHECK(anti_channels[0].products[0].colour == ColourCharge::Red);
+  CHECK(anti_channels[0].products[1].species == Species::AntiDownQuark);
+  CHECK(anti_channels[0].products[2].species == Species::AntiTauNeutrino);
+
+  // Products heavier than the parent borrow energy equally, so the channel is open at the parent's rest mass
+  const DecayChannel* zz = nullptr;
+  for(const DecayChannel& channel : builtin.channels(Species::HiggsBoson))
+  {
+    if(channel.products[0].species == Species::ZBoson)
+    {
+      zz = &channel;
+    }
+  }
+  CHECK(zz != nullptr);
+  if(zz)
+  {
+    CHECK_NEAR(zz->borrowed_energy, (2 * 91187.6 - 125110) / 2, 1e-6);
+    CHECK(zz->is_open(125110));
+  }
+
+  // Malformed lines are rejected with the line number
+  CHECK_THROWS(table_from("Nonsense \"A\" 1 Electron\n"), std::invalid_argument);
+  CHECK_THROWS(table_from("ZBoson \"A\" 0 Electron AntiElectron\n"), std::invalid_argument);
+  CHECK_THROWS(table_from("ZBoson \"A\" -1 Electron AntiElectron\n"), std::invalid_argument);
+  CHECK_THROWS(table_from("ZBoson \"A\" nan Electron AntiElectron\n"), std::invalid_argument);
+  CHECK_THROWS(table_from("ZBoson \"A\" 1\n"), std::invalid_argument);
+  CHECK_THROWS(table_from("ZBoson \"A\" 1 Electron Bogus\n"), std::invalid_argument);
+  CHECK_THROWS(table_from("ZBoson \"A\" 1 UpQuark:Purple AntiUpQuark\n"), std::invalid_argument);
+  try
+  {
+    table_from("ZBoson \"A\" 1 Electron AntiElectron\n\nZBoson \"B\" 1 Bogus\n");
+  }
+  catch(const std::invalid_argument& error)
+  {
+    CHECK(std::string(error.what()).find("line 3") != std::string::npos);
+  }
+
+  // Loading a file with a malformed line reports it and keeps the current table
+  const char* const bad_path = "test_decay_table_bad.txt";
+  {
+    std::ofstream bad(bad_path);
+    bad<<"ZBoson \"A\" 1 Electron AntiElectron\nW+ 0.5 banana\n";
+  }
+  std::size_t z_channels = decay_table().channels(Species::ZBoson).size();
+  std::ostringstream reported;
+  std::streambuf* cerr_buffer = std::cerr.rdbuf(reported.rdbuf());
+  bool loaded = load_decay_table(bad_path);
+  std::cerr.rdbuf(cerr_buffer);
+  std::remove(bad_path);
+  CHECK(!loaded);
+  CHECK(reported.str().find("line 2") != std::string::npos);
+  CHECK(decay_table().channels(Species::ZBoson).size() == z_channels);
+  CHECK(decay_table().has_channels(Species::WPlus));
+  CHECK(!load_decay_table("no_such_decay_table.txt"));
+
+  return test_result("decay table");
+}
@@ -0,0 +1,61 @@
+// EventArena: particles made while it exists come from it, clones included, and it counts those still alive so
+// release() can refuse to free memory they use
+
+#include "../bosons.h"
+#include "../particle_factory.h"
+#include "check.h"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+int main()
+{
+  CHECK(particle_memory_resource() == std::pmr::new_delete_resource());
+  {
+    EventArena arena(4096);
+    CHECK(particle_memory_resource() == arena.memory_resource());
+    CHECK(arena.live_allocations() == 0);
+
+    for(int event = 0; event < 3; ++event)
+    {
+      {
+        std::shared_ptr<Particle> electron = make_particle(Species::Electron, 1, 2, 3);
+        std::vector<std::shared_ptr<Particle>> photons = make_particle_block(Species::Photon, 10);
+        CHECK(arena.live_allocations() == 3); // The electron, and the block with its vector's buffer
+
+        auto z_boson = std::allocate_shared<ZBoson>(std::pmr::polymorphic_allocator<ZBoson>(particle_memory_resource()), 190, 423, 780);
+        std::size_t before = arena.live_allocations();
+        std::ostringstream quiet; // Decays report failed conservation checks on std::cerr
+        std::streambuf* cerr_buffer = std::cerr.rdbuf(quiet.rdbuf());
+        z_boson->decay(); // Decay products come from the arena too
+        std::cerr.rdbuf(cerr_buffer);
+        CHECK(arena.live_allocations() == before + z_boson->decay_tree().size() - 1);
+
+        photons.resize(5);
+        CHECK(arena.live_allocations() > 3); // Half a block keeps all of it
+      }
+      CHECK(arena.live_allocations() == 0);
+      arena.release(); // Nothing is alive, so the next event can reuse the memory
+    }
+
+    // Particles made on the heap are not counted
+    auto heap_particle = std::make_shared<ZBoson>(1, 2, 3);
+    CHECK(arena.live_allocations() == 0);
+
+    // Clones, including the copies copy-on-write makes, come from the arena too
+    std::shared_ptr<Particle> copy = heap_particle->clone();
+    CHECK(arena.live_allocations() == 1);
+
+    // Releasing while a particle is alive is refused, in release builds too, and leaves the particle intact
+    CHECK_THROWS(arena.release(), std::logic_error);
+    CHECK(copy->get_species() == Species::ZBoson && copy->get_pz() == 3);
+    copy.reset();
+    CHECK(arena.live_allocations() == 0);
+    arena.release();
+  }
+  CHECK(particle_memory_resource() == std::pmr::new_delete_resource()); // The scope ends with the arena
+
+  return test_result("event arena");
+}
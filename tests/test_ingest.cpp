@@ -0,0 +1,149 @@
+// Bulk ingest of untrusted CSV and binary input: malformed rows are counted and skipped, never turned into particles,
+// and results do not depend on how the input is split into chunks
+
+#include "../ingest.h"
+#include "../particle_catalogue.h"
+#include "check.h"
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+  IngestStats read_csv(const std::string& text, ThreadPool& pool, std::vector<std::shared_ptr<Particle>>& particles, std::size_t chunk_bytes = 4 << 20)
+  {
+    std::istringstream in(text);
+    particles.clear();
+    return stream_csv(in, pool, [&particles](std::vector<std::shared_ptr<Particle>>& batch)
+    {
+      particles.insert(particles.end(), batch.begin(), batch.end());
+    }, chunk_bytes);
+  }
+
+  std::string binary_header(std::uint32_t version = BinaryParticleRow::version, std::uint32_t row_size = sizeof(BinaryParticleRow))
+  {
+    std::string bytes(BinaryParticleRow::magic, sizeof(BinaryParticleRow::magic));
+    bytes.append(reinterpret_cast<const char*>(&version), sizeof(version));
+    bytes.append(reinterpret_cast<const char*>(&row_size), sizeof(row_size));
+    return bytes;
+  }
+
+  std::string binary_row(std::uint8_t species, double px, double py, double pz, std::uint8_t colour = static_cast<std::uint8_t>(ColourCharge::Neutral))
+  {
+    BinaryParticleRow row{};
+    row.px = px;
+    row.py = py;
+    row.pz = pz;
+    row.species = species;
+    row.colour = colour;
+    return std::string(reinterpret_cast<const char*>(&row), sizeof(row));
+  }
+
+  IngestStats read_binary(const std::string& bytes, ThreadPool& pool, ParticleCatalogue<Particle>& catalogue, std::size_t chunk_bytes = 4 << 20)
+  {
+    std::istringstream in(bytes);
+    return ingest_binary(in, pool, catalogue, chunk_bytes);
+  }
+}
+
+int main()
+{
+  ThreadPool pool(2);
+  std::vector<std::shared_ptr<Particle>> particles;
+
+  // Well-formed input: header, comments, blank lines, PDG codes, colours, CRLF line ends and no final newline
+  const std::string good = "species,px,py,pz,colour\n"
+                           "# a comment\n"
+                           "Electron,1,2,3\n"
+                           "\n"
+                           "  AntiMuon , -4.5 , 0 , 1e3 \r\n"
+                           "-11,0,0,5\n"
+                           "UpQuark,1,1,1,Red\n"
+                           "W+,10,20,30,Neutral\n"
+                           "Photon,0,0,7";
+  IngestStats stats = read_csv(good, pool, particles);
+  CHECK(stats.rows == 6);
+  CHECK(stats.accepted == 6);
+  CHECK(stats.rejected == 0);
+  CHECK(stats.first_error.empty());
+  CHECK(particles.size() == 6);
+  if(particles.size() == 6)
+  {
+    CHECK(particles[0]->get_species() == Species::Electron);
+    CHECK(particles[1]->get_species() == Species::AntiMuon);
+    CHECK(particles[1]->get_pz() == 1000);
+    CHECK(particles[2]->get_species() == Species::AntiElectron);
+    CHECK(particles[5]->get_species() == Species::Photon);
+  }
+
+  // Every malformed row is rejected on its own and the rest still load
+  const std::string bad = "Electron,1,2,3\n"
+                          "Electron,1,2\n" // Line 2: too few fields
+                          "Electron,1,2,3,Red,extra\n" // Too many
+                          "Proton,1,2,3\n" // Unknown species
+                          "99999,1,2,3\n" // Unknown PDG code
+                          "Electron,one,2,3\n" // Not a number
+                          "Electron,1,2,3x\n" // Trailing junk
+                          "Electron,nan,2,3\n"
+                          "Electron,inf,2,3\n"
+                          "Electron,1e400,2,3\n" // Overflows a double
+                          "Electron,2e10,2,3\n" // Beyond FourMomentum::max_momentum
+                          "UpQuark,1,2,3,Purple\n"
+                          ",,,\n"
+                          "Muon,4,5,6\n";
+  stats = read_csv(bad, pool, particles);
+  CHECK(stats.rows == 14);
+  CHECK(stats.accepted == 2);
+  CHECK(stats.rejected == 12);
+  CHECK(particles.size() == 2);
+  CHECK(stats.first_error.rfind("Line 2:", 0) == 0);
+
+  // Chunks of a few bytes split lines everywhere, and some lines are longer than a chunk: same result
+  for(std::size_t chunk_bytes : {1, 5, 16})
+  {
+    IngestStats small = read_csv(bad, pool, particles, chunk_bytes);
+    CHECK(small.rows == stats.rows);
+    CHECK(small.accepted == stats.accepted);
+    CHECK(small.first_error == stats.first_error);
+    small = read_csv(good, pool, particles, chunk_bytes);
+    CHECK(small.accepted == 6);
+  }
+
+  // Empty input, and a file that is only a header
+  CHECK(read_csv("", pool, particles).rows == 0);
+  CHECK(read_csv("species,px,py,pz\n", pool, particles).rows == 0);
+
+  // Binary: bad species and colour IDs and non-finite momenta are rejected row by row
+  ParticleCatalogue<Particle> catalogue;
+  std::string bytes = binary_header() + binary_row(0, 1, 2, 3) + binary_row(200, 1, 2, 3) + binary_row(12, 1, 1, 1, 99) +
+                      binary_row(4, std::numeric_limits<double>::quiet_NaN(), 0, 0) + binary_row(4, 0, -std::numeric_limits<double>::infinity(), 0) +
+                      binary_row(12, 1, 1, 1, static_cast<std::uint8_t>(ColourCharge::Green)) + binary_row(4, 4, 5, 6);
+  stats = read_binary(bytes, pool, catalogue);
+  CHECK(stats.rows == 7);
+  CHECK(stats.accepted == 3);
+  CHECK(stats.rejected == 4);
+  CHECK(stats.first_error.rfind("Row 2:", 0) == 0);
+  CHECK(catalogue.size() == 3);
+  CHECK(catalogue.count_of_type("Muon") == 1);
+
+  // One row per chunk gives the same result
+  ParticleCatalogue<Particle> row_by_row;
+  IngestStats small = read_binary(bytes, pool, row_by_row, 1);
+  CHECK(small.accepted == stats.accepted);
+  CHECK(small.first_error == stats.first_error);
+
+  // Files that are not binary particle files, or are cut short, throw rather than load part of a row
+  CHECK(read_binary(binary_header(), pool, catalogue).rows == 0);
+  CHECK_THROWS(read_binary("", pool, catalogue), std::invalid_argument);
+  CHECK_THROWS(read_binary(binary_header().substr(0, 10), pool, catalogue), std::invalid_argument);
+  CHECK_THROWS(read_binary("PCATROWZ" + binary_header().substr(8), pool, catalogue), std::invalid_argument);
+  CHECK_THROWS(read_binary(binary_header(2), pool, catalogue), std::invalid_argument);
+  CHECK_THROWS(read_binary(binary_header(BinaryParticleRow::version, 16), pool, catalogue), std::invalid_argument);
+  std::string truncated = binary_header() + binary_row(0, 1, 2, 3) + binary_row(0, 1, 2, 3).substr(0, 20);
+  CHECK_THROWS(read_binary(truncated, pool, catalogue), std::invalid_argument);
+
+  return test_result("ingest");
+}
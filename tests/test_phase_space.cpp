@@ -0,0 +1,132 @@
+// Exact phase-space generation (phase_space.h) and the decays built on it
+
+#include "../bosons.h"
+#include "../decay_table.h"
+#include "../fourmom_block.h"
+#include "../lepton.h"
+#include "../phase_space.h"
+#include "../random_engine.h"
+#include "check.h"
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+  FourMomentum sum(const std::vector<FourMomentum>& momenta)
+  {
+    FourMomentum total;
+    for(const FourMomentum& momentum : momenta)
+    {
+      total = total + momentum;
+    }
+    return total;
+  }
+
+  void check_conserved(const FourMomentum& parent, const std::vector<FourMomentum>& daughters, const std::vector<double>& masses)
+  {
+    FourMomentum total = sum(daughters);
+    double tolerance = 1e-9 * parent.get_e();
+    CHECK_NEAR(total.get_e(), parent.get_e(), tolerance);
+    CHECK_NEAR(total.get_px(), parent.get_px(), tolerance);
+    CHECK_NEAR(total.get_py(), parent.get_py(), tolerance);
+    CHECK_NEAR(total.get_pz(), parent.get_pz(), tolerance);
+    for(std::size_t i = 0; i < daughters.size(); ++i)
+    {
+      CHECK_NEAR(daughters[i].invariant_mass(), masses[i], 1e-6 * parent.get_e());
+    }
+  }
+
+  FourMomentum moving_parent(double mass, double px, double py, double pz)
+  {
+    return FourMomentum(std::sqrt(mass * mass + px * px + py * py + pz * pz), px, py, pz);
+  }
+}
+
+int main()
+{
+  RandomEngine rng(2024, 7);
+
+  // Two-body decays, scalar and columnar, conserve four-momentum and put both daughters on shell
+  FourMomentum w = moving_parent(80377, 10, 76000, 82000);
+  for(int i = 0; i < 1000; ++i)
+  {
+    auto [first, second] = two_body_decay(w, 4180, 2.2, rng);
+    check_conserved(w, {first, second}, {4180, 2.2});
+  }
+  FourMomentumBlock parents;
+  for(int i = 0; i < 100; ++i)
+  {
+    parents.push_back(moving_parent(91187.6, 100 * i, -50 * i, 3000));
+  }
+  FourMomentumBlock first, second;
+  two_body_decay(parents, 105.66, 105.66, rng, first, second);
+  for(std::size_t i = 0; i < parents.size(); ++i)
+  {
+    check_conserved(parents[i], {first[i], second[i]}, {105.66, 105.66});
+  }
+
+  // N-body decays conserve four-momentum too
+  FourMomentum tau = moving_parent(1776.86, 24, 256, 34);
+  std::vector<double> tau_masses = {105.66, 0, 0};
+  for(int i = 0; i < 1000; ++i)
+  {
+    check_conserved(tau, n_body_decay(tau, tau_masses, rng), tau_masses);
+  }
+  std::vector<double> five = {100, 200, 0, 50, 300};
+  for(int i = 0; i < 200; ++i)
+  {
+    check_conserved(w, n_body_decay(w, five, rng), five);
+  }
+
+  // Three massless daughters: uniform phase space fills the Dalitz plot evenly, so m12/M has mean 8/15.
+  // Unweighted sorted-uniform masses would give 1/2.
+  FourMomentum at_rest(1000, 0, 0, 0);
+  std::vector<double> massless = {0, 0, 0};
+  double mean = 0;
+  const int samples = 200000;
+  for(int i = 0; i < samples; ++i)
+  {
+    std::vector<FourMomentum> daughters = n_body_decay(at_rest, massless, rng);
+    mean += (daughters[0] + daughters[1]).invariant_mass() / 1000 / samples;
+  }
+  CHECK_NEAR(mean, 8.0 / 15.0, 0.003);
+
+  // Products heavier than the parent cannot be given conserving momenta
+  WBoson light_w(1, 0, 0, 0);
+  DecayProducts too_heavy = {std::make_shared<Tau>(0, 0, 0, false), std::make_shared<Tau>(0, 0, 0, true)};
+  too_heavy[0]->set_momentum(1, 2, 3, 4);
+  CHECK(!light_w.distribute_energy_momentum(too_heavy, 3000, 0, 0, 0, 0));
+  CHECK(too_heavy[0]->get_e() == 1); // Left untouched
+
+  // Off-shell parents only decay through channels that are open at their invariant mass
+  const DecayTable& table = decay_table();
+  const auto& z_channels = table.channels(Species::ZBoson);
+  for(double mass : {0.0, 1.0, 300.0, 3000.0, 9000.0})
+  {
+    for(int i = 0; i < 2000; ++i)
+    {
+      std::size_t index = table.sample_open_index(Species::ZBoson, mass, rng);
+      CHECK(index != DecayTable::no_channel);
+      CHECK(index == DecayTable::no_channel || z_channels[index].is_open(mass));
+    }
+  }
+  std::istringstream heavy_only("ZBoson \"Heavy\" 1 TopQuark AntiTopQuark");
+  DecayTable heavy_table(heavy_only);
+  CHECK(heavy_table.sample_open_index(Species::ZBoson, 91187.6, rng) == 0); // Borrows energy at its rest mass
+  CHECK(heavy_table.sample_open_index(Species::ZBoson, 1000, rng) == DecayTable::no_channel);
+
+  // Full decays conserve four-momentum at every level
+  for(int i = 0; i < 200; ++i)
+  {
+    auto tau_particle = std::make_shared<Tau>(24, 256, 34, false);
+    tau_particle->decay();
+    CHECK(tau_particle->get_decay_products().size() == 3);
+    const FourMomentum& total = tau_particle->get_decay_momentum_total();
+    CHECK_NEAR(total.get_e(), tau_particle->get_e(), 1e-6);
+    CHECK_NEAR(total.get_pz(), tau_particle->get_pz(), 1e-6);
+  }
+
+  return test_result("phase space");
+}
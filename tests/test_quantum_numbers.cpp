@@ -0,0 +1,118 @@
+// Packed quantum numbers (quantum_numbers.h): lanes add exactly, conjugates negate them, and one comparison
+// finds every conservation law a decay breaks
+
+#include "../bosons.h"
+#include "../decay_table.h"
+#include "../lepton.h"
+#include "../particle_factory.h"
+#include "../quantum_numbers.h"
+#include "../quark.h"
+#include "check.h"
+#include <random>
+
+namespace
+{
+  constexpr QuantumLane lanes[] = {QuantumLane::ChargeThirds, QuantumLane::BaryonThirds, QuantumLane::ElectronLepton,
+                                   QuantumLane::MuonLepton, QuantumLane::TauLepton, QuantumLane::Colour};
+
+  // The whole mask of each lane a decay of 'parent' into 'products' violates
+  QuantumNumbers violated_lanes(Species parent, std::initializer_list<Species> products)
+  {
+    auto particle = make_particle(parent, 0, 0, 0);
+    DecayProducts decay_products;
+    for(Species species : products)
+    {
+      decay_products.push_back(make_particle(species, 0, 0, 0));
+    }
+    QuantumNumbers violations = particle->quantum_number_violations(decay_products);
+    QuantumNumbers lanes_violated = 0;
+    for(QuantumLane lane : lanes)
+    {
+      if(violations & quantum_lane_mask(lane))
+      {
+        lanes_violated |= quantum_lane_mask(lane);
+      }
+    }
+    return lanes_violated;
+  }
+}
+
+int main()
+{
+  // Lane-wise addition matches adding each lane as an int, negative sums included
+  std::mt19937 generator(21);
+  std::uniform_int_distribution<int> lane_value(-20, 20);
+  for(int trial = 0; trial < 10000; ++trial)
+  {
+    int a[6], b[6];
+    for(int i = 0; i < 6; ++i)
+    {
+      a[i] = lane_value(generator);
+      b[i] = lane_value(generator);
+    }
+    QuantumNumbers sum = add_quantum_numbers(pack_quantum_numbers(a[0], a[1], a[2], a[3], a[4], a[5]),
+                                             pack_quantum_numbers(b[0], b[1], b[2], b[3], b[4], b[5]));
+    bool exact = true;
+    for(int i = 0; i < 6; ++i)
+    {
+      exact = exact && quantum_lane(sum, lanes[i]) == a[i] + b[i];
+    }
+    CHECK(exact);
+  }
+  CHECK(add_quantum_numbers(pack_quantum_numbers(-1, 0, 0, 0, 0, 0), pack_quantum_numbers(-1, 0, 0, 0, 0, 0)) == pack_quantum_numbers(-2, 0, 0, 0, 0, 0));
+
+  // Known values, in thirds for charge and baryon number
+  CHECK(quantum_lane(quantum_numbers(Species::Electron), QuantumLane::ChargeThirds) == -3);
+  CHECK(quantum_lane(quantum_numbers(Species::Electron), QuantumLane::ElectronLepton) == 1);
+  CHECK(quantum_lane(quantum_numbers(Species::AntiTauNeutrino), QuantumLane::TauLepton) == -1);
+  CHECK(quantum_lane(quantum_numbers(Species::UpQuark), QuantumLane::ChargeThirds) == 2);
+  CHECK(quantum_lane(quantum_numbers(Species::AntiBottomQuark), QuantumLane::ChargeThirds) == 1);
+  CHECK(quantum_lane(quantum_numbers(Species::StrangeQuark), QuantumLane::BaryonThirds) == 1);
+  CHECK(quantum_lane(quantum_numbers(Species::Gluon), QuantumLane::Colour) == 8);
+  CHECK(quantum_lane(quantum_numbers(Species::WMinus), QuantumLane::ChargeThirds) == -3);
+
+  // Conjugates negate every additive lane, and the descriptors agree with the packed words
+  for(std::size_t i = 0; i < species_count; ++i)
+  {
+    Species species = static_cast<Species>(i);
+    QuantumNumbers numbers = quantum_numbers(species), conjugate = quantum_numbers(antiparticle_of(species));
+    for(int lane = 0; lane < 5; ++lane)
+    {
+      CHECK(quantum_lane(numbers, lanes[lane]) == -quantum_lane(conjugate, lanes[lane]));
+    }
+    CHECK(quantum_number_violations(0, add_quantum_numbers(numbers, conjugate)) == 0); // A pair can come from nothing
+    const SpeciesDescriptor& descriptor = species_descriptor(species);
+    CHECK(descriptor.charge * 3 == quantum_lane(numbers, QuantumLane::ChargeThirds));
+    CHECK(descriptor.baryon_number * 3 == quantum_lane(numbers, QuantumLane::BaryonThirds));
+  }
+
+  // Every channel in the built-in decay table conserves everything
+  for(std::size_t i = 0; i < species_count; ++i)
+  {
+    Species species = static_cast<Species>(i);
+    for(const DecayChannel& channel : decay_table().channels(species))
+    {
+      QuantumNumbers total = 0;
+      for(const DecayProduct& product : channel.products)
+      {
+        total = add_quantum_numbers(total, quantum_numbers(product.species));
+      }
+      CHECK(quantum_number_violations(quantum_numbers(species), total) == 0);
+    }
+  }
+
+  // Each broken law shows up in its own lane, and only there
+  CHECK(violated_lanes(Species::WPlus, {Species::AntiElectron, Species::ElectronNeutrino}) == 0);
+  CHECK(violated_lanes(Species::WPlus, {Species::AntiElectron, Species::MuonNeutrino}) ==
+        (lepton_number_lanes & ~quantum_lane_mask(QuantumLane::TauLepton)));
+  CHECK(violated_lanes(Species::ZBoson, {Species::UpQuark, Species::AntiDownQuark}) == quantum_lane_mask(QuantumLane::ChargeThirds));
+  CHECK(violated_lanes(Species::ZBoson, {Species::UpQuark, Species::UpQuark}) ==
+        (quantum_lane_mask(QuantumLane::ChargeThirds) | quantum_lane_mask(QuantumLane::BaryonThirds)));
+  CHECK(violated_lanes(Species::HiggsBoson, {Species::Gluon, Species::Gluon}) == 0); // Colour is carried, not conserved
+  auto tau_particle = std::make_shared<Tau>(0, 0, 0, false);
+  DecayProducts wrong_charge = {make_particle(Species::Electron, 0, 0, 0), make_particle(Species::Electron, 0, 0, 0)};
+  CHECK(!tau_particle->check_charge_conservation(wrong_charge));
+  CHECK(tau_particle->check_baryon_number_conservation(wrong_charge));
+
+  return test_result("quantum numbers");
+}
@@ -0,0 +1,144 @@
+// Philox streams (random_engine.h): reproducible, jumpable and independent, so decays give the same results on any
+// number of threads
+
+#include "../bosons.h"
+#include "../lepton.h"
+#include "../particle_catalogue.h"
+#include "../random_engine.h"
+#include "../thread_pool.h"
+#include "check.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+  std::vector<ParticleRecord> decay_records(std::size_t threads, std::uint64_t seed)
+  {
+    ParticleCatalogue<Particle> catalogue;
+    for(int i = 0; i < 50; ++i)
+    {
+      catalogue.add_particle(std::make_shared<WBoson>(1, 10 + i, 76, 82));
+      catalogue.add_particle(std::make_shared<ZBoson>(190, 423 + i, 780));
+      catalogue.add_particle(std::make_shared<HiggsBoson>(200, 300, 900 + i));
+      catalogue.add_particle(std::make_shared<Tau>(24 + i, 256, 34, false));
+    }
+    ThreadPool pool(threads);
+    catalogue.decay_all(pool, seed);
+
+    std::vector<ParticleRecord> records;
+    for(const Particle& particle : catalogue.all_particles())
+    {
+      DecayTreeArena tree = particle.decay_tree();
+      records.insert(records.end(), tree.records().begin(), tree.records().end());
+    }
+    return records;
+  }
+
+  bool same_records(const std::vector<ParticleRecord>& a, const std::vector<ParticleRecord>& b)
+  {
+    if(a.size() != b.size())
+    {
+      return false;
+    }
+    for(std::size_t i = 0; i < a.size(); ++i)
+    {
+      if(a[i].species != b[i].species || a[i].momentum.get_e() != b[i].momentum.get_e() || a[i].momentum.get_px() != b[i].momentum.get_px() ||
+         a[i].momentum.get_pz() != b[i].momentum.get_pz() || a[i].descendant_count != b[i].descendant_count)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  // The same seed and stream give the same numbers; another seed or stream does not
+  RandomEngine a(42, 7), b(42, 7), other_seed(43, 7), other_stream(42, 8);
+  bool all_equal = true, any_equal_seed = false, any_equal_stream = false;
+  for(int i = 0; i < 1000; ++i)
+  {
+    std::uint64_t x = a();
+    all_equal = all_equal && x == b();
+    any_equal_seed = any_equal_seed || x == other_seed();
+    any_equal_stream = any_equal_stream || x == other_stream();
+  }
+  CHECK(all_equal);
+  CHECK(!any_equal_seed);
+  CHECK(!any_equal_stream);
+  CHECK(a.get_seed() == 42 && a.get_stream() == 7);
+
+  // discard(n) lands exactly where n draws would, from any position within a block
+  for(std::uint64_t consumed : {0, 1, 2, 3})
+  {
+    for(std::uint64_t skip : {0, 1, 2, 5, 1000, 1001})
+    {
+      RandomEngine drawn(9), jumped(9);
+      for(std::uint64_t i = 0; i < consumed; ++i)
+      {
+        drawn();
+        jumped();
+      }
+      for(std::uint64_t i = 0; i < skip; ++i)
+      {
+        drawn();
+      }
+      jumped.discard(skip);
+      CHECK(drawn() == jumped());
+      CHECK(drawn() == jumped());
+    }
+  }
+
+  // Split streams are reproducible and distinct
+  RandomEngine base(1234);
+  std::set<std::uint64_t> streams, first_outputs;
+  for(std::uint64_t id = 0; id < 1000; ++id)
+  {
+    RandomEngine split = base.split(id);
+    CHECK(split.get_seed() == base.get_seed());
+    streams.insert(split.get_stream());
+    first_outputs.insert(split());
+    CHECK(base.split(id).get_stream() == split.get_stream());
+  }
+  CHECK(streams.size() == 1000);
+  CHECK(first_outputs.size() == 1000);
+
+  // uniform() stays in [0, 1) with the right mean
+  RandomEngine uniform_engine(5);
+  double sum = 0;
+  bool in_range = true;
+  const int draws = 100000;
+  for(int i = 0; i < draws; ++i)
+  {
+    double u = uniform_engine.uniform();
+    in_range = in_range && u >= 0 && u < 1;
+    sum += u;
+  }
+  CHECK(in_range);
+  CHECK_NEAR(sum / draws, 0.5, 5 * 0.2887 / std::sqrt(double(draws)));
+
+  // Decays draw from the engine in scope, so a seed reproduces them exactly, on any number of threads
+  std::ostringstream quiet; // Decays report failed conservation checks on std::cerr
+  std::streambuf* cerr_buffer = std::cerr.rdbuf(quiet.rdbuf());
+  RandomEngine first_rng(77), second_rng(77);
+  auto first = std::make_shared<HiggsBoson>(200, 300, 900);
+  auto second = std::make_shared<HiggsBoson>(200, 300, 900);
+  first->decay_with(first_rng);
+  second->decay_with(second_rng);
+  std::vector<ParticleRecord> one_thread = decay_records(1, 2024);
+  std::vector<ParticleRecord> four_threads = decay_records(4, 2024);
+  std::vector<ParticleRecord> other_seed_records = decay_records(4, 2025);
+  std::cerr.rdbuf(cerr_buffer);
+
+  CHECK(same_records(first->decay_tree().records(), second->decay_tree().records()));
+  CHECK(one_thread.size() > 400);
+  CHECK(same_records(one_thread, four_threads));
+  CHECK(!same_records(one_thread, other_seed_records));
+
+  return test_result("random engine");
+}
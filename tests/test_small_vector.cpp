@@ -0,0 +1,138 @@
+// SmallVector (small_vector.h): inline storage up to its capacity, heap past it, and every element constructed and
+// destroyed exactly once whichever storage it is in
+
+#include "../small_vector.h"
+#include "check.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  int live_elements = 0;
+
+  // Counts live instances, so leaks and double destruction show up as a nonzero count at the end
+  struct Counted
+  {
+    std::string value;
+
+    Counted(std::string value = "") : value(std::move(value)) { live_elements++; }
+    Counted(const Counted& other) : value(other.value) { live_elements++; }
+    Counted(Counted&& other) noexcept : value(std::move(other.value)) { live_elements++; }
+    Counted& operator=(const Counted&) = default;
+    Counted& operator=(Counted&&) noexcept = default;
+    ~Counted() { live_elements--; }
+  };
+
+  using Small = SmallVector<Counted, 4>;
+
+  std::vector<std::string> values(const Small& vector)
+  {
+    std::vector<std::string> result;
+    for(const Counted& element : vector)
+    {
+      result.push_back(element.value);
+    }
+    return result;
+  }
+
+  Small filled(int count)
+  {
+    Small vector;
+    for(int i = 0; i < count; ++i)
+    {
+      vector.emplace_back(std::to_string(i));
+    }
+    return vector;
+  }
+}
+
+int main()
+{
+  {
+    // Inline up to the capacity, then on the heap with the elements in order
+    Small vector;
+    CHECK(vector.empty());
+    CHECK(vector.capacity() == Small::inline_capacity);
+    vector = filled(4);
+    CHECK(vector.capacity() == 4);
+    vector.emplace_back("4");
+    CHECK(vector.capacity() > 4);
+    CHECK(values(vector) == (std::vector<std::string>{"0", "1", "2", "3", "4"}));
+    CHECK(vector.front().value == "0" && vector.back().value == "4");
+
+    // Pushing an element of the vector itself while it grows
+    Small full = filled(4);
+    full.push_back(full[0]);
+    CHECK(full.size() == 5 && full.back().value == "0");
+    full.emplace_back(full[2]);
+    CHECK(full.back().value == "2");
+
+    // Copies and moves, inline and on the heap
+    for(int count : {0, 3, 4, 9})
+    {
+      Small source = filled(count);
+      Small copy(source);
+      CHECK(values(copy) == values(source));
+      Small assigned = filled(2);
+      assigned = source;
+      CHECK(values(assigned) == values(source));
+      Small moved(std::move(copy));
+      CHECK(values(moved) == values(source));
+      CHECK(copy.empty());
+      CHECK(copy.capacity() == Small::inline_capacity);
+      Small move_assigned = filled(7);
+      move_assigned = std::move(moved);
+      CHECK(values(move_assigned) == values(source));
+      CHECK(moved.empty());
+      move_assigned = move_assigned; // Self-assignment leaves it alone
+      CHECK(values(move_assigned) == values(source));
+    }
+
+    // A moved heap block is taken, not copied
+    Small big = filled(10);
+    const Counted* data = big.data();
+    Small taken(std::move(big));
+    CHECK(taken.data() == data);
+
+    // pop_back, clear (which keeps the capacity) and reserve
+    taken.pop_back();
+    CHECK(taken.size() == 9 && taken.back().value == "8");
+    std::size_t capacity = taken.capacity();
+    taken.clear();
+    CHECK(taken.empty() && taken.capacity() == capacity);
+    Small reserved;
+    reserved.reserve(100);
+    CHECK(reserved.capacity() >= 100);
+    reserved.reserve(2);
+    CHECK(reserved.capacity() >= 100);
+
+    // Initializer-list and iterator-range construction, and reverse iteration
+    Small listed = {Counted("a"), Counted("b"), Counted("c")};
+    CHECK(values(listed) == (std::vector<std::string>{"a", "b", "c"}));
+    std::vector<Counted> source(6, Counted("x"));
+    Small ranged(source.begin(), source.end());
+    CHECK(ranged.size() == 6);
+    std::string reversed;
+    for(auto it = listed.rbegin(); it != listed.rend(); ++it)
+    {
+      reversed += it->value;
+    }
+    CHECK(reversed == "cba");
+  }
+  CHECK(live_elements == 0);
+
+  // The element type decay products use
+  SmallVector<std::shared_ptr<int>, 4> pointers;
+  auto shared = std::make_shared<int>(3);
+  for(int i = 0; i < 6; ++i)
+  {
+    pointers.push_back(shared);
+  }
+  CHECK(shared.use_count() == 7);
+  pointers.clear();
+  CHECK(shared.use_count() == 1);
+
+  return test_result("small vector");
+}
@@ -0,0 +1,179 @@
+// Binary catalogue snapshots: a round trip keeps every tree, and truncated or corrupt files are refused
+
+#include "../bosons.h"
+#include "../catalogue_snapshot.h"
+#include "../lepton.h"
+#include "../random_engine.h"
+#include "check.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+  const char* const good_path = "test_snapshot.pcat";
+  const char* const bad_path = "test_snapshot_bad.pcat";
+
+  std::string read_bytes(const std::string& path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  void write_bytes(const std::string& path, const std::string& bytes)
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  }
+
+  template<typename Value>
+  void poke(std::string& bytes, std::uint64_t offset, Value value)
+  {
+    std::memcpy(&bytes[offset], &value, sizeof(value));
+  }
+
+  // Writes 'bytes' to a scratch file and checks that opening it throws std::invalid_argument
+  void check_rejected(const std::string& bytes)
+  {
+    write_bytes(bad_path, bytes);
+    CatalogueSnapshot snapshot;
+    CHECK_THROWS(snapshot.open(bad_path), std::invalid_argument);
+    CHECK(snapshot.size() == 0);
+  }
+}
+
+int main()
+{
+  ParticleCatalogue<Particle> catalogue;
+  RandomEngine rng(17);
+  auto z_boson = std::make_shared<ZBoson>(10, 20, 30);
+  z_boson->decay_with(rng);
+  auto tau_particle = std::make_shared<Tau>(24, 256, 34, false);
+  tau_particle->decay_with(rng);
+  catalogue.add_particle(std::make_shared<Electron>(1, 2, 3));
+  catalogue.add_particle(z_boson);
+  catalogue.add_particle(tau_particle);
+  CHECK(write_snapshot(catalogue, good_path));
+
+  // Round trip: the same base particles, tree sizes and momenta, node for node
+  {
+    CatalogueSnapshot snapshot;
+    CHECK(snapshot.open(good_path));
+    CHECK(snapshot.size() == catalogue.size());
+    ParticleCatalogue<Particle> loaded;
+    load_snapshot(snapshot, loaded);
+    CHECK(loaded.size() == catalogue.size());
+    std::size_t node = 0;
+    for(const Particle& original : catalogue.all_particles())
+    {
+      DecayTreeArena tree = original.decay_tree();
+      for(std::size_t i = 0; i < tree.size(); ++i, ++node)
+      {
+        CHECK(snapshot.species()[node] == tree[i].species);
+        CHECK(snapshot.momentum(node).get_e() == tree[i].momentum.get_e());
+        CHECK(snapshot.momentum(node).get_pz() == tree[i].momentum.get_pz());
+      }
+    }
+    CHECK(node == snapshot.node_count());
+    for(std::size_t i = 0; i < snapshot.size(); ++i)
+    {
+      std::shared_ptr<Particle> rebuilt = snapshot.particle(i);
+      CHECK(rebuilt->decay_tree().size() == std::size_t{snapshot.descendant_count()[snapshot.roots()[i]]} + 1);
+    }
+    CHECK_NEAR(loaded.decay_momentum().get_e(), catalogue.decay_momentum().get_e(), 1e-6 * catalogue.decay_momentum().get_e());
+    CHECK_THROWS(snapshot.particle(snapshot.size()), std::out_of_range);
+
+    // A catalogue of one kind takes a snapshot of that kind only, all or nothing
+    ParticleCatalogue<Lepton> leptons;
+    CHECK_THROWS(load_snapshot(snapshot, leptons), std::invalid_argument); // The Z is not a lepton
+    CHECK(leptons.size() == 0);
+  }
+  {
+    ParticleCatalogue<Particle> lepton_catalogue;
+    lepton_catalogue.add_particle(std::make_shared<Muon>(1, 2, 3));
+    lepton_catalogue.add_particle(tau_particle);
+    CHECK(write_snapshot(lepton_catalogue, bad_path));
+    CatalogueSnapshot snapshot;
+    CHECK(snapshot.open(bad_path));
+    ParticleCatalogue<Lepton> leptons;
+    load_snapshot(snapshot, leptons);
+    CHECK(leptons.size() == 2);
+    CHECK(leptons.count_of_type("Tau") == 1);
+  }
+
+  // A file that does not exist is not an error, just a failed open
+  {
+    CatalogueSnapshot snapshot;
+    CHECK(!snapshot.open("no_such_snapshot.pcat"));
+  }
+
+  const std::string good = read_bytes(good_path);
+  const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(good.data());
+  SnapshotLayout layout(header.particle_count, header.node_count);
+  CHECK(good.size() == layout.file_size);
+
+  // Truncated anywhere, or with bytes appended
+  check_rejected(good.substr(0, 10));
+  check_rejected(good.substr(0, sizeof(SnapshotHeader)));
+  check_rejected(good.substr(0, good.size() - 1));
+  check_rejected(good + std::string(8, '\0'));
+
+  // Corrupt headers
+  std::string bytes = good;
+  bytes[0] = 'X';
+  check_rejected(bytes);
+  bytes = good;
+  poke(bytes, offsetof(SnapshotHeader, version), std::uint32_t{99});
+  check_rejected(bytes);
+  bytes = good;
+  poke(bytes, offsetof(SnapshotHeader, node_count), ~std::uint64_t{0}); // Would overflow the layout arithmetic
+  check_rejected(bytes);
+  bytes = good;
+  poke(bytes, offsetof(SnapshotHeader, particle_count), header.node_count + 1);
+  check_rejected(bytes);
+
+  // Corrupt links open (the header is fine) but are refused when the tree is rebuilt
+  bytes = good;
+  poke(bytes, layout.roots + sizeof(std::uint32_t), std::uint32_t{1000000}); // Root past the last node
+  write_bytes(bad_path, bytes);
+  {
+    CatalogueSnapshot snapshot;
+    CHECK(snapshot.open(bad_path));
+    CHECK_THROWS(snapshot.particle(1), std::invalid_argument);
+  }
+  bytes = good;
+  poke(bytes, layout.descendant_count, std::uint32_t{1000000}); // Subtree runs past the end
+  write_bytes(bad_path, bytes);
+  {
+    CatalogueSnapshot snapshot;
+    CHECK(snapshot.open(bad_path));
+    CHECK_THROWS(snapshot.particle(0), std::invalid_argument);
+  }
+  std::uint32_t z_root = reinterpret_cast<const std::uint32_t*>(good.data() + layout.roots)[1];
+  for(std::uint32_t bad_parent : {z_root + 1, z_root + 5, 0u, ParticleRecord::no_index}) // Itself, a later node, another tree
+  {
+    bytes = good;
+    poke(bytes, layout.parent + (z_root + 1) * sizeof(std::uint32_t), bad_parent);
+    write_bytes(bad_path, bytes);
+    CatalogueSnapshot snapshot;
+    CHECK(snapshot.open(bad_path));
+    CHECK_THROWS(snapshot.particle(1), std::invalid_argument);
+  }
+  bytes = good;
+  bytes[layout.species] = static_cast<char>(250);
+  write_bytes(bad_path, bytes);
+  {
+    CatalogueSnapshot snapshot;
+    CHECK(snapshot.open(bad_path));
+    CHECK_THROWS(snapshot.particle(0), std::invalid_argument);
+  }
+
+  std::remove(good_path);
+  std::remove(bad_path);
+  return test_result("snapshot");
+}
@@ -0,0 +1,563 @@
+// TextFormatter (text_formatter.h): print renders every species byte for byte as the iostream code it replaced, and
+// numbers come out as an ostream writes them under each notation and precision
+
+#include "../bosons.h"
+#include "../decay_table.h"
+#include "../lepton.h"
+#include "../quark.h"
+#include "../text_formatter.h"
+#include "check.h"
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <limits>
+#include <locale>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // Every species once, with decayed W, tau and Higgs trees, a virtual W and Z, calorimeter electrons and quarks
+  // of every colour
+  std::vector<std::shared_ptr<Particle>> make_particles()
+  {
+    std::vector<std::shared_ptr<Particle>> particles;
+    DecayChannel leptonic;
+    leptonic.label = "Leptonic";
+    DecayChannel hadronic;
+    hadronic.label = "Hadronic";
+
+    auto w_plus = std::make_shared<WBoson>(1, 12.5, -40.25, 30);
+    w_plus->set_decay_channel(leptonic);
+    w_plus->add_decay_product(std::make_shared<Electron>(8.5, -20, 14, std::vector<double>{0.1, 0.2, 0.3, 0.4}, true));
+    w_plus->add_decay_product(std::make_shared<ElectronNeutrino>(4, -20.25, 16, false, false));
+    particles.push_back(w_plus);
+
+    auto w_minus = std::make_shared<WBoson>(-1, 0, 0, 0, 12.5); // Virtual
+    w_minus->set_decay_channel(hadronic);
+    w_minus->add_decay_product(std::make_shared<DownQuark>(10, 5, 0, ColourCharge::Green));
+    w_minus->add_decay_product(std::make_shared<UpQuark>(-10, -5, 0, ColourCharge::AntiGreen, true));
+    particles.push_back(w_minus);
+
+    auto tau_particle = std::make_shared<Tau>(24, 256, 34, false);
+    tau_particle->set_decay_channel(leptonic);
+    tau_particle->add_decay_product(std::make_shared<Muon>(10, 100, 14, true, false));
+    tau_particle->add_decay_product(std::make_shared<MuonNeutrino>(4, 60, 10, false, true));
+    tau_particle->add_decay_product(std::make_shared<TauNeutrino>(10, 96, 10, true, false));
+    particles.push_back(tau_particle);
+
+    auto higgs = std::make_shared<HiggsBoson>(1, 2, 3);
+    higgs->set_decay_channel(leptonic);
+    auto z_boson = std::make_shared<ZBoson>(0.5, 1, 1.5, 1000);
+    z_boson->set_decay_channel(leptonic);
+    z_boson->add_decay_product(std::make_shared<Muon>(0.25, 0.5, 0.75, false, true));
+    z_boson->add_decay_product(std::make_shared<Tau>(0.25, 0.5, 0.75, true));
+    higgs->add_decay_product(z_boson);
+    higgs->add_decay_product(std::make_shared<ZBoson>(0.5, 1, 1.5, 1000));
+    particles.push_back(higgs);
+
+    particles.push_back(std::make_shared<Electron>(1, 2, 3, std::vector<double>{0.2, 0.1, 0.15, 0.05}));
+    particles.push_back(std::make_shared<ElectronNeutrino>(0.1, 0.2, 0.3, true, true));
+    particles.push_back(std::make_shared<MuonNeutrino>(0.1, 0.2, 0.3, true, false));
+    particles.push_back(std::make_shared<TauNeutrino>(0.1, 0.2, 0.3, false, true));
+    particles.push_back(std::make_shared<UpQuark>(1, 2, 3, ColourCharge::Red));
+    particles.push_back(std::make_shared<DownQuark>(1, 2, 3, ColourCharge::AntiBlue, true));
+    particles.push_back(std::make_shared<CharmQuark>(100, 200, 300, ColourCharge::Blue));
+    particles.push_back(std::make_shared<CharmQuark>(100, 200, 300, ColourCharge::AntiRed, true));
+    particles.push_back(std::make_shared<StrangeQuark>(1, 2, 3, ColourCharge::Green));
+    particles.push_back(std::make_shared<StrangeQuark>(1, 2, 3, ColourCharge::AntiGreen, true));
+    particles.push_back(std::make_shared<TopQuark>(1000, 2000, 3000, ColourCharge::Red));
+    particles.push_back(std::make_shared<TopQuark>(1000, 2000, 3000, ColourCharge::AntiRed, true));
+    particles.push_back(std::make_shared<BottomQuark>(10, 20, 30, ColourCharge::Blue));
+    particles.push_back(std::make_shared<BottomQuark>(10, 20, 30, ColourCharge::AntiBlue, true));
+    particles.push_back(std::make_shared<Photon>(0.001, 0.002, 0.003));
+    particles.push_back(std::make_shared<Gluon>(ColourCharge::Red, ColourCharge::AntiBlue, 5, 6, 7));
+    return particles;
+  }
+
+  // What printing make_particles() in order wrote to std::cout through iostreams, field by field, before
+  // TextFormatter
+  const char* const iostream_rendering = R"(Type: W+
+  Mass: 80377.00 MeV/c^2
+  Invariant mass: 80377.00 MeV/c^2
+  Charge: 1.00
+  Spin: 1.00
+  Four-Momentum: (80377.02, 12.50, -40.25, 30.00) MeV/c
+Decay Type: Leptonic
+Decay Products:
+Type: AntiElectron
+  Mass: 0.51 MeV/c^2
+  Invariant mass: 0.51 MeV/c^2
+  Charge: 1.00
+  Spin: 0.50
+  Four-Momentum: (25.86, 8.50, -20.00, 14.00) MeV/c
+  Electron Lepton Number: -1
+  Muon Lepton Number: 0
+  Tau Lepton Number: 0
+  Antiparticle: Yes
+  Calorimeter Deposits: 2.59 5.17 7.76 10.34 
+Type: ElectronNeutrino
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 0.50
+  Four-Momentum: (26.12, 4.00, -20.25, 16.00) MeV/c
+  Electron Lepton Number: 1
+  Muon Lepton Number: 0
+  Tau Lepton Number: 0
+  Antiparticle: No
+  Has Interacted: No
+Virtual WBoson with borrowed energy: 12.50 MeV
+Type: W-
+  Mass: 80377.00 MeV/c^2
+  Invariant mass: 80377.00 MeV/c^2
+  Charge: -1.00
+  Spin: 1.00
+  Four-Momentum: (80377.00, 0.00, 0.00, 0.00) MeV/c
+Decay Type: Hadronic
+Decay Products:
+Type: DownQuark
+  Mass: 4.70 MeV/c^2
+  Invariant mass: 4.70 MeV/c^2
+  Charge: -0.33
+  Spin: 0.50
+  Four-Momentum: (12.13, 10.00, 5.00, 0.00) MeV/c
+  Colour Charge: Green
+  Baron number: 0.33
+  Antiparticle: No
+Type: AntiUpQuark
+  Mass: 2.20 MeV/c^2
+  Invariant mass: 2.20 MeV/c^2
+  Charge: -0.67
+  Spin: 0.50
+  Four-Momentum: (11.39, -10.00, -5.00, 0.00) MeV/c
+  Colour Charge: AntiGreen
+  Baron number: -0.33
+  Antiparticle: Yes
+Type: Tau
+  Mass: 1776.86 MeV/c^2
+  Invariant mass: 1776.86 MeV/c^2
+  Charge: -1.00
+  Spin: 0.50
+  Four-Momentum: (1795.69, 24.00, 256.00, 34.00) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: 0
+  Tau Lepton Number: 1
+  Antiparticle: No
+Decay Type: Leptonic
+Decay Products:
+Type: Muon
+  Mass: 105.66 MeV/c^2
+  Invariant mass: 105.66 MeV/c^2
+  Charge: -1.00
+  Spin: 0.50
+  Four-Momentum: (146.49, 10.00, 100.00, 14.00) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: 1
+  Tau Lepton Number: 0
+  Antiparticle: No
+  Is Isolated: Yes
+Type: AntiMuonNeutrino
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 0.50
+  Four-Momentum: (60.96, 4.00, 60.00, 10.00) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: -1
+  Tau Lepton Number: 0
+  Antiparticle: Yes
+  Has Interacted: No
+Type: TauNeutrino
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 0.50
+  Four-Momentum: (97.04, 10.00, 96.00, 10.00) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: 0
+  Tau Lepton Number: 1
+  Antiparticle: No
+  Has Interacted: Yes
+Type: HiggsBoson
+  Mass: 125110.00 MeV/c^2
+  Invariant mass: 125110.00 MeV/c^2
+  Charge: 0.00
+  Spin: 0.00
+  Four-Momentum: (125110.00, 1.00, 2.00, 3.00) MeV/c
+Decay Type: Leptonic
+Decay Products:
+Virtual ZBoson with borrowed energy: 1000.00 MeV
+Type: ZBoson
+  Mass: 91187.60 MeV/c^2
+  Invariant mass: 91187.60 MeV/c^2
+  Charge: 0.00
+  Spin: 1.00
+  Four-Momentum: (91187.60, 0.50, 1.00, 1.50) MeV/c
+Decay Type: Leptonic
+Decay Products:
+Type: AntiMuon
+  Mass: 105.66 MeV/c^2
+  Invariant mass: 105.66 MeV/c^2
+  Charge: 1.00
+  Spin: 0.50
+  Four-Momentum: (105.66, 0.25, 0.50, 0.75) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: -1
+  Tau Lepton Number: 0
+  Antiparticle: Yes
+  Is Isolated: No
+Type: AntiTau
+  Mass: 1776.86 MeV/c^2
+  Invariant mass: 1776.86 MeV/c^2
+  Charge: 1.00
+  Spin: 0.50
+  Four-Momentum: (1776.86, 0.25, 0.50, 0.75) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: 0
+  Tau Lepton Number: -1
+  Antiparticle: Yes
+Decay Type: 
+Decay Products:
+Virtual ZBoson with borrowed energy: 1000.00 MeV
+Type: ZBoson
+  Mass: 91187.60 MeV/c^2
+  Invariant mass: 91187.60 MeV/c^2
+  Charge: 0.00
+  Spin: 1.00
+  Four-Momentum: (91187.60, 0.50, 1.00, 1.50) MeV/c
+Decay Type: 
+Decay Products:
+Type: Electron
+  Mass: 0.51 MeV/c^2
+  Invariant mass: 0.51 MeV/c^2
+  Charge: -1.00
+  Spin: 0.50
+  Four-Momentum: (3.78, 1.00, 2.00, 3.00) MeV/c
+  Electron Lepton Number: 1
+  Muon Lepton Number: 0
+  Tau Lepton Number: 0
+  Antiparticle: No
+  Calorimeter Deposits: 1.51 0.76 1.13 0.38 
+Type: AntiElectronNeutrino
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 0.50
+  Four-Momentum: (0.37, 0.10, 0.20, 0.30) MeV/c
+  Electron Lepton Number: -1
+  Muon Lepton Number: 0
+  Tau Lepton Number: 0
+  Antiparticle: Yes
+  Has Interacted: Yes
+Type: MuonNeutrino
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 0.50
+  Four-Momentum: (0.37, 0.10, 0.20, 0.30) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: 1
+  Tau Lepton Number: 0
+  Antiparticle: No
+  Has Interacted: Yes
+Type: AntiTauNeutrino
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 0.50
+  Four-Momentum: (0.37, 0.10, 0.20, 0.30) MeV/c
+  Electron Lepton Number: 0
+  Muon Lepton Number: 0
+  Tau Lepton Number: -1
+  Antiparticle: Yes
+  Has Interacted: No
+Type: UpQuark
+  Mass: 2.20 MeV/c^2
+  Invariant mass: 2.20 MeV/c^2
+  Charge: 0.67
+  Spin: 0.50
+  Four-Momentum: (4.34, 1.00, 2.00, 3.00) MeV/c
+  Colour Charge: Red
+  Baron number: 0.33
+  Antiparticle: No
+Type: AntiDownQuark
+  Mass: 4.70 MeV/c^2
+  Invariant mass: 4.70 MeV/c^2
+  Charge: 0.33
+  Spin: 0.50
+  Four-Momentum: (6.01, 1.00, 2.00, 3.00) MeV/c
+  Colour Charge: AntiBlue
+  Baron number: -0.33
+  Antiparticle: Yes
+Type: CharmQuark
+  Mass: 1280.00 MeV/c^2
+  Invariant mass: 1280.00 MeV/c^2
+  Charge: 0.67
+  Spin: 0.50
+  Four-Momentum: (1333.57, 100.00, 200.00, 300.00) MeV/c
+  Colour Charge: Blue
+  Baron number: 0.33
+  Antiparticle: No
+Type: AntiCharmQuark
+  Mass: 1280.00 MeV/c^2
+  Invariant mass: 1280.00 MeV/c^2
+  Charge: -0.67
+  Spin: 0.50
+  Four-Momentum: (1333.57, 100.00, 200.00, 300.00) MeV/c
+  Colour Charge: AntiRed
+  Baron number: -0.33
+  Antiparticle: Yes
+Type: StrangeQuark
+  Mass: 95.00 MeV/c^2
+  Invariant mass: 95.00 MeV/c^2
+  Charge: -0.33
+  Spin: 0.50
+  Four-Momentum: (95.07, 1.00, 2.00, 3.00) MeV/c
+  Colour Charge: Green
+  Baron number: 0.33
+  Antiparticle: No
+Type: AntiStrangeQuark
+  Mass: 95.00 MeV/c^2
+  Invariant mass: 95.00 MeV/c^2
+  Charge: 0.33
+  Spin: 0.50
+  Four-Momentum: (95.07, 1.00, 2.00, 3.00) MeV/c
+  Colour Charge: AntiGreen
+  Baron number: -0.33
+  Antiparticle: Yes
+Type: TopQuark
+  Mass: 173100.00 MeV/c^2
+  Invariant mass: 173100.00 MeV/c^2
+  Charge: 0.67
+  Spin: 0.50
+  Four-Momentum: (173140.43, 1000.00, 2000.00, 3000.00) MeV/c
+  Colour Charge: Red
+  Baron number: 0.33
+  Antiparticle: No
+Type: AntiTopQuark
+  Mass: 173100.00 MeV/c^2
+  Invariant mass: 173100.00 MeV/c^2
+  Charge: -0.67
+  Spin: 0.50
+  Four-Momentum: (173140.43, 1000.00, 2000.00, 3000.00) MeV/c
+  Colour Charge: AntiRed
+  Baron number: -0.33
+  Antiparticle: Yes
+Type: BottomQuark
+  Mass: 4180.00 MeV/c^2
+  Invariant mass: 4180.00 MeV/c^2
+  Charge: -0.33
+  Spin: 0.50
+  Four-Momentum: (4180.17, 10.00, 20.00, 30.00) MeV/c
+  Colour Charge: Blue
+  Baron number: 0.33
+  Antiparticle: No
+Type: AntiBottomQuark
+  Mass: 4180.00 MeV/c^2
+  Invariant mass: 4180.00 MeV/c^2
+  Charge: 0.33
+  Spin: 0.50
+  Four-Momentum: (4180.17, 10.00, 20.00, 30.00) MeV/c
+  Colour Charge: AntiBlue
+  Baron number: -0.33
+  Antiparticle: Yes
+Type: Photon
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 1.00
+  Four-Momentum: (0.00, 0.00, 0.00, 0.00) MeV/c
+  Frequency: 0.000 GHz
+  Wavelength: 2068197110117.844 nm
+Type: Gluon
+  Mass: 0.00 MeV/c^2
+  Invariant mass: 0.00 MeV/c^2
+  Charge: 0.00
+  Spin: 1.00
+  Four-Momentum: (10.49, 5.00, 6.00, 7.00) MeV/c
+  Colour 1: Red
+  Colour 2: AntiBlue
+)";
+
+  // The virtual W-'s rendering after its first line, which comes before anything sets fixed notation and so is
+  // written in whatever notation the stream is in
+  const char* const w_minus_rest = R"(Type: W-
+  Mass: 80377.00 MeV/c^2
+  Invariant mass: 80377.00 MeV/c^2
+  Charge: -1.00
+  Spin: 1.00
+  Four-Momentum: (80377.00, 0.00, 0.00, 0.00) MeV/c
+Decay Type: Hadronic
+Decay Products:
+Type: DownQuark
+  Mass: 4.70 MeV/c^2
+  Invariant mass: 4.70 MeV/c^2
+  Charge: -0.33
+  Spin: 0.50
+  Four-Momentum: (12.13, 10.00, 5.00, 0.00) MeV/c
+  Colour Charge: Green
+  Baron number: 0.33
+  Antiparticle: No
+Type: AntiUpQuark
+  Mass: 2.20 MeV/c^2
+  Invariant mass: 2.20 MeV/c^2
+  Charge: -0.67
+  Spin: 0.50
+  Four-Momentum: (11.39, -10.00, -5.00, 0.00) MeV/c
+  Colour Charge: AntiGreen
+  Baron number: -0.33
+  Antiparticle: Yes
+)";
+
+  std::string rendered(double value, std::ios_base::fmtflags floatfield, int precision, bool through_formatter)
+  {
+    std::ostringstream out;
+    out.setf(floatfield, std::ios_base::floatfield);
+    out.precision(precision);
+    if(through_formatter)
+    {
+      TextFormatter formatter(out);
+      formatter<<value;
+    }
+    else
+    {
+      out<<value;
+    }
+    return out.str();
+  }
+
+  // True if constructing a formatter over a stream set up by 'configure' throws std::invalid_argument
+  template<typename Configure>
+  bool rejected(Configure configure)
+  {
+    std::ostringstream out;
+    configure(out);
+    try
+    {
+      TextFormatter formatter(out);
+    }
+    catch(const std::invalid_argument&)
+    {
+      return true;
+    }
+    return false;
+  }
+}
+
+int main()
+{
+  std::ostringstream quiet; // Adding products reports failed conservation checks on std::cerr
+  std::streambuf* cerr_buffer = std::cerr.rdbuf(quiet.rdbuf());
+  std::vector<std::shared_ptr<Particle>> particles = make_particles();
+  std::cerr.rdbuf(cerr_buffer);
+
+  // Through one formatter over a stream, and through print() on std::cout
+  std::ostringstream formatted;
+  {
+    TextFormatter out(formatted);
+    for(const auto& particle : particles)
+    {
+      particle->print(out);
+    }
+  }
+  CHECK(formatted.str() == iostream_rendering);
+  std::ostringstream printed;
+  std::streambuf* cout_buffer = std::cout.rdbuf(printed.rdbuf());
+  std::ios_base::fmtflags cout_flags = std::cout.flags();
+  std::streamsize cout_precision = std::cout.precision();
+  for(const auto& particle : particles)
+  {
+    particle->print();
+  }
+  std::cout<<1234.56789; // The stream is left as the iostream code left it: fixed, 2 digits
+  std::cout.flags(cout_flags);
+  std::cout.precision(cout_precision);
+  std::cout.rdbuf(cout_buffer);
+  CHECK(printed.str() == std::string(iostream_rendering) + "1234.57");
+
+  // A FILE* sink gets the same bytes
+  if(std::FILE* file = std::tmpfile())
+  {
+    {
+      TextFormatter out(file);
+      for(const auto& particle : particles)
+      {
+        particle->print(out);
+      }
+    }
+    std::rewind(file);
+    std::string read_back;
+    for(int c = std::fgetc(file); c != EOF; c = std::fgetc(file))
+    {
+      read_back.push_back(static_cast<char>(c));
+    }
+    std::fclose(file);
+    CHECK(read_back == iostream_rendering);
+  }
+
+  // A stream left in scientific or hexfloat notation keeps it until the first property sets fixed
+  std::ostringstream scientific;
+  scientific<<std::scientific<<std::setprecision(4);
+  {
+    TextFormatter out(scientific);
+    particles[1]->print(out);
+  }
+  CHECK(scientific.str() == std::string("Virtual WBoson with borrowed energy: 1.2500e+01 MeV\n") + w_minus_rest);
+  std::ostringstream hexfloat;
+  hexfloat<<std::hexfloat;
+  {
+    TextFormatter out(hexfloat);
+    particles[1]->print(out);
+  }
+  CHECK(hexfloat.str() == std::string("Virtual WBoson with borrowed energy: 0x1.9p+3 MeV\n") + w_minus_rest);
+  CHECK((hexfloat.flags() & std::ios_base::floatfield) == std::ios_base::fixed && hexfloat.precision() == 2);
+
+  // Numbers match an ostream's under every notation and a range of precisions, and the notation is handed back
+  const double values[] = {0.0, -0.0, 1.0, -1.5, 12.5, 0.1, 1234.56789, -98765.4321, 1e-7, 3.0e21, 6.02214076e23,
+                           std::numeric_limits<double>::min(), std::numeric_limits<double>::denorm_min(),
+                           std::numeric_limits<double>::max(), -std::numeric_limits<double>::infinity(),
+                           std::numeric_limits<double>::quiet_NaN()};
+  const std::ios_base::fmtflags floatfields[] = {std::ios_base::fmtflags(), std::ios_base::fixed, std::ios_base::scientific,
+                                                 std::ios_base::fixed | std::ios_base::scientific};
+  bool numbers_match = true;
+  for(std::ios_base::fmtflags floatfield : floatfields)
+  {
+    for(int precision : {0, 1, 2, 6, 10, 17})
+    {
+      for(double value : values)
+      {
+        numbers_match = numbers_match && rendered(value, floatfield, precision, true) == rendered(value, floatfield, precision, false);
+      }
+    }
+    std::ostringstream handed_back;
+    handed_back.setf(floatfield, std::ios_base::floatfield);
+    handed_back.precision(9);
+    {
+      TextFormatter out(handed_back);
+      out<<1.0;
+    }
+    CHECK((handed_back.flags() & std::ios_base::floatfield) == floatfield && handed_back.precision() == 9);
+  }
+  CHECK(numbers_match);
+
+  // Stream state the formatter cannot reproduce is rejected rather than ignored
+  CHECK(rejected([](std::ostream& out) { out<<std::showpos; }));
+  CHECK(rejected([](std::ostream& out) { out<<std::showpoint; }));
+  CHECK(rejected([](std::ostream& out) { out<<std::uppercase; }));
+  CHECK(rejected([](std::ostream& out) { out<<std::hex; }));
+  CHECK(rejected([](std::ostream& out) { out<<std::setw(8); }));
+  struct CommaDecimal : std::numpunct<char>
+  {
+    char do_decimal_point() const override { return ','; }
+  };
+  CHECK(rejected([](std::ostream& out) { out.imbue(std::locale(out.getloc(), new CommaDecimal)); }));
+  CHECK(!rejected([](std::ostream& out) { out<<std::scientific<<std::setprecision(3); }));
+
+  return test_result("text formatter");
+}
@@ -0,0 +1,141 @@
+#include "text_formatter.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <ios>
+#include <limits>
+#include <locale>
+#include <stdexcept>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+TextFormatter::TextFormatter(std::ostream& sink) : kind(SinkKind::Stream), stream(&sink)
+{
+  std::ios_base::fmtflags flags = sink.flags();
+  const std::numpunct<char>& punctuation = std::use_facet<std::numpunct<char>>(sink.getloc());
+  if((flags & (std::ios_base::showpos | std::ios_base::showpoint | std::ios_base::uppercase)) ||
+     (flags & std::ios_base::basefield & ~std::ios_base::dec) || sink.width() != 0 ||
+     punctuation.decimal_point() != '.' || !punctuation.grouping().empty())
+  {
+    throw std::invalid_argument("TextFormatter cannot reproduce this stream's number formatting state.");
+  }
+  switch(flags & std::ios_base::floatfield)
+  {
+    case std::ios_base::fixed: notation = Notation::Fixed; break;
+    case std::ios_base::scientific: notation = Notation::Scientific; break;
+    case std::ios_base::fixed | std::ios_base::scientific: notation = Notation::Hex; break;
+    default: notation = Notation::General; break;
+  }
+  precision = static_cast<int>(sink.precision());
+  buffer.reserve(block_size);
+}
+
+TextFormatter::TextFormatter(std::FILE* sink) : kind(SinkKind::File), file(sink)
+{
+  buffer.reserve(block_size);
+}
+
+TextFormatter::TextFormatter(Descriptor sink) : kind(SinkKind::Descriptor), descriptor(sink.fd)
+{
+  buffer.reserve(block_size);
+}
+
+TextFormatter::~TextFormatter()
+{
+  flush();
+}
+
+void TextFormatter::append_double(double value)
+{
+  // Large enough for any double in fixed notation (309 integer digits) at any sensible precision
+  char digits[400 + std::numeric_limits<double>::max_digits10];
+  int digits_after = precision < 0 ? 6 : std::min(precision, 100);
+  char* first = digits + 2; // Room for hexfloat's "0x"
+  char* last = digits + sizeof(digits);
+  std::to_chars_result result;
+  switch(notation)
+  {
+    case Notation::Fixed: result = std::to_chars(first, last, value, std::chars_format::fixed, digits_after); break;
+    case Notation::Scientific: result = std::to_chars(first, last, value, std::chars_format::scientific, digits_after); break;
+    case Notation::Hex: result = std::to_chars(first, last, value, std::chars_format::hex); break; // %a, exact
+    default: result = std::to_chars(first, last, value, std::chars_format::general, digits_after); break; // %g
+  }
+  if(notation == Notation::Hex && std::isfinite(value))
+  {
+    // to_chars leaves out the "0x" that %a writes after any sign
+    bool negative = *first == '-';
+    first -= 2;
+    first[0] = negative ? '-' : '0';
+    first[1] = negative ? '0' : 'x';
+    if(negative)
+    {
+      first[2] = 'x';
+    }
+  }
+  *this<<std::string_view(first, static_cast<std::size_t>(result.ptr - first));
+}
+
+void TextFormatter::append_integer(long long value)
+{
+  char digits[24];
+  std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+void TextFormatter::append_unsigned(unsigned long long value)
+{
+  char digits[24];
+  std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+void TextFormatter::write_out()
+{
+  switch(kind)
+  {
+    case SinkKind::Stream:
+      stream->rdbuf()->sputn(buffer.data(), static_cast<std::streamsize>(buffer.size())); // Honours a redirected rdbuf
+      break;
+    case SinkKind::File:
+      std::fwrite(buffer.data(), 1, buffer.size(), file);
+      break;
+    case SinkKind::Descriptor:
+      for(std::size_t written = 0; written < buffer.size();)
+      {
+#ifdef _WIN32
+        int count = _write(descriptor, buffer.data() + written, static_cast<unsigned>(buffer.size() - written));
+#else
+        ssize_t count = ::write(descriptor, buffer.data() + written, buffer.size() - written);
+#endif
+        if(count <= 0)
+        {
+          break;
+        }
+        written += static_cast<std::size_t>(count);
+      }
+      break;
+  }
+  buffer.clear();
+}
+
+void TextFormatter::flush()
+{
+  if(!buffer.empty())
+  {
+    write_out();
+  }
+  if(kind == SinkKind::Stream)
+  {
+    switch(notation)
+    {
+      case Notation::Fixed: stream->setf(std::ios_base::fixed, std::ios_base::floatfield); break;
+      case Notation::Scientific: stream->setf(std::ios_base::scientific, std::ios_base::floatfield); break;
+      case Notation::Hex: stream->setf(std::ios_base::fixed | std::ios_base::scientific, std::ios_base::floatfield); break;
+      default: stream->unsetf(std::ios_base::floatfield); break;
+    }
+    stream->precision(precision);
+  }
+}
@@ -0,0 +1,102 @@
+#ifndef TEXT_FORMATTER_H
+#define TEXT_FORMATTER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Renders text into a reusable buffer with std::to_chars and hands it to a sink (an ostream, a FILE* or a file
+// descriptor) in large blocks, instead of paying for iostream's per-field sentry, locale and state handling.
+// Numbers come out exactly as an ostream would write them. For an ostream sink the formatter starts from the
+// stream's notation (default, fixed, scientific or hexfloat) and precision and leaves the stream in the state it
+// ends in, so the text matches, byte for byte, what writing field by field to that stream would have produced.
+// Stream state it cannot reproduce (showpos, showpoint, uppercase, a non-decimal base, a field width, or a locale
+// that groups digits or uses another decimal point) is rejected with std::invalid_argument.
+class TextFormatter
+{
+private:
+  enum class SinkKind { Stream, File, Descriptor };
+  enum class Notation { General, Fixed, Scientific, Hex }; // As std::defaultfloat, fixed, scientific and hexfloat
+
+  static constexpr std::size_t block_size = 64 * 1024; // Written out whenever the buffer grows past this
+
+  SinkKind kind;
+  std::ostream* stream = nullptr;
+  std::FILE* file = nullptr;
+  int descriptor = -1;
+  std::string buffer;
+  Notation notation = Notation::General;
+  int precision = 6; // Ignored in hex notation, as by an ostream
+
+  void append_double(double value);
+  void append_integer(long long value);
+  void append_unsigned(unsigned long long value);
+  void write_out();
+
+public:
+  struct Descriptor
+  {
+    int fd;
+  };
+
+  explicit TextFormatter(std::ostream& sink); // Throws std::invalid_argument for stream state it cannot reproduce
+  explicit TextFormatter(std::FILE* sink);
+  explicit TextFormatter(Descriptor sink); // Eg TextFormatter(TextFormatter::Descriptor{1}) for stdout
+  TextFormatter(const TextFormatter&) = delete;
+  TextFormatter& operator=(const TextFormatter&) = delete;
+  ~TextFormatter(); // Flushes
+
+  // As std::fixed<<std::setprecision(digits) on a stream
+  TextFormatter& fixed(int digits)
+  {
+    notation = Notation::Fixed;
+    precision = digits;
+    return *this;
+  }
+
+  TextFormatter& operator<<(std::string_view text)
+  {
+    buffer.append(text.data(), text.size());
+    if(buffer.size() >= block_size)
+    {
+      write_out();
+    }
+    return *this;
+  }
+
+  TextFormatter& operator<<(const char* text) { return *this<<std::string_view(text); }
+  TextFormatter& operator<<(const std::string& text) { return *this<<std::string_view(text); }
+
+  TextFormatter& operator<<(char c)
+  {
+    buffer.push_back(c);
+    return *this;
+  }
+
+  TextFormatter& operator<<(double value)
+  {
+    append_double(value);
+    return *this;
+  }
+
+  template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, char> && !std::is_same_v<Integer, bool>>>
+  TextFormatter& operator<<(Integer value)
+  {
+    if constexpr(std::is_signed_v<Integer>)
+    {
+      append_integer(value);
+    }
+    else
+    {
+      append_unsigned(value);
+    }
+    return *this;
+  }
+
+  void flush(); // Writes out what is buffered and, for a stream sink, hands back the number format state
+};
+
+#endif // TEXT_FORMATTER_H
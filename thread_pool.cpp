@@ -0,0 +1,141 @@
+#include "thread_pool.h"
+#include <utility>
+
+namespace
+{
+  thread_local const ThreadPool* current_pool = nullptr;
+  thread_local std::size_t current_queue = 0;
+}
+
+ThreadPool::ThreadPool(std::size_t thread_count)
+{
+  thread_count = std::max<std::size_t>(thread_count, 1);
+  for(std::size_t i = 0; i < thread_count; ++i)
+  {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for(std::size_t i = 0; i < thread_count; ++i)
+  {
+    threads.emplace_back(&ThreadPool::worker_loop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+std::size_t ThreadPool::home_queue() const
+{
+  if(current_pool == this)
+  {
+    return current_queue;
+  }
+  return next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+  Queue& queue = *queues[home_queue()];
+  pending.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  queued.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex); // Orders the push before a sleeping worker re-checks 'queued'
+  }
+  wake.notify_one();
+}
+
+bool ThreadPool::run_one(std::size_t home)
+{
+  std::function<void()> task;
+  for(std::size_t attempt = 0; attempt < queues.size() && !task; ++attempt)
+  {
+    Queue& queue = *queues[(home + attempt) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(!queue.tasks.empty())
+    {
+      if(attempt == 0)
+      { // Own deque: newest first
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      }
+      else
+      { // Steal the oldest
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+    }
+  }
+  if(!task)
+  {
+    return false;
+  }
+
+  queued.fetch_sub(1);
+  try
+  {
+    task();
+  }
+  catch(...)
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    first_error = first_error ? first_error : std::current_exception();
+  }
+  if(pending.fetch_sub(1) == 1)
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    idle.notify_all();
+  }
+  return true;
+}
+
+void ThreadPool::worker_loop(std::size_t index)
+{
+  current_pool = this;
+  current_queue = index;
+  while(true)
+  {
+    if(run_one(index))
+    {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    wake.wait(lock, [this]{ return stopping || queued.load() > 0; });
+    if(stopping && queued.load() == 0)
+    {
+      return;
+    }
+  }
+}
+
+void ThreadPool::wait()
+{
+  std::size_t home = home_queue();
+  while(pending.load() > 0)
+  {
+    if(!run_one(home))
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex);
+      idle.wait(lock, [this]{ return pending.load() == 0 || queued.load() > 0; });
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(wake_mutex);
+  if(first_error)
+  {
+    std::exception_ptr error = std::exchange(first_error, nullptr);
+    std::rethrow_exception(error);
+  }
+}
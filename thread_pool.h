@@ -0,0 +1,94 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker runs its newest task first (LIFO, cache-warm)
+// and when it runs dry steals the oldest task of another worker (FIFO, usually the largest remaining chunk).
+// Threads waiting in parallel_for help run tasks instead of blocking, so tasks may themselves call parallel_for.
+class ThreadPool
+{
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> threads;
+  std::mutex wake_mutex;
+  std::condition_variable wake; // Signalled when a task is queued or the pool stops
+  std::condition_variable idle; // Signalled when 'pending' drops to zero
+  std::atomic<std::size_t> queued{0}; // Tasks waiting in a deque
+  std::atomic<std::size_t> pending{0}; // Tasks submitted but not finished
+  mutable std::atomic<std::size_t> next_queue{0}; // Round robin target for tasks submitted from outside the pool
+  std::exception_ptr first_error;
+  bool stopping = false;
+
+  std::size_t home_queue() const; // The calling worker's own deque, or a round-robin pick for other threads
+  bool run_one(std::size_t home); // Runs one task from 'home' or, failing that, stolen from another deque
+  void worker_loop(std::size_t index);
+
+public:
+  explicit ThreadPool(std::size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool(); // Finishes queued tasks, then joins the workers
+
+  std::size_t size() const { return threads.size(); }
+
+  void submit(std::function<void()> task);
+  void wait(); // Until every submitted task has finished, rethrowing the first exception one threw; not from inside a task
+
+  // Calls body(begin, end) over [0, count) in chunks of at most 'grain' indices and returns once all have run
+  template<typename Body>
+  void parallel_for(std::size_t count, std::size_t grain, Body body)
+  {
+    grain = std::max<std::size_t>(grain, 1);
+    std::atomic<std::size_t> remaining{(count + grain - 1) / grain};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    for(std::size_t begin = 0; begin < count; begin += grain)
+    {
+      std::size_t end = std::min(count, begin + grain);
+      submit([&, begin, end]()
+      {
+        try
+        {
+          body(begin, end);
+        }
+        catch(...)
+        {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          error = error ? error : std::current_exception();
+        }
+        remaining.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    std::size_t home = home_queue();
+    while(remaining.load(std::memory_order_acquire) > 0)
+    {
+      if(!run_one(home))
+      {
+        std::this_thread::yield(); // Our last chunks are running on other workers
+      }
+    }
+    if(error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+#endif // THREAD_POOL_H